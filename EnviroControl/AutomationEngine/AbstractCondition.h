@@ -1,7 +1,15 @@
 #pragma once
 
+#include "HistoryView.h"
+#include "SampleTime.h"
+
 #include <QtCore/QString>
 
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
 struct WeatherData;
 struct IndoorData;
 
@@ -51,6 +59,109 @@ inline QString conditionOperatorToString(ConditionOperator op)
 	}
 }
 
+// Sensor value checked by a condition, resolved from its name once, when the rules are loaded
+enum class SensorField
+{
+	Unknown,
+	// WeatherData, numeric
+	OutdoorTemp,
+	WindSpeed,
+	Daylight,
+	SunSouth,
+	SunEast,
+	SunWest,
+	// WeatherData, boolean
+	IsRaining,
+	IsTwighlight,
+	// IndoorData, numeric
+	IndoorTemp,
+	IndoorHumidity
+};
+
+inline SensorField stringToSensorField(const QString& str)
+{
+	if (str == "outdoor_temp") return SensorField::OutdoorTemp;
+	if (str == "wind_speed") return SensorField::WindSpeed;
+	if (str == "daylight") return SensorField::Daylight;
+	if (str == "sun_south") return SensorField::SunSouth;
+	if (str == "sun_east") return SensorField::SunEast;
+	if (str == "sun_west") return SensorField::SunWest;
+	if (str == "is_raining") return SensorField::IsRaining;
+	if (str == "is_twighlight") return SensorField::IsTwighlight;
+	if (str == "indoor_temp") return SensorField::IndoorTemp;
+	if (str == "indoor_humidity") return SensorField::IndoorHumidity;
+	return SensorField::Unknown;
+}
+
+inline QString sensorFieldToString(SensorField field)
+{
+	switch (field)
+	{
+	case SensorField::OutdoorTemp: return "outdoor_temp";
+	case SensorField::WindSpeed: return "wind_speed";
+	case SensorField::Daylight: return "daylight";
+	case SensorField::SunSouth: return "sun_south";
+	case SensorField::SunEast: return "sun_east";
+	case SensorField::SunWest: return "sun_west";
+	case SensorField::IsRaining: return "is_raining";
+	case SensorField::IsTwighlight: return "is_twighlight";
+	case SensorField::IndoorTemp: return "indoor_temp";
+	case SensorField::IndoorHumidity: return "indoor_humidity";
+	default: return "unknown";
+	}
+}
+
+inline SensorDataSource sensorFieldSource(SensorField field)
+{
+	switch (field)
+	{
+	case SensorField::Unknown: return SensorDataSource::Unknown;
+	case SensorField::IndoorTemp:
+	case SensorField::IndoorHumidity: return SensorDataSource::IndoorData;
+	default: return SensorDataSource::WeatherData;
+	}
+}
+
+inline bool isBooleanSensorField(SensorField field)
+{
+	return field == SensorField::IsRaining || field == SensorField::IsTwighlight;
+}
+
+// Field by name, Unknown if it does not exist for the source or is not of the expected kind
+inline SensorField resolveSensorField(SensorDataSource source, const QString& name, bool boolean)
+{
+	const SensorField field = stringToSensorField(name);
+	if (sensorFieldSource(field) != source || isBooleanSensorField(field) != boolean)
+		return SensorField::Unknown;
+	return field;
+}
+
+// One bit per SensorField, the fields a condition (or a rule) depends on
+using SensorFieldMask = uint32_t;
+
+inline SensorFieldMask sensorFieldBit(SensorField field)
+{
+	if (field == SensorField::Unknown)
+		return 0;
+	return SensorFieldMask(1) << static_cast<int>(field);
+}
+
+// All fields delivered by a sample of the source
+inline SensorFieldMask sensorSourceFields(SensorDataSource source)
+{
+	SensorFieldMask mask = 0;
+	for (int i = static_cast<int>(SensorField::OutdoorTemp); i <= static_cast<int>(SensorField::IndoorHumidity); ++i)
+	{
+		if (sensorFieldSource(static_cast<SensorField>(i)) == source)
+			mask |= sensorFieldBit(static_cast<SensorField>(i));
+	}
+	return mask;
+}
+
+/*
+* Conditions resolve their field in the constructor, evaluating does no string comparisons and no allocations.
+* A condition with an unknown field is never met (RuleSet rejects such conditions when loading).
+*/
 class AbstractCondition
 {
 public:
@@ -60,9 +171,14 @@ public:
 		NumericThreshold,
 		BooleanState,
 		NumericTimeDuration,
-		BooleanTimeDuration
+		BooleanTimeDuration,
+		Group
 	};
 
+	// Relative evaluation costs, groups order their children by them
+	static constexpr int SAMPLE_COST = 1;   // Looks at the newest sample
+	static constexpr int DURATION_COST = 8; // Walks the new samples and keeps a window
+
 	AbstractCondition(Type type) : _type(type)
 	{
 	};
@@ -73,7 +189,28 @@ public:
 		return _type;
 	}
 
-	virtual bool evaluate(const std::vector<WeatherData>& weather_history, const std::vector<IndoorData>& indoor_history) const = 0;
+	virtual bool evaluate(HistoryView<WeatherData> weather_history, HistoryView<IndoorData> indoor_history) const = 0;
+
+	// Fields the result depends on, used by the RuleScheduler to find the rules affected by a new sample
+	virtual SensorFieldMask fields() const = 0;
+
+	// True if the result can change with a new sample, even though no value changed (duration conditions)
+	virtual bool isTimeBased() const
+	{
+		return false;
+	}
+
+	// Fields whose samples can change the result without a value change. Only the fields of the duration
+	// conditions, a group mixing them with other conditions does not make the other fields time based.
+	virtual SensorFieldMask timeFields() const
+	{
+		return isTimeBased() ? fields() : 0;
+	}
+
+	virtual int cost() const
+	{
+		return SAMPLE_COST;
+	}
 
 protected:
 	Type _type;
@@ -84,11 +221,12 @@ class NumericThresholdCondition : public AbstractCondition
 public:
 	NumericThresholdCondition(SensorDataSource source, const QString& field, ConditionOperator op, double value);
 
-	bool evaluate(const std::vector<WeatherData>& weather_history, const std::vector<IndoorData>& indoor_history) const override;
+	bool evaluate(HistoryView<WeatherData> weather_history, HistoryView<IndoorData> indoor_history) const override;
+	SensorFieldMask fields() const override;
 
 private:
 	SensorDataSource _source;
-	QString _field;
+	SensorField _field;
 	ConditionOperator _op;
 	double _value;
 };
@@ -98,27 +236,53 @@ class BooleanStateCondition : public AbstractCondition
 public:
 	BooleanStateCondition(SensorDataSource source, const QString& field, bool expected_value);
 
-	bool evaluate(const std::vector<WeatherData>& weather_history, const std::vector<IndoorData>& indoor_history) const override;
+	bool evaluate(HistoryView<WeatherData> weather_history, HistoryView<IndoorData> indoor_history) const override;
+	SensorFieldMask fields() const override;
 
 private:
 	SensorDataSource _source;
-	QString _field;
+	SensorField _field;
 	bool _expected_value;
 };
 
+/*
+* Incremental state of a duration condition: "every sample of the last duration_secs met the condition".
+* Only the newest violation is kept, so evaluating is O(1) regardless of the window length. On every evaluation
+* the samples that arrived since the last one are added (the front of the history, newest first), so each sample
+* is looked at once. The state is rebuilt from the whole history, if it does not continue the seen samples
+* (older samples were inserted at the back, e.g. by the history warm-up, or a different history is passed).
+*/
+class DurationWindow
+{
+public:
+	template <typename T, typename Predicate>
+	bool evaluate(const HistoryView<T>& history, int duration_secs, Predicate condition_met);
+
+private:
+	void reset();
+
+	std::optional<SampleTime> _oldest;         // Oldest sample seen
+	std::optional<SampleTime> _newest;         // Newest sample seen
+	std::optional<SampleTime> _last_violation; // Newest sample, that did not meet the condition
+};
+
 class NumericTimeDurationCondition : public AbstractCondition
 {
 public:
 	NumericTimeDurationCondition(SensorDataSource source, const QString& field, ConditionOperator op, double value, int duration_secs);
 
-	bool evaluate(const std::vector<WeatherData>& weather_history, const std::vector<IndoorData>& indoor_history) const override;
+	bool evaluate(HistoryView<WeatherData> weather_history, HistoryView<IndoorData> indoor_history) const override;
+	SensorFieldMask fields() const override;
+	bool isTimeBased() const override;
+	int cost() const override;
 
 private:
 	SensorDataSource _source;
-	QString _field;
+	SensorField _field;
 	ConditionOperator _op;
 	double _value;
 	int _duration_secs;
+	mutable DurationWindow _window;
 };
 
 class BooleanTimeDurationCondition : public AbstractCondition
@@ -126,13 +290,81 @@ class BooleanTimeDurationCondition : public AbstractCondition
 public:
 	BooleanTimeDurationCondition(SensorDataSource source, const QString& field, bool expected_value, int duration_secs);
 
-	bool evaluate(const std::vector<WeatherData>& weather_history, const std::vector<IndoorData>& indoor_history) const override;
+	bool evaluate(HistoryView<WeatherData> weather_history, HistoryView<IndoorData> indoor_history) const override;
+	SensorFieldMask fields() const override;
+	bool isTimeBased() const override;
+	int cost() const override;
 
 private:
 	SensorDataSource _source;
-	QString _field;
+	SensorField _field;
 	bool _expected_value;
 	int _duration_secs;
+	mutable DurationWindow _window;
+};
+
+/*
+* all / any / not over child conditions, evaluated with short-circuiting. The children are kept in the order,
+* that is expected to decide the group fastest: by cost per chance of deciding it, so cheap conditions run
+* before duration conditions, and in an all group the rarely met conditions come first (in an any group the
+* often met ones). The chance is the observed rate, how often a child was met, re-ordered every REORDER_INTERVAL
+* evaluations. Children skipped by the short-circuit are not counted, so the rates are an estimate.
+* Skipping duration conditions is safe, they catch up with the samples they missed on the next evaluation.
+*/
+class ConditionGroup : public AbstractCondition
+{
+public:
+	enum Operator
+	{
+		All,
+		Any,
+		Not // Exactly one child
+	};
+
+	static constexpr quint64 REORDER_INTERVAL = 32;
+
+	struct ChildStatistics
+	{
+		size_t index = 0; // Position in the definition
+		int cost = 0;
+		quint64 evaluations = 0;
+		quint64 met = 0;
+	};
+
+	struct Statistics
+	{
+		quint64 evaluations = 0;
+		quint64 reorders = 0;                 // Re-orderings, that changed the order
+		std::vector<ChildStatistics> children; // Current evaluation order
+	};
+
+	ConditionGroup(Operator op, std::vector<std::unique_ptr<AbstractCondition>> children);
+
+	bool evaluate(HistoryView<WeatherData> weather_history, HistoryView<IndoorData> indoor_history) const override;
+	SensorFieldMask fields() const override;
+	bool isTimeBased() const override;
+	SensorFieldMask timeFields() const override;
+	int cost() const override;
+
+	Operator op() const;
+	Statistics statistics() const;
+
+private:
+	struct Child
+	{
+		std::unique_ptr<AbstractCondition> condition;
+		size_t index = 0;
+		quint64 evaluations = 0;
+		quint64 met = 0;
+		double score = 0.0;
+	};
+
+	void reorder() const;
+
+	Operator _op;
+	mutable std::vector<Child> _children;
+	mutable quint64 _evaluations = 0;
+	mutable quint64 _reorders = 0;
 };
 
-}
\ No newline at end of file
+}
@@ -2,15 +2,17 @@
 
 #include "ConfigParser.h"
 #include "IndoorStation.h"
+#include "PackedWeatherSample.h"
+#include "RuleScheduler.h"
 #include "RuleSet.h"
+#include "TimeRingBuffer.h"
 #include "WeatherData.h"
 
+#include <QtCore/QElapsedTimer>
 #include <QtCore/QObject>
 #include <QtCore/QTimer>
 #include <QtCore/QPointer>
 
-#include <deque>
-
 class QThread;
 
 namespace Device
@@ -27,14 +29,18 @@ namespace Automation
 //  load rules from RulesEngine
 //  get data from Stations
 //  send desired states to DeviceStateManager (other thread)
-//  rules are evaluated every minute -> task is sent to DeviceStateManager -> forgets about it
-//  rule evaluation does not happen here, just a call to RulesEngine::evaluateRules(WeatherData)
-//    -> returns a list of tasks
-//  internal timer to evaluate rules every minute
+//  rules are evaluated when a sample affects them (see RuleScheduler), at most every MIN_EVALUATION_INTERVAL_MS
+//    -> states are sent to DeviceStateManager -> forgets about it
+//  fallback timer re-evaluates all rules every FALLBACK_EVALUATION_INTERVAL_MS
 class AutomationEngine : public QObject
 {
 	Q_OBJECT
 public:
+	// A burst of samples is evaluated at once, at most every MIN_EVALUATION_INTERVAL_MS
+	static constexpr int MIN_EVALUATION_INTERVAL_MS = 500;
+	// Safety net, also re-sends the states while nothing changes
+	static constexpr int FALLBACK_EVALUATION_INTERVAL_MS = 60 * 1000;
+
 	explicit AutomationEngine(const Cfg::DeviceConfigList& cfg, QObject* parent = nullptr);
 	~AutomationEngine();
 
@@ -43,6 +49,14 @@ public:
 	void setAutoMode();
 	bool isInAutoMode() const;
 
+	// The readers wake onSamplesAvailable() in the GUI thread
+	void setWeatherSampleReader(std::shared_ptr<SampleChannel<WeatherData>::Reader> reader);
+	void setIndoorSampleReader(std::shared_ptr<SampleChannel<IndoorData>::Reader> reader);
+
+	// Rules are not evaluated until onWeatherHistoryLoaded() seeded the history, or max_wait_sec passed
+	void waitForWeatherHistory(int max_wait_sec);
+	int historyLengthSec() const;
+
 Q_SIGNALS:
 	void deviceMovementStarted(const Device::DeviceState& state);
 	void deviceMovementFinished(const Device::DeviceState& state);
@@ -54,24 +68,35 @@ Q_SIGNALS:
 
 public Q_SLOTS:
 	void onWeatherStationData(const WeatherData& weather_data);
+	void onWeatherHistoryLoaded(const WeatherDataBatch& history);
 	void onIndoorStationData(const IndoorData& indoor_data);
 	void onManualDeviceOpenRequest(const QString& device_id);
 	void onManualDeviceCloseRequest(const QString& device_id);
 	void onAbort();
 	void onError(const QString& error);
 	void onAutomationModeChangeRequest(bool auto_mode);
+	void onSamplesAvailable();
 
 private:
-	void onCalcTimeout();
+	void onFallbackTimeout();
+	void scheduleEvaluation();
+	void evaluateRules();
+	void drainSampleReaders();
 	void initStateManagerThread();
 
 private:
-	QPointer<QTimer> _calc_timer = nullptr;
-	std::deque<WeatherData> _weather_data_history;
-	std::deque<IndoorData> _indoor_data_history;
+	QPointer<QTimer> _calc_timer = nullptr;       // Fallback, re-evaluates all rules
+	QPointer<QTimer> _evaluation_timer = nullptr; // Single shot, delays an evaluation to the minimum interval
+	QElapsedTimer _last_evaluation;
 	int _data_history_secs = 3600;
+	TimeRingBuffer<PackedWeatherSample> _weather_data_history; // Newest at index 0
+	TimeRingBuffer<IndoorData> _indoor_data_history;
+	std::shared_ptr<SampleChannel<WeatherData>::Reader> _weather_reader;
+	std::shared_ptr<SampleChannel<IndoorData>::Reader> _indoor_reader;
+	bool _waiting_for_history = false;
 	Cfg::DeviceConfigList _devices_cfg;
 	RuleSet _rule_set;
+	RuleScheduler _scheduler;
 
 	// State manager thread
 	QThread* _state_manager_thread = nullptr;
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+namespace Automation
+{
+
+namespace Detail
+{
+// Stored elements are either T, or a packed form with unpack() -> T (e.g. PackedWeatherSample)
+template<typename T, typename Stored, typename = void>
+struct IsHistoryElement : std::is_same<T, Stored>
+{
+};
+
+template<typename T, typename Stored>
+struct IsHistoryElement<T, Stored, std::void_t<decltype(std::declval<const Stored&>().unpack())>> :
+	std::is_same<T, decltype(std::declval<const Stored&>().unpack())>
+{
+};
+}
+
+/*
+* Non-owning, read-only view of a sensor history, newest sample first (index 0).
+* Conditions evaluate the engine's history store in place, instead of a copy per evaluation. Any container with
+* size() and operator[] can be viewed, packed elements are unpacked on access. Evaluating only touches a few
+* samples (the front, and the new samples for duration conditions), so unpacking on access is cheaper than
+* converting the whole history.
+*
+* The view is only valid as long as the container is alive and unchanged.
+*/
+template<typename T>
+class HistoryView
+{
+public:
+	HistoryView() = default;
+
+	// Implicit, so std::vector<T> histories (e.g. in tests) can be passed as before
+	template<typename Container, typename = std::enable_if_t<Detail::IsHistoryElement<T, typename Container::value_type>::value>>
+	HistoryView(const Container& history) :
+		_history(&history), _size(history.size()), _at(&elementAt<Container>)
+	{
+	}
+
+	size_t size() const
+	{
+		return _size;
+	}
+
+	bool empty() const
+	{
+		return _size == 0;
+	}
+
+	T operator[](size_t index) const
+	{
+		return _at(_history, index);
+	}
+
+	T front() const
+	{
+		return _at(_history, 0);
+	}
+
+	T back() const
+	{
+		return _at(_history, _size - 1);
+	}
+
+private:
+	template<typename Container>
+	static T elementAt(const void* history, size_t index)
+	{
+		const auto& element = (*static_cast<const Container*>(history))[index];
+		if constexpr (std::is_same_v<T, typename Container::value_type>)
+			return element;
+		else
+			return element.unpack();
+	}
+
+	const void* _history = nullptr;
+	size_t _size = 0;
+	T (*_at)(const void*, size_t) = nullptr;
+};
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "AbstractCondition.h"
+#include "DeviceState.h"
+
+#include <QtCore/QString>
+
+#include <array>
+#include <vector>
+
+struct WeatherData;
+struct IndoorData;
+
+namespace Automation
+{
+class RuleSet;
+
+/*
+* Decides which rules have to be evaluated again after new samples. The rules are indexed by the fields their
+* conditions depend on: a sample marks the rules reading a changed field, rules with duration conditions on any
+* new sample of the fields of those conditions (the window moves on, even if the value did not change). All other rules keep their
+* last result.
+*
+* calculateDeviceStates() combines the results by priority, like RulesProcessor::calculateDeviceStates(). Rules of
+* devices, that are already decided by a rule of higher priority, are not evaluated and stay marked.
+*/
+class RuleScheduler
+{
+public:
+	struct Statistics
+	{
+		quint64 evaluations = 0;     // calculateDeviceStates() calls
+		quint64 evaluated_rules = 0; // Rules evaluated
+		quint64 cached_rules = 0;    // Rules, whose last result was reused
+	};
+
+	// Rebuilds the index, all rules are evaluated on the next calculation. Has to be called after the rules changed.
+	void setRules(const RuleSet& rule_set);
+
+	void markSample(SensorDataSource source, SensorFieldMask changed_fields);
+	void markAllDirty();
+
+	// True if a sample affected a rule since the last calculation
+	bool hasPendingRules() const;
+
+	Device::DeviceStates calculateDeviceStates(const RuleSet& rule_set, const std::vector<QString>& device_ids,
+		HistoryView<WeatherData> weather_history, HistoryView<IndoorData> indoor_history);
+
+	const Statistics& statistics() const;
+
+private:
+	void markDirty(const std::vector<size_t>& rule_indices);
+
+	static constexpr size_t FIELD_COUNT = static_cast<size_t>(SensorField::IndoorHumidity) + 1;
+
+	std::array<std::vector<size_t>, FIELD_COUNT> _rules_by_field;      // Rules reading the field
+	std::array<std::vector<size_t>, FIELD_COUNT> _time_rules_by_field; // Rules with a duration condition on the field
+	std::vector<char> _dirty;   // Per rule, in priority order
+	std::vector<char> _results; // Per rule, last result
+	bool _pending = false;
+	Statistics _statistics;
+};
+}
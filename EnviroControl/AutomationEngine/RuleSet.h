@@ -27,6 +27,7 @@ public:
 
 private:
 	std::unique_ptr<AbstractCondition> parseCondition(const QJsonObject& json) const;
+	std::unique_ptr<AbstractCondition> parseConditionGroup(const QJsonObject& json, const QString& type_str) const;
 	void sortRuleByPriority();
 
 	std::vector<Rule> _rules;
@@ -25,7 +25,7 @@ namespace Automation
 class RulesProcessor
 {
 public:
-	static bool evaluateRule(const Rule& rule, const std::vector<WeatherData>& weather_history, const std::vector<IndoorData>& indoor_history);
-	static Device::DeviceStates calculateDeviceStates(const RuleSet& rule_set, std::vector<QString> device_ids, const std::vector<WeatherData>& weather_history, const std::vector<IndoorData>& indoor_history);
+	static bool evaluateRule(const Rule& rule, HistoryView<WeatherData> weather_history, HistoryView<IndoorData> indoor_history);
+	static Device::DeviceStates calculateDeviceStates(const RuleSet& rule_set, std::vector<QString> device_ids, HistoryView<WeatherData> weather_history, HistoryView<IndoorData> indoor_history);
 };
 }
\ No newline at end of file
@@ -4,67 +4,58 @@
 #include "WeatherData.h"
 #include "IndoorStation.h"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
 namespace Automation
 {
 
 namespace
 {
-template<typename T>
-std::optional<double> getNumericFieldValue(const T& data, const QString& field)
+double getNumericFieldValue(const WeatherData& data, SensorField field)
 {
-	// Check WeatherData fields
-	if constexpr (std::is_same_v<T, WeatherData>)
+	switch (field)
 	{
-		if (field == "outdoor_temp")
-			return data.temperature;
-		if (field == "wind_speed")
-			return data.wind;
-		if (field == "daylight")
-			return data.daylight;
-		if (field == "sun_south")
-			return data.sun_south;
-		if (field == "sun_east")
-			return data.sun_east;
-		if (field == "sun_west")
-			return data.sun_west;
+	case SensorField::OutdoorTemp: return data.temperature;
+	case SensorField::WindSpeed: return data.wind;
+	case SensorField::Daylight: return data.daylight;
+	case SensorField::SunSouth: return data.sun_south;
+	case SensorField::SunEast: return data.sun_east;
+	case SensorField::SunWest: return data.sun_west;
+	default: return std::numeric_limits<double>::quiet_NaN();
 	}
+}
 
-	// Check IndoorData fields
-	if constexpr (std::is_same_v<T, IndoorData>)
+double getNumericFieldValue(const IndoorData& data, SensorField field)
+{
+	switch (field)
 	{
-		if (field == "indoor_temp")
-			return data.temperature;
-		if (field == "indoor_humidity")
-			return data.humidity;
+	case SensorField::IndoorTemp: return data.temperature;
+	case SensorField::IndoorHumidity: return data.humidity;
+	default: return std::numeric_limits<double>::quiet_NaN();
 	}
-
-	qWarning() << "Unknown field for data type " << typeid(T).name() << ": " << field;
-	return {};
 }
 
-template<typename T>
-std::optional<bool> getBooleanFieldValue(const T& data, const QString& field)
+bool getBooleanFieldValue(const WeatherData& data, SensorField field)
 {
-	// Check WeatherData fields
-	if constexpr (std::is_same_v<T, WeatherData>)
+	switch (field)
 	{
-		if (field == "is_raining")
-			return data.rain;
-		if (field == "is_twighlight")
-			return data.twighlight;
+	case SensorField::IsRaining: return data.rain;
+	case SensorField::IsTwighlight: return data.twighlight;
+	default: return false;
 	}
+}
 
-	qWarning() << "Unknown boolean field for data type " << typeid(T).name() << ": " << field;
-	return {};
+bool getBooleanFieldValue(const IndoorData&, SensorField)
+{
+	return false; // No boolean indoor fields
 }
 
-bool evaluateNumericCondition(ConditionOperator op, std::optional<double> actual_value, double expected_value)
+bool evaluateNumericCondition(ConditionOperator op, double actual_value, double expected_value)
 {
-	if (!actual_value.has_value())
-	{
-		qWarning() << "evaluateNumericCondition called with empty optional";
+	if (std::isnan(actual_value))
 		return false;
-	}
 
 	switch (op)
 	{
@@ -73,159 +64,332 @@ bool evaluateNumericCondition(ConditionOperator op, std::optional<double> actual
 	case ConditionOperator::LessThan:
 		return actual_value < expected_value;
 	case ConditionOperator::EqualTo:
-		return qFuzzyCompare(*actual_value, expected_value);
+		return qFuzzyCompare(actual_value, expected_value);
 	case ConditionOperator::NotEqualTo:
-		return !qFuzzyCompare(*actual_value, expected_value);
+		return !qFuzzyCompare(actual_value, expected_value);
 	case ConditionOperator::GreaterThanOrEqualTo:
 		return actual_value >= expected_value;
 	case ConditionOperator::LessThanOrEqualTo:
 		return actual_value <= expected_value;
-
 	default:
-		qWarning() << "Unknown operator for evaluateNumericCondition: " << static_cast<int>(op);
-		return false;
+		return false; // Rejected when the rules are loaded
 	}
 }
 
-bool evaluateBooleanCondition(bool actual_value, bool expected_value)
+// Resolves the field once, an unknown field is reported here and not on every evaluation
+SensorField resolveConditionField(const char* condition_name, SensorDataSource source, const QString& field, bool boolean)
 {
-	return actual_value == expected_value;
+	const SensorField resolved = resolveSensorField(source, field, boolean);
+	if (resolved == SensorField::Unknown)
+		qWarning() << condition_name << "- unknown field for the sensor type:" << field << "source:" << static_cast<int>(source);
+	return resolved;
 }
 
-template <typename T>
-bool evaluateInHistoryDuration(const std::vector<T>& history, int duration_secs, std::function<bool(const T&)> evaluate_func)
+} // namespace
+
+template <typename T, typename Predicate>
+bool DurationWindow::evaluate(const HistoryView<T>& history, int duration_secs, Predicate condition_met)
 {
-	const QDateTime newest_timestamp = history.front().timestamp;
+	if (history.empty())
+		return false;
 
-	// Check if the history covers the required duration
-	if (!history.empty())
+	const SampleTime newest = history.front().timestamp;
+	const SampleTime oldest = history.back().timestamp;
+
+	// Samples at the front, that were not seen yet
+	size_t new_count = 0;
+	if (!_newest || oldest < *_oldest || newest < *_newest)
 	{
-		int history_duration_secs = history.back().timestamp.secsTo(newest_timestamp);
-		if (history_duration_secs < duration_secs)
-		{
-			qDebug() << "History does not cover the required duration: " << history_duration_secs << " < " << duration_secs;
-			return false;
-		}
+		reset();
+		new_count = history.size();
 	}
-
-	bool all_conditions_met = true;
-	for (size_t i = 0; i < history.size(); ++i)
+	else
 	{
-		const T& data_point = history.at(i);
-		int age_seconds = data_point.timestamp.secsTo(newest_timestamp);
-
-		if (age_seconds > duration_secs)
-			break; // This point is too old, and all subsequent ones must be old too
+		while (new_count < history.size() && *_newest < history[new_count].timestamp)
+			++new_count;
+	}
 
-		if (!evaluate_func(data_point))
-			return false;
+	// Oldest first
+	for (size_t i = new_count; i > 0; --i)
+	{
+		const T data_point = history[i - 1];
+		if (!_oldest)
+			_oldest = data_point.timestamp;
+		_newest = data_point.timestamp;
+		if (!condition_met(data_point))
+			_last_violation = data_point.timestamp;
+	}
 
-	} // End of for loop of data points
+	// Check if the history covers the required duration
+	const qint64 history_duration_secs = oldest.secsTo(newest);
+	if (history_duration_secs < duration_secs)
+	{
+		qDebug() << "History does not cover the required duration: " << history_duration_secs << " < " << duration_secs;
+		return false;
+	}
 
-	return all_conditions_met;
+	// Violations older than the duration do not count
+	return !_last_violation || _last_violation->secsTo(newest) > duration_secs;
 }
 
-} // namespace
+void DurationWindow::reset()
+{
+	_oldest.reset();
+	_newest.reset();
+	_last_violation.reset();
+}
 
 NumericThresholdCondition::NumericThresholdCondition(SensorDataSource source, const QString& field, ConditionOperator op, double value) :
-	AbstractCondition(NumericThreshold), _source(source), _field(field), _op(op), _value(value)
+	AbstractCondition(NumericThreshold), _source(source), _field(resolveConditionField("NumericThresholdCondition", source, field, false)),
+	_op(op), _value(value)
 {
 }
 
-bool NumericThresholdCondition::evaluate(const std::vector<WeatherData>& weather_history, const std::vector<IndoorData>& indoor_history) const
+bool NumericThresholdCondition::evaluate(HistoryView<WeatherData> weather_history, HistoryView<IndoorData> indoor_history) const
 {
-	std::optional<double> value_opt = {};
 	if (_source == SensorDataSource::WeatherData && !weather_history.empty())
-		value_opt = getNumericFieldValue(weather_history.front(), _field);
-	else if (_source == SensorDataSource::IndoorData && !indoor_history.empty())
-		value_opt = getNumericFieldValue(indoor_history.front(), _field);
+		return evaluateNumericCondition(_op, getNumericFieldValue(weather_history.front(), _field), _value);
+	if (_source == SensorDataSource::IndoorData && !indoor_history.empty())
+		return evaluateNumericCondition(_op, getNumericFieldValue(indoor_history.front(), _field), _value);
 
-	return evaluateNumericCondition(_op, value_opt, _value);
+	return false;
+}
+
+SensorFieldMask NumericThresholdCondition::fields() const
+{
+	return sensorFieldBit(_field);
 }
 
 BooleanStateCondition::BooleanStateCondition(SensorDataSource source, const QString& field, bool expected_value) :
-	AbstractCondition(BooleanState), _source(source), _field(field), _expected_value(expected_value)
+	AbstractCondition(BooleanState), _source(source), _field(resolveConditionField("BooleanStateCondition", source, field, true)),
+	_expected_value(expected_value)
 {
 }
 
-bool BooleanStateCondition::evaluate(const std::vector<WeatherData>& weather_history, const std::vector<IndoorData>& indoor_history) const
+bool BooleanStateCondition::evaluate(HistoryView<WeatherData> weather_history, HistoryView<IndoorData> indoor_history) const
 {
-	std::optional<bool> value_opt = {};
+	if (_field == SensorField::Unknown)
+		return false;
+
 	if (_source == SensorDataSource::WeatherData && !weather_history.empty())
-		value_opt = getBooleanFieldValue(weather_history.front(), _field);
-	else if (_source == SensorDataSource::IndoorData && !indoor_history.empty())
-		value_opt = getBooleanFieldValue(indoor_history.front(), _field);
+		return getBooleanFieldValue(weather_history.front(), _field) == _expected_value;
+	if (_source == SensorDataSource::IndoorData && !indoor_history.empty())
+		return getBooleanFieldValue(indoor_history.front(), _field) == _expected_value;
 
-	if (!value_opt.has_value())
-	{
-		qWarning() << "Unknown source or empty history for BooleanStateCondition: " << static_cast<int>(_source);
-		return false;
-	}
+	return false;
+}
 
-	return value_opt.value() == _expected_value;
+SensorFieldMask BooleanStateCondition::fields() const
+{
+	return sensorFieldBit(_field);
 }
 
 NumericTimeDurationCondition::NumericTimeDurationCondition(SensorDataSource source, const QString& field, ConditionOperator op, double value, int duration_secs) :
-	AbstractCondition(NumericTimeDuration), _source(source), _field(field), _op(op), _value(value), _duration_secs(duration_secs)
+	AbstractCondition(NumericTimeDuration), _source(source), _field(resolveConditionField("NumericTimeDurationCondition", source, field, false)),
+	_op(op), _value(value), _duration_secs(duration_secs)
 {
 }
 
-bool NumericTimeDurationCondition::evaluate(const std::vector<WeatherData>& weather_history, const std::vector<IndoorData>& indoor_history) const
+bool NumericTimeDurationCondition::evaluate(HistoryView<WeatherData> weather_history, HistoryView<IndoorData> indoor_history) const
 {
-	if (_source == SensorDataSource::WeatherData && !weather_history.empty())
+	if (_source == SensorDataSource::WeatherData)
 	{
-		auto evaluate_func = [this](const WeatherData& weather_data_point) -> bool
+		return _window.evaluate(weather_history, _duration_secs, [this](const WeatherData& weather_data_point)
 			{
-				// Evaluate with the current value for the data point
-				auto value_opt = getNumericFieldValue(weather_data_point, _field);
-				return evaluateNumericCondition(_op, value_opt, _value);
-			};
-		return evaluateInHistoryDuration<WeatherData>(weather_history, _duration_secs, evaluate_func);
+				return evaluateNumericCondition(_op, getNumericFieldValue(weather_data_point, _field), _value);
+			});
 	}
-	else if (_source == SensorDataSource::IndoorData && !indoor_history.empty())
+	else if (_source == SensorDataSource::IndoorData)
 	{
-		auto evaluate_func = [&](IndoorData weather_data_point)
+		return _window.evaluate(indoor_history, _duration_secs, [this](const IndoorData& indoor_data_point)
 			{
-				auto value_opt = getNumericFieldValue(indoor_history.front(), _field);
-				return evaluateNumericCondition(_op, value_opt, _value);
-			};
-		return evaluateInHistoryDuration<IndoorData>(indoor_history, _duration_secs, evaluate_func);
+				return evaluateNumericCondition(_op, getNumericFieldValue(indoor_data_point, _field), _value);
+			});
 	}
 
 	qWarning() << "NumericTimeDurationCondition - undefined source";
 	return false;
 }
 
+SensorFieldMask NumericTimeDurationCondition::fields() const
+{
+	return sensorFieldBit(_field);
+}
+
+bool NumericTimeDurationCondition::isTimeBased() const
+{
+	return true;
+}
+
+int NumericTimeDurationCondition::cost() const
+{
+	return DURATION_COST;
+}
+
 BooleanTimeDurationCondition::BooleanTimeDurationCondition(SensorDataSource source, const QString& field, bool expected_value, int duration_secs) :
-	AbstractCondition(BooleanTimeDuration), _source(source), _field(field), _expected_value(expected_value), _duration_secs(duration_secs)
+	AbstractCondition(BooleanTimeDuration), _source(source), _field(resolveConditionField("BooleanTimeDurationCondition", source, field, true)),
+	_expected_value(expected_value), _duration_secs(duration_secs)
 {
 }
 
-bool BooleanTimeDurationCondition::evaluate(const std::vector<WeatherData>& weather_history, const std::vector<IndoorData>& indoor_history) const
+bool BooleanTimeDurationCondition::evaluate(HistoryView<WeatherData> weather_history, HistoryView<IndoorData> indoor_history) const
 {
-	if (_source == SensorDataSource::WeatherData && !weather_history.empty())
+	if (_field == SensorField::Unknown)
+		return false;
+
+	if (_source == SensorDataSource::WeatherData)
 	{
-		auto evaluate_func = [this](const WeatherData& weather_data_point) -> bool
+		return _window.evaluate(weather_history, _duration_secs, [this](const WeatherData& weather_data_point)
 			{
-				// Evaluate with the current value for the data point
-				auto value_opt = getBooleanFieldValue(weather_data_point, _field);
-				return value_opt == _expected_value;
-			};
-		return evaluateInHistoryDuration<WeatherData>(weather_history, _duration_secs, evaluate_func);
+				return getBooleanFieldValue(weather_data_point, _field) == _expected_value;
+			});
 	}
-	else if (_source == SensorDataSource::IndoorData && !indoor_history.empty())
+	else if (_source == SensorDataSource::IndoorData)
 	{
-		auto evaluate_func = [this](const IndoorData& weather_data_point) -> bool
+		return _window.evaluate(indoor_history, _duration_secs, [this](const IndoorData& indoor_data_point)
 			{
-				// Evaluate with the current value for the data point
-				auto value_opt = getBooleanFieldValue(weather_data_point, _field);
-				return value_opt == _expected_value;
-			};
-		return evaluateInHistoryDuration<IndoorData>(indoor_history, _duration_secs, evaluate_func);
+				return getBooleanFieldValue(indoor_data_point, _field) == _expected_value;
+			});
 	}
 
 	qWarning() << "BooleanTimeDurationCondition - undefined source";
 	return false;
 }
 
-}
\ No newline at end of file
+SensorFieldMask BooleanTimeDurationCondition::fields() const
+{
+	return sensorFieldBit(_field);
+}
+
+bool BooleanTimeDurationCondition::isTimeBased() const
+{
+	return true;
+}
+
+int BooleanTimeDurationCondition::cost() const
+{
+	return DURATION_COST;
+}
+
+ConditionGroup::ConditionGroup(Operator op, std::vector<std::unique_ptr<AbstractCondition>> children) :
+	AbstractCondition(Group), _op(op)
+{
+	for (auto& condition : children)
+	{
+		Child child;
+		child.index = _children.size();
+		child.condition = std::move(condition);
+		_children.push_back(std::move(child));
+	}
+
+	if (_op == Not && _children.size() != 1)
+		qWarning() << "ConditionGroup - 'not' needs exactly one condition, has" << _children.size();
+
+	// No observations yet, the cost alone decides
+	reorder();
+	_reorders = 0;
+}
+
+bool ConditionGroup::evaluate(HistoryView<WeatherData> weather_history, HistoryView<IndoorData> indoor_history) const
+{
+	if (_op == Not && _children.size() != 1)
+		return false;
+
+	++_evaluations;
+
+	// all stops at the first unmet child, any at the first met one
+	const bool deciding_result = _op == Any;
+	bool result = !deciding_result;
+	for (auto& child : _children)
+	{
+		const bool met = child.condition && child.condition->evaluate(weather_history, indoor_history);
+		++child.evaluations;
+		if (met)
+			++child.met;
+
+		if (met == deciding_result)
+		{
+			result = deciding_result;
+			break;
+		}
+	}
+
+	if (_op != Not && _evaluations % REORDER_INTERVAL == 0)
+		reorder();
+
+	return _op == Not ? !result : result;
+}
+
+void ConditionGroup::reorder() const
+{
+	for (auto& child : _children)
+	{
+		// Smoothed, so an unobserved child counts as 50:50 and a rate never gets 0
+		const double met_rate = (child.met + 1.0) / (child.evaluations + 2.0);
+		const double deciding_rate = _op == Any ? met_rate : 1.0 - met_rate;
+		const int cost = child.condition ? child.condition->cost() : SAMPLE_COST;
+		child.score = cost / deciding_rate;
+	}
+
+	const bool sorted = std::is_sorted(_children.begin(), _children.end(),
+		[](const Child& a, const Child& b) { return a.score < b.score; });
+	if (sorted)
+		return;
+
+	std::stable_sort(_children.begin(), _children.end(),
+		[](const Child& a, const Child& b) { return a.score < b.score; });
+	++_reorders;
+}
+
+SensorFieldMask ConditionGroup::fields() const
+{
+	SensorFieldMask mask = 0;
+	for (const auto& child : _children)
+	{
+		if (child.condition)
+			mask |= child.condition->fields();
+	}
+	return mask;
+}
+
+bool ConditionGroup::isTimeBased() const
+{
+	return std::any_of(_children.begin(), _children.end(),
+		[](const Child& child) { return child.condition && child.condition->isTimeBased(); });
+}
+
+SensorFieldMask ConditionGroup::timeFields() const
+{
+	SensorFieldMask mask = 0;
+	for (const auto& child : _children)
+	{
+		if (child.condition)
+			mask |= child.condition->timeFields();
+	}
+	return mask;
+}
+
+int ConditionGroup::cost() const
+{
+	int cost = 0;
+	for (const auto& child : _children)
+		cost += child.condition ? child.condition->cost() : SAMPLE_COST;
+	return cost;
+}
+
+ConditionGroup::Operator ConditionGroup::op() const
+{
+	return _op;
+}
+
+ConditionGroup::Statistics ConditionGroup::statistics() const
+{
+	Statistics statistics;
+	statistics.evaluations = _evaluations;
+	statistics.reorders = _reorders;
+	for (const auto& child : _children)
+		statistics.children.push_back({ child.index, child.condition ? child.condition->cost() : SAMPLE_COST, child.evaluations, child.met });
+	return statistics;
+}
+
+}
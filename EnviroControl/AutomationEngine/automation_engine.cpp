@@ -1,6 +1,5 @@
 #include "AutomationEngine.h"
 #include "DeviceStateManager.h"
-#include "RulesProcessor.h"
 
 #include <QtCore/QThread>
 
@@ -9,28 +8,55 @@ namespace Automation
 
 namespace
 {
-template<typename T>
-void addCircularBufferData(std::deque<T>& buffer, const T& new_data, int max_size_seconds)
-{
-	buffer.push_front(new_data);
+// Station samples arrive about once a second, the histories are preallocated with headroom for faster rates
+const int MAX_SAMPLES_PER_SEC = 4;
 
-	const QDateTime& newest_time = new_data.timestamp;
-	while (!buffer.empty())
-	{
-		const QDateTime& oldest_time = buffer.front().timestamp;
-			break;
+SensorFieldMask changedFields(const PackedWeatherSample& previous, const PackedWeatherSample& sample)
+{
+	SensorFieldMask changed = 0;
+	if (sample.temperature_cc != previous.temperature_cc)
+		changed |= sensorFieldBit(SensorField::OutdoorTemp);
+	if (sample.wind_cms != previous.wind_cms)
+		changed |= sensorFieldBit(SensorField::WindSpeed);
+	if (sample.daylight_dl != previous.daylight_dl)
+		changed |= sensorFieldBit(SensorField::Daylight);
+	if (sample.sun_south_dk != previous.sun_south_dk)
+		changed |= sensorFieldBit(SensorField::SunSouth);
+	if (sample.sun_east_dk != previous.sun_east_dk)
+		changed |= sensorFieldBit(SensorField::SunEast);
+	if (sample.sun_west_dk != previous.sun_west_dk)
+		changed |= sensorFieldBit(SensorField::SunWest);
+	if (sample.rain != previous.rain)
+		changed |= sensorFieldBit(SensorField::IsRaining);
+	if (sample.twighlight != previous.twighlight)
+		changed |= sensorFieldBit(SensorField::IsTwighlight);
+	return changed;
+}
 
-		buffer.pop_front();
-	}
+SensorFieldMask changedFields(const IndoorData& previous, const IndoorData& data)
+{
+	SensorFieldMask changed = 0;
+	if (data.temperature != previous.temperature)
+		changed |= sensorFieldBit(SensorField::IndoorTemp);
+	if (data.humidity != previous.humidity)
+		changed |= sensorFieldBit(SensorField::IndoorHumidity);
+	return changed;
 }
 }
 
 AutomationEngine::AutomationEngine(const Cfg::DeviceConfigList& cfg, QObject* parent) :
-	QObject(parent), _devices_cfg(cfg)
+	QObject(parent),
+	_weather_data_history(static_cast<size_t>(_data_history_secs) * MAX_SAMPLES_PER_SEC, _data_history_secs * 1000LL),
+	_indoor_data_history(static_cast<size_t>(_data_history_secs) * MAX_SAMPLES_PER_SEC, _data_history_secs * 1000LL),
+	_devices_cfg(cfg)
 {
 	_calc_timer = new QTimer(this);
-	connect(_calc_timer, &QTimer::timeout, this, &AutomationEngine::onCalcTimeout);
-	_calc_timer->start(5000);
+	connect(_calc_timer, &QTimer::timeout, this, &AutomationEngine::onFallbackTimeout);
+	_calc_timer->start(FALLBACK_EVALUATION_INTERVAL_MS);
+
+	_evaluation_timer = new QTimer(this);
+	_evaluation_timer->setSingleShot(true);
+	connect(_evaluation_timer, &QTimer::timeout, this, &AutomationEngine::evaluateRules);
 
 	initStateManagerThread();
 }
@@ -39,6 +65,8 @@ AutomationEngine::~AutomationEngine()
 {
 	if (_calc_timer)
 		_calc_timer->stop();
+	if (_evaluation_timer)
+		_evaluation_timer->stop();
 	if (_state_manager_thread)
 	{
 		_state_manager_thread->quit();
@@ -51,6 +79,8 @@ AutomationEngine::~AutomationEngine()
 void AutomationEngine::loadRules(const QString& file_path)
 {
 	_rule_set.loadFromJson(file_path);
+	_scheduler.setRules(_rule_set);
+	scheduleEvaluation();
 }
 
 void AutomationEngine::setManualMode()
@@ -70,6 +100,10 @@ void AutomationEngine::setAutoMode()
 		_state_manager, &Device::DeviceStateManager::onDeviceStatesUpdated);
 
 	Q_EMIT automationModeChanged(true);
+
+	// The state manager only gets states from now on, don't wait for the next sample
+	_scheduler.markAllDirty();
+	scheduleEvaluation();
 }
 
 bool AutomationEngine::isInAutoMode() const
@@ -77,14 +111,65 @@ bool AutomationEngine::isInAutoMode() const
 	return _automation_connect;
 }
 
+void AutomationEngine::setWeatherSampleReader(std::shared_ptr<SampleChannel<WeatherData>::Reader> reader)
+{
+	_weather_reader = std::move(reader);
+}
+
+void AutomationEngine::setIndoorSampleReader(std::shared_ptr<SampleChannel<IndoorData>::Reader> reader)
+{
+	_indoor_reader = std::move(reader);
+}
+
+void AutomationEngine::waitForWeatherHistory(int max_wait_sec)
+{
+	_waiting_for_history = true;
+	QTimer::singleShot(max_wait_sec * 1000, this, [this]()
+		{
+			if (!_waiting_for_history)
+				return;
+
+			qWarning() << "AutomationEngine: Weather history not loaded in time, evaluating rules with live data only";
+			_waiting_for_history = false;
+			_scheduler.markAllDirty();
+			scheduleEvaluation();
+		});
+}
+
+int AutomationEngine::historyLengthSec() const
+{
+	return _data_history_secs;
+}
+
 void AutomationEngine::onWeatherStationData(const WeatherData& weather_data)
 {
-	addCircularBufferData(_weather_data_history, weather_data, _data_history_secs);
+	const auto sample = PackedWeatherSample::pack(weather_data);
+	_scheduler.markSample(SensorDataSource::WeatherData, _weather_data_history.empty() ?
+		sensorSourceFields(SensorDataSource::WeatherData) : changedFields(_weather_data_history.newest(), sample));
+	_weather_data_history.push(sample);
+}
+
+/*
+* Logged samples (oldest first) are appended behind the live samples, that arrived meanwhile.
+* Only samples older than the oldest live sample are taken, the history stays ordered.
+*/
+void AutomationEngine::onWeatherHistoryLoaded(const WeatherDataBatch& history)
+{
+	// The history also rejects samples beyond the age limit of the newest one
+	for (auto it = history.rbegin(); it != history.rend(); ++it)
+		_weather_data_history.pushOldest(PackedWeatherSample::pack(*it));
+
+	qDebug() << "AutomationEngine: Weather history seeded with" << _weather_data_history.size() << "samples";
+	_waiting_for_history = false;
+	_scheduler.markAllDirty();
+	scheduleEvaluation();
 }
 
 void AutomationEngine::onIndoorStationData(const IndoorData& indoor_data)
 {
-	addCircularBufferData(_indoor_data_history, indoor_data, _data_history_secs);
+	_scheduler.markSample(SensorDataSource::IndoorData, _indoor_data_history.empty() ?
+		sensorSourceFields(SensorDataSource::IndoorData) : changedFields(_indoor_data_history.newest(), indoor_data));
+	_indoor_data_history.push(indoor_data);
 }
 
 void AutomationEngine::onManualDeviceOpenRequest(const QString& device_id)
@@ -127,20 +212,54 @@ void AutomationEngine::onAutomationModeChangeRequest(bool auto_mode)
 		setManualMode();
 }
 
-void AutomationEngine::onCalcTimeout()
+void AutomationEngine::onSamplesAvailable()
+{
+	drainSampleReaders();
+	scheduleEvaluation();
+}
+
+void AutomationEngine::onFallbackTimeout()
 {
+	drainSampleReaders();
+	_scheduler.markAllDirty();
+	scheduleEvaluation();
+}
+
+// Evaluates now, or when the minimum interval since the last evaluation passed
+void AutomationEngine::scheduleEvaluation()
+{
+	if (!_scheduler.hasPendingRules() || _evaluation_timer->isActive())
+		return;
+
+	const qint64 wait_ms = _last_evaluation.isValid() ? MIN_EVALUATION_INTERVAL_MS - _last_evaluation.elapsed() : 0;
+	if (wait_ms > 0)
+		_evaluation_timer->start(static_cast<int>(wait_ms));
+	else
+		evaluateRules();
+}
+
+void AutomationEngine::evaluateRules()
+{
+	drainSampleReaders();
+
+	if (_waiting_for_history)
+		return; // Duration conditions would see a history, that only started now
+
 	if (_weather_data_history.empty() || _indoor_data_history.empty())
 		return;
 
+	_last_evaluation.start();
+
 	std::vector<QString> device_ids;
 	for (const auto& device_cfg : _devices_cfg.device_cfgs)
 		device_ids.push_back(device_cfg.device_id);
 
 	try
 	{
-		const auto& weather_data_history = std::vector<WeatherData>(_weather_data_history.begin(), _weather_data_history.end());
-		const auto& indoor_data_history = std::vector<IndoorData>(_indoor_data_history.begin(), _indoor_data_history.end());
-		const auto& calculated_states = RulesProcessor::calculateDeviceStates(_rule_set, device_ids, weather_data_history, indoor_data_history);
+		// Conditions read the histories in place, the packed samples are unpacked on access
+		const HistoryView<WeatherData> weather_data_history(_weather_data_history);
+		const HistoryView<IndoorData> indoor_data_history(_indoor_data_history);
+		const auto& calculated_states = _scheduler.calculateDeviceStates(_rule_set, device_ids, weather_data_history, indoor_data_history);
 		Q_EMIT deviceStatesUpdated(calculated_states);
 	}
 	catch (const std::runtime_error& e)
@@ -150,6 +269,15 @@ void AutomationEngine::onCalcTimeout()
 	}
 }
 
+void AutomationEngine::drainSampleReaders()
+{
+	if (_weather_reader)
+		_weather_reader->drain([this](const WeatherData& data) { onWeatherStationData(data); });
+
+	if (_indoor_reader)
+		_indoor_reader->drain([this](const IndoorData& data) { onIndoorStationData(data); });
+}
+
 void AutomationEngine::initStateManagerThread()
 {
 	_state_manager_thread = new QThread();
@@ -0,0 +1,125 @@
+#include "RuleScheduler.h"
+#include "RulesProcessor.h"
+#include "RuleSet.h"
+
+#include <QtCore/QDebug>
+
+#include <algorithm>
+
+namespace Automation
+{
+
+void RuleScheduler::setRules(const RuleSet& rule_set)
+{
+	for (auto& rules : _rules_by_field)
+		rules.clear();
+	for (auto& rules : _time_rules_by_field)
+		rules.clear();
+
+	const auto& rules = rule_set.getRules();
+	for (size_t rule_index = 0; rule_index < rules.size(); ++rule_index)
+	{
+		SensorFieldMask fields = 0;
+		SensorFieldMask time_fields = 0;
+		for (const auto& condition : rules[rule_index].conditions)
+		{
+			if (!condition)
+				continue;
+
+			fields |= condition->fields();
+			time_fields |= condition->timeFields();
+		}
+
+		for (size_t field = 0; field < FIELD_COUNT; ++field)
+		{
+			const SensorFieldMask bit = sensorFieldBit(static_cast<SensorField>(field));
+			if (fields & bit)
+				_rules_by_field[field].push_back(rule_index);
+			if (time_fields & bit)
+				_time_rules_by_field[field].push_back(rule_index);
+		}
+	}
+
+	_dirty.assign(rules.size(), 1);
+	_results.assign(rules.size(), 0);
+	_pending = true;
+}
+
+void RuleScheduler::markSample(SensorDataSource source, SensorFieldMask changed_fields)
+{
+	const SensorFieldMask sampled_fields = sensorSourceFields(source);
+	for (size_t field = 0; field < FIELD_COUNT; ++field)
+	{
+		const SensorFieldMask bit = sensorFieldBit(static_cast<SensorField>(field));
+		if (changed_fields & bit)
+			markDirty(_rules_by_field[field]);
+		else if (sampled_fields & bit)
+			markDirty(_time_rules_by_field[field]);
+	}
+}
+
+void RuleScheduler::markAllDirty()
+{
+	std::fill(_dirty.begin(), _dirty.end(), 1);
+	_pending = true;
+}
+
+bool RuleScheduler::hasPendingRules() const
+{
+	return _pending;
+}
+
+void RuleScheduler::markDirty(const std::vector<size_t>& rule_indices)
+{
+	for (size_t rule_index : rule_indices)
+		_dirty[rule_index] = 1;
+
+	_pending = _pending || !rule_indices.empty();
+}
+
+Device::DeviceStates RuleScheduler::calculateDeviceStates(const RuleSet& rule_set, const std::vector<QString>& device_ids,
+	HistoryView<WeatherData> weather_history, HistoryView<IndoorData> indoor_history)
+{
+	const auto& rules = rule_set.getRules();
+	if (rules.size() != _dirty.size())
+	{
+		qWarning() << "RuleScheduler: Rules changed without setRules(), rebuilding the index";
+		setRules(rule_set);
+	}
+
+	Device::DeviceStates calculated_states;
+	for (const auto& device_id : device_ids)
+		calculated_states.states.push_back({ device_id, Device::DevicePosition::Unknown });
+
+	// Rules are sorted by priority, the first met rule of a device decides
+	for (size_t rule_index = 0; rule_index < rules.size(); ++rule_index)
+	{
+		const auto& rule = rules[rule_index];
+		if (calculated_states.getDevicePosition(rule.device_id) != Device::DevicePosition::Unknown)
+			continue;
+
+		if (_dirty[rule_index])
+		{
+			_results[rule_index] = RulesProcessor::evaluateRule(rule, weather_history, indoor_history) ? 1 : 0;
+			_dirty[rule_index] = 0;
+			++_statistics.evaluated_rules;
+		}
+		else
+		{
+			++_statistics.cached_rules;
+		}
+
+		if (_results[rule_index])
+			calculated_states.setDevicePosition(rule.device_id, rule.position);
+	}
+
+	++_statistics.evaluations;
+	_pending = false;
+	return calculated_states;
+}
+
+const RuleScheduler::Statistics& RuleScheduler::statistics() const
+{
+	return _statistics;
+}
+}
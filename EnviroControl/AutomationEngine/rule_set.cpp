@@ -105,6 +105,7 @@ bool RuleSet::loadFromJson(const QString& file_path)
 
 		if (rule_json.contains("conditions") && rule_json["conditions"].isArray())
 		{
+			bool conditions_valid = true;
 			QJsonArray conditions_array = rule_json["conditions"].toArray();
 			for (const QJsonValue& condition_value : conditions_array)
 			{
@@ -120,9 +121,22 @@ bool RuleSet::loadFromJson(const QString& file_path)
 				}
 				else
 				{
-					qWarning() << "Rule '" << rule.id << "': Failed to parse condition. Skipping.";
+					// Without the condition the rule would trigger in more cases than intended
+					qWarning() << "Rule '" << rule.id << "': Failed to parse condition. Skipping rule.";
+					conditions_valid = false;
+					break;
 				}
 			}
+			if (!conditions_valid)
+				continue;
+
+			// The conditions of a rule are an all group, so they get ordered like the ones of nested groups
+			if (rule.conditions.size() > 1)
+			{
+				auto conditions = std::move(rule.conditions);
+				rule.conditions.clear();
+				rule.conditions.push_back(std::make_unique<ConditionGroup>(ConditionGroup::All, std::move(conditions)));
+			}
 		}
 		else
 		{
@@ -157,6 +171,10 @@ std::unique_ptr<AbstractCondition> RuleSet::parseCondition(const QJsonObject& js
 	}
 	QString type_str = json["type"].toString().toLower();
 
+	// Groups: { "type": "all" | "any", "conditions": [ ... ] } and { "type": "not", "condition": { ... } }
+	if (type_str == "all" || type_str == "any" || type_str == "not")
+		return parseConditionGroup(json, type_str);
+
 	if (!json.contains("sensor_type") || !json["sensor_type"].isString())
 	{
 		qWarning() << "Condition missing 'sensor_type'.";
@@ -185,6 +203,14 @@ std::unique_ptr<AbstractCondition> RuleSet::parseCondition(const QJsonObject& js
 		return nullptr;
 	}
 
+	// Resolved once here, evaluating never looks at the name again
+	const bool boolean_field = type_str == "boolean_state" || type_str == "boolean_time_duration";
+	if (resolveSensorField(sensor_source, field, boolean_field) == SensorField::Unknown)
+	{
+		qWarning() << "Unknown" << (boolean_field ? "boolean" : "numeric") << "field for sensor_type" << sensor_type_str << ":" << field;
+		return nullptr;
+	}
+
 	// Parse common operator and value for numeric conditions
 	ConditionOperator op = ConditionOperator::Unknown;
 	double value = 0.0;
@@ -279,6 +305,51 @@ std::unique_ptr<AbstractCondition> RuleSet::parseCondition(const QJsonObject& js
 	}
 }
 
+std::unique_ptr<AbstractCondition> RuleSet::parseConditionGroup(const QJsonObject& json, const QString& type_str) const
+{
+	std::vector<std::unique_ptr<AbstractCondition>> children;
+
+	if (type_str == "not")
+	{
+		if (!json.contains("condition") || !json["condition"].isObject())
+		{
+			qWarning() << "Condition group 'not' missing 'condition'.";
+			return nullptr;
+		}
+
+		auto child = parseCondition(json["condition"].toObject());
+		if (!child)
+			return nullptr;
+
+		children.push_back(std::move(child));
+		return std::make_unique<ConditionGroup>(ConditionGroup::Not, std::move(children));
+	}
+
+	if (!json.contains("conditions") || !json["conditions"].isArray() || json["conditions"].toArray().isEmpty())
+	{
+		qWarning() << "Condition group" << type_str << "missing 'conditions'.";
+		return nullptr;
+	}
+
+	for (const QJsonValue& condition_value : json["conditions"].toArray())
+	{
+		if (!condition_value.isObject())
+		{
+			qWarning() << "Condition group" << type_str << "has an entry, that is not an object.";
+			return nullptr;
+		}
+
+		// A group without one of its conditions would be met in other cases than intended
+		auto child = parseCondition(condition_value.toObject());
+		if (!child)
+			return nullptr;
+
+		children.push_back(std::move(child));
+	}
+
+	return std::make_unique<ConditionGroup>(type_str == "all" ? ConditionGroup::All : ConditionGroup::Any, std::move(children));
+}
+
 void RuleSet::sortRuleByPriority()
 {
 	// Sort rules by priority (higher priority first)
@@ -6,7 +6,7 @@
 namespace Automation
 {
 
-bool RulesProcessor::evaluateRule(const Rule& rule, const std::vector<WeatherData>& weather_history, const std::vector<IndoorData>& indoor_history)
+bool RulesProcessor::evaluateRule(const Rule& rule, HistoryView<WeatherData> weather_history, HistoryView<IndoorData> indoor_history)
 {
 	bool all_conditions_met = true;
 	for (const auto& condition : rule.conditions)
@@ -35,8 +35,8 @@ bool RulesProcessor::evaluateRule(const Rule& rule, const std::vector<WeatherDat
 Device::DeviceStates RulesProcessor::calculateDeviceStates(
 	const RuleSet& rule_set,
 	std::vector<QString> device_ids,
-	const std::vector<WeatherData>& weather_history,
-	const std::vector<IndoorData>& indoor_history)
+	HistoryView<WeatherData> weather_history,
+	HistoryView<IndoorData> indoor_history)
 {
 	Device::DeviceStates calculated_states;
 
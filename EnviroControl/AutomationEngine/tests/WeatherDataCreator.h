@@ -14,7 +14,7 @@ struct WeatherDataCreator
 		rainy.daylight = 100;
 		rainy.wind = 0;
 		rainy.rain = true;
-		rainy.timestamp = timestamp;
+		rainy.timestamp = SampleTime::fromDateTime(timestamp);
 
 		return rainy;
 	}
@@ -30,7 +30,7 @@ struct WeatherDataCreator
 		cond.daylight = 100;
 		cond.wind = wind;
 		cond.rain = false;
-		cond.timestamp = timestamp;
+		cond.timestamp = SampleTime::fromDateTime(timestamp);
 
 		return cond;
 	}
@@ -40,7 +40,7 @@ struct WeatherDataCreator
 		IndoorData cond;
 		cond.temperature = temperature;
 		cond.humidity = 10;
-		cond.timestamp = timestamp;
+		cond.timestamp = SampleTime::fromDateTime(timestamp);
 		return cond;
 	}
 
@@ -5,6 +5,9 @@
 #include "RuleSet.h"
 #include "WeatherData.h"
 #include "IndoorStation.h"
+#include "PackedWeatherSample.h"
+
+#include <deque>
 
 using namespace Automation;
 
@@ -94,4 +97,70 @@ TEST(ConditionTest, BooleanTimeDurationCondition)
 
 	EXPECT_FALSE(pass_no_rain_10_min.evaluate(weather_history, indoor_history));
 	EXPECT_TRUE(pass_no_rain_3_min.evaluate(weather_history, indoor_history));
-}
\ No newline at end of file
+}
+TEST(ConditionTest, DurationConditionFollowsGrowingHistory)
+{
+	// Samples arrive every minute, the condition is evaluated after each one and keeps its state
+	std::vector<WeatherData> weather_history;
+	std::vector<IndoorData> indoor_history;
+
+	auto pass_low_wind_3_min = NumericTimeDurationCondition(SensorDataSource::WeatherData, "wind_speed", ConditionOperator::LessThan, 25, 60 * 3);
+
+	const auto start = QDateTime::currentDateTime();
+	const std::vector<double> winds = { 20, 21, 30, 22, 21, 20, 23, 24 };
+	std::vector<bool> results;
+	for (size_t i = 0; i < winds.size(); ++i)
+	{
+		// First one is newest
+		weather_history.insert(weather_history.begin(), WeatherDataCreator::createWindy(start.addSecs(60 * i), winds[i]));
+		results.push_back(pass_low_wind_3_min.evaluate(weather_history, indoor_history));
+	}
+
+	// Too short until minute 3, the gust at minute 2 blocks up to minute 5
+	EXPECT_EQ(results, std::vector<bool>({ false, false, false, false, false, false, true, true }));
+}
+
+TEST(ConditionTest, DurationConditionSeesOlderSamplesAddedLater)
+{
+	std::vector<WeatherData> weather_history;
+	std::vector<IndoorData> indoor_history;
+
+	auto pass_no_rain_3_min = BooleanTimeDurationCondition(SensorDataSource::WeatherData, "is_raining", false, 60 * 3);
+
+	auto now = QDateTime::currentDateTime();
+	weather_history.push_back(WeatherDataCreator::createWindy(now, 10));
+	weather_history.push_back(WeatherDataCreator::createWindy(now.addSecs(-60 * 1), 10));
+	EXPECT_FALSE(pass_no_rain_3_min.evaluate(weather_history, indoor_history)); // Too short
+
+	// Logged samples are appended at the back (history warm-up)
+	weather_history.push_back(WeatherDataCreator::createRainy(now.addSecs(-60 * 2)));
+	weather_history.push_back(WeatherDataCreator::createWindy(now.addSecs(-60 * 3), 10));
+	EXPECT_FALSE(pass_no_rain_3_min.evaluate(weather_history, indoor_history)); // Rain 2 minutes ago
+
+	weather_history.insert(weather_history.begin(), WeatherDataCreator::createWindy(now.addSecs(60 * 2), 10));
+	EXPECT_TRUE(pass_no_rain_3_min.evaluate(weather_history, indoor_history)); // Rain 4 minutes ago
+}
+
+TEST(ConditionTest, EvaluatesPackedHistoryInPlace)
+{
+	// Same layout as the engine's history store, newest first
+	std::deque<PackedWeatherSample> weather_store;
+	std::deque<IndoorData> indoor_store;
+
+	auto now = QDateTime::currentDateTime();
+	weather_store.push_front(PackedWeatherSample::pack(WeatherDataCreator::createWindy(now.addSecs(-60 * 4), 30)));
+	weather_store.push_front(PackedWeatherSample::pack(WeatherDataCreator::createWindy(now.addSecs(-60 * 3), 12)));
+	weather_store.push_front(PackedWeatherSample::pack(WeatherDataCreator::createWindy(now, 10.5)));
+	indoor_store.push_front(WeatherDataCreator::createIndoorData(now, 22));
+
+	const HistoryView<WeatherData> weather_history(weather_store);
+	const HistoryView<IndoorData> indoor_history(indoor_store);
+	ASSERT_EQ(weather_history.size(), 3u);
+	EXPECT_DOUBLE_EQ(weather_history.front().wind, 10.5);
+	EXPECT_DOUBLE_EQ(weather_history.back().wind, 30);
+
+	auto pass_low_wind_3_min = NumericTimeDurationCondition(SensorDataSource::WeatherData, "wind_speed", ConditionOperator::LessThan, 20, 60 * 3);
+	auto pass_indoor_hot = NumericThresholdCondition(SensorDataSource::IndoorData, "indoor_temp", ConditionOperator::GreaterThan, 20);
+	EXPECT_TRUE(pass_low_wind_3_min.evaluate(weather_history, indoor_history));
+	EXPECT_TRUE(pass_indoor_hot.evaluate(weather_history, indoor_history));
+}
@@ -8,6 +8,9 @@
 #include "IndoorStation.h"
 #include "DeviceState.h"
 
+#include <QtCore/QFile>
+#include <QtCore/QTemporaryDir>
+
 using namespace Automation;
 
 Rule createRuleWithoutCondition()
@@ -58,4 +61,115 @@ TEST(RuleTest, ThreePass)
 
 	auto rule_passed = RulesProcessor::evaluateRule(rule, weather_history, indoor_history);
 	EXPECT_TRUE(rule_passed);
-}
\ No newline at end of file
+}
+
+TEST(RuleTest, LoadRejectsRulesWithUnknownFields)
+{
+	QTemporaryDir dir;
+	const QString file_path = dir.filePath("rules.json");
+	QFile file(file_path);
+	ASSERT_TRUE(file.open(QIODevice::WriteOnly));
+	file.write(R"({ "rules": [
+		{ "id": "valid", "device_id": "device_id", "priority": 10, "action": "close", "conditions": [
+			{ "type": "numeric_threshold", "sensor_type": "weather_data", "field": "wind_speed", "operator": "gt", "value": 25 } ] },
+		{ "id": "unknown_field", "device_id": "device_id", "priority": 5, "action": "open", "conditions": [
+			{ "type": "boolean_state", "sensor_type": "weather_data", "field": "is_raining", "expected_value": false },
+			{ "type": "numeric_threshold", "sensor_type": "weather_data", "field": "wind_sped", "operator": "lt", "value": 10 } ] },
+		{ "id": "wrong_source", "device_id": "device_id", "priority": 1, "action": "open", "conditions": [
+			{ "type": "numeric_threshold", "sensor_type": "indoor_data", "field": "wind_speed", "operator": "lt", "value": 10 } ] }
+	] })");
+	file.close();
+
+	RuleSet rule_set;
+	ASSERT_TRUE(rule_set.loadFromJson(file_path));
+	ASSERT_EQ(rule_set.getRules().size(), 1u);
+	EXPECT_EQ(rule_set.getRules()[0].id, "valid");
+}
+
+TEST(RuleTest, LoadsNestedConditionGroups)
+{
+	QTemporaryDir dir;
+	const QString file_path = dir.filePath("rules.json");
+	QFile file(file_path);
+	ASSERT_TRUE(file.open(QIODevice::WriteOnly));
+	// Close on rain, or on high wind unless it is cold inside
+	file.write(R"({ "rules": [
+		{ "id": "nested", "device_id": "device_id", "priority": 10, "action": "close", "conditions": [
+			{ "type": "any", "conditions": [
+				{ "type": "boolean_state", "sensor_type": "weather_data", "field": "is_raining", "expected_value": true },
+				{ "type": "all", "conditions": [
+					{ "type": "numeric_threshold", "sensor_type": "weather_data", "field": "wind_speed", "operator": "gt", "value": 25 },
+					{ "type": "not", "condition":
+						{ "type": "numeric_threshold", "sensor_type": "indoor_data", "field": "indoor_temp", "operator": "lt", "value": 15 } } ] } ] } ] },
+		{ "id": "empty_group", "device_id": "device_id", "priority": 5, "action": "open", "conditions": [
+			{ "type": "all", "conditions": [] } ] },
+		{ "id": "not_without_condition", "device_id": "device_id", "priority": 1, "action": "open", "conditions": [
+			{ "type": "not", "conditions": [
+				{ "type": "boolean_state", "sensor_type": "weather_data", "field": "is_raining", "expected_value": true } ] } ] }
+	] })");
+	file.close();
+
+	RuleSet rule_set;
+	ASSERT_TRUE(rule_set.loadFromJson(file_path));
+	ASSERT_EQ(rule_set.getRules().size(), 1u);
+	const auto& rule = rule_set.getRules()[0];
+
+	const auto now = QDateTime::currentDateTime();
+	auto evaluate = [&rule](const WeatherData& weather, double indoor_temp)
+		{
+			const std::vector<WeatherData> weather_history = { weather };
+			const std::vector<IndoorData> indoor_history = { WeatherDataCreator::createIndoorData(weather.timestamp.toDateTime(), indoor_temp) };
+			return RulesProcessor::evaluateRule(rule, weather_history, indoor_history);
+		};
+
+	EXPECT_TRUE(evaluate(WeatherDataCreator::createRainy(now), 10));
+	EXPECT_TRUE(evaluate(WeatherDataCreator::createWindy(now.addSecs(60), 30), 20));
+	EXPECT_FALSE(evaluate(WeatherDataCreator::createWindy(now.addSecs(120), 30), 10));
+	EXPECT_FALSE(evaluate(WeatherDataCreator::createWindy(now.addSecs(180), 10), 20));
+}
+
+TEST(RuleTest, GroupEvaluatesCheapConditionsFirst)
+{
+	std::vector<std::unique_ptr<AbstractCondition>> children;
+	children.push_back(std::make_unique<NumericTimeDurationCondition>(SensorDataSource::WeatherData, "wind_speed", ConditionOperator::LessThan, 20, 3 * 60));
+	children.push_back(std::make_unique<NumericThresholdCondition>(SensorDataSource::WeatherData, "daylight", ConditionOperator::GreaterThan, 80));
+	const ConditionGroup group(ConditionGroup::All, std::move(children));
+
+	EXPECT_EQ(group.cost(), AbstractCondition::DURATION_COST + AbstractCondition::SAMPLE_COST);
+	EXPECT_TRUE(group.isTimeBased());
+	EXPECT_EQ(group.fields(), sensorFieldBit(SensorField::WindSpeed) | sensorFieldBit(SensorField::Daylight));
+
+	const auto statistics = group.statistics();
+	ASSERT_EQ(statistics.children.size(), 2u);
+	EXPECT_EQ(statistics.children[0].index, 1u); // Threshold before the duration condition
+	EXPECT_EQ(statistics.children[1].index, 0u);
+	EXPECT_EQ(statistics.reorders, 0u);
+}
+
+TEST(RuleTest, GroupReordersByObservedRate)
+{
+	std::vector<std::unique_ptr<AbstractCondition>> children;
+	children.push_back(std::make_unique<NumericThresholdCondition>(SensorDataSource::WeatherData, "wind_speed", ConditionOperator::GreaterThan, 100)); // Rarely met
+	children.push_back(std::make_unique<NumericThresholdCondition>(SensorDataSource::WeatherData, "wind_speed", ConditionOperator::GreaterThan, 0));   // Nearly always met
+	const ConditionGroup group(ConditionGroup::Any, std::move(children));
+
+	const std::vector<WeatherData> weather_history = { WeatherDataCreator::createWindy(QDateTime::currentDateTime(), 10) };
+	const std::vector<IndoorData> indoor_history;
+	for (quint64 i = 0; i < ConditionGroup::REORDER_INTERVAL; ++i)
+		EXPECT_TRUE(group.evaluate(weather_history, indoor_history));
+
+	// The often met condition decides an any group faster
+	auto statistics = group.statistics();
+	EXPECT_EQ(statistics.evaluations, ConditionGroup::REORDER_INTERVAL);
+	EXPECT_EQ(statistics.reorders, 1u);
+	ASSERT_EQ(statistics.children.size(), 2u);
+	EXPECT_EQ(statistics.children[0].index, 1u);
+	EXPECT_EQ(statistics.children[1].evaluations, ConditionGroup::REORDER_INTERVAL);
+	EXPECT_EQ(statistics.children[1].met, 0u);
+
+	// From now on the rarely met condition is skipped
+	EXPECT_TRUE(group.evaluate(weather_history, indoor_history));
+	statistics = group.statistics();
+	EXPECT_EQ(statistics.children[1].evaluations, ConditionGroup::REORDER_INTERVAL);
+	EXPECT_EQ(statistics.children[0].evaluations, ConditionGroup::REORDER_INTERVAL + 1);
+}
@@ -0,0 +1,174 @@
+#include "gtest/gtest.h"
+
+#include "RuleScheduler.h"
+#include "RulesProcessor.h"
+
+#include "WeatherDataCreator.h"
+
+using namespace Automation;
+
+namespace
+{
+Rule createSchedulerRule(const QString& device_id, int priority, Device::DevicePosition position)
+{
+	Rule rule;
+	rule.id = QString("%1_%2").arg(device_id).arg(priority);
+	rule.device_id = device_id;
+	rule.priority = priority;
+	rule.position = position;
+	return rule;
+}
+
+// window: closes on high wind, opens when warm inside. sunblind: closes when calm for 3 minutes.
+RuleSet createSchedulerRuleSet()
+{
+	auto close_on_wind = createSchedulerRule("window", 999, Device::DevicePosition::Closed);
+	close_on_wind.conditions.push_back(std::make_unique<NumericThresholdCondition>(SensorDataSource::WeatherData, "wind_speed", ConditionOperator::GreaterThan, 25));
+
+	auto open_when_warm = createSchedulerRule("window", 500, Device::DevicePosition::Open);
+	open_when_warm.conditions.push_back(std::make_unique<NumericThresholdCondition>(SensorDataSource::IndoorData, "indoor_temp", ConditionOperator::GreaterThan, 20));
+
+	auto window_default = createSchedulerRule("window", 1, Device::DevicePosition::Closed);
+
+	auto close_when_calm = createSchedulerRule("sunblind", 500, Device::DevicePosition::Closed);
+	close_when_calm.conditions.push_back(std::make_unique<NumericTimeDurationCondition>(SensorDataSource::WeatherData, "wind_speed", ConditionOperator::LessThan, 20, 3 * 60));
+
+	auto sunblind_default = createSchedulerRule("sunblind", 1, Device::DevicePosition::Open);
+
+	std::vector<Rule> rules;
+	rules.push_back(std::move(close_on_wind));
+	rules.push_back(std::move(open_when_warm));
+	rules.push_back(std::move(window_default));
+	rules.push_back(std::move(close_when_calm));
+	rules.push_back(std::move(sunblind_default));
+
+	RuleSet rule_set;
+	rule_set.setRules(std::move(rules));
+	return rule_set;
+}
+}
+
+TEST(RuleSchedulerTest, FirstCalculationEvaluatesAllRequiredRules)
+{
+	const auto rule_set = createSchedulerRuleSet();
+	const std::vector<QString> device_ids = { "window", "sunblind" };
+	const auto now = QDateTime::currentDateTime();
+
+	RuleScheduler scheduler;
+	scheduler.setRules(rule_set);
+	EXPECT_TRUE(scheduler.hasPendingRules());
+
+	const std::vector<WeatherData> weather_history = { WeatherDataCreator::createWindy(now, 10) };
+	const std::vector<IndoorData> indoor_history = { WeatherDataCreator::createIndoorData(now, 22) };
+
+	const auto states = scheduler.calculateDeviceStates(rule_set, device_ids, weather_history, indoor_history);
+	const auto expected = RulesProcessor::calculateDeviceStates(rule_set, device_ids, weather_history, indoor_history);
+	EXPECT_EQ(states.getDevicePosition("window"), expected.getDevicePosition("window"));
+	EXPECT_EQ(states.getDevicePosition("sunblind"), expected.getDevicePosition("sunblind"));
+	EXPECT_EQ(states.getDevicePosition("window"), Device::DevicePosition::Open);
+	EXPECT_FALSE(scheduler.hasPendingRules());
+}
+
+TEST(RuleSchedulerTest, IndoorSampleOnlyEvaluatesIndoorRules)
+{
+	const auto rule_set = createSchedulerRuleSet();
+	const std::vector<QString> device_ids = { "window", "sunblind" };
+	const auto now = QDateTime::currentDateTime();
+
+	RuleScheduler scheduler;
+	scheduler.setRules(rule_set);
+
+	const std::vector<WeatherData> weather_history = { WeatherDataCreator::createWindy(now, 10) };
+	std::vector<IndoorData> indoor_history = { WeatherDataCreator::createIndoorData(now, 22) };
+	scheduler.calculateDeviceStates(rule_set, device_ids, weather_history, indoor_history);
+	const auto evaluated_before = scheduler.statistics().evaluated_rules;
+
+	// Cold inside: the wind rules keep their result, only the indoor rule and the window default are evaluated
+	indoor_history.insert(indoor_history.begin(), WeatherDataCreator::createIndoorData(now.addSecs(10), 15));
+	scheduler.markSample(SensorDataSource::IndoorData, sensorFieldBit(SensorField::IndoorTemp));
+	EXPECT_TRUE(scheduler.hasPendingRules());
+
+	const auto states = scheduler.calculateDeviceStates(rule_set, device_ids, weather_history, indoor_history);
+	EXPECT_EQ(states.getDevicePosition("window"), Device::DevicePosition::Closed);
+	EXPECT_EQ(states.getDevicePosition("sunblind"), Device::DevicePosition::Open);
+	EXPECT_EQ(scheduler.statistics().evaluated_rules - evaluated_before, 2u);
+}
+
+TEST(RuleSchedulerTest, UnchangedSampleOnlyEvaluatesDurationRules)
+{
+	const auto rule_set = createSchedulerRuleSet();
+	const std::vector<QString> device_ids = { "window", "sunblind" };
+	const auto now = QDateTime::currentDateTime();
+
+	RuleScheduler scheduler;
+	scheduler.setRules(rule_set);
+
+	std::vector<WeatherData> weather_history = { WeatherDataCreator::createWindy(now, 10) };
+	const std::vector<IndoorData> indoor_history = { WeatherDataCreator::createIndoorData(now, 22) };
+	auto states = scheduler.calculateDeviceStates(rule_set, device_ids, weather_history, indoor_history);
+	EXPECT_EQ(states.getDevicePosition("sunblind"), Device::DevicePosition::Open); // Not calm for 3 minutes yet
+
+	// Same wind, 4 minutes later: only the duration rule can change
+	weather_history.insert(weather_history.begin(), WeatherDataCreator::createWindy(now.addSecs(4 * 60), 10));
+	scheduler.markSample(SensorDataSource::WeatherData, 0);
+	EXPECT_TRUE(scheduler.hasPendingRules());
+
+	const auto evaluated_before = scheduler.statistics().evaluated_rules;
+	states = scheduler.calculateDeviceStates(rule_set, device_ids, weather_history, indoor_history);
+	EXPECT_EQ(states.getDevicePosition("sunblind"), Device::DevicePosition::Closed);
+	EXPECT_EQ(states.getDevicePosition("window"), Device::DevicePosition::Open);
+	EXPECT_EQ(scheduler.statistics().evaluated_rules - evaluated_before, 1u);
+}
+
+TEST(RuleSchedulerTest, UnrelatedSampleLeavesNothingPending)
+{
+	const auto rule_set = createSchedulerRuleSet();
+
+	RuleScheduler scheduler;
+	scheduler.setRules(rule_set);
+	const std::vector<QString> device_ids = { "window", "sunblind" };
+	const auto now = QDateTime::currentDateTime();
+	const std::vector<WeatherData> weather_history = { WeatherDataCreator::createWindy(now, 10) };
+	const std::vector<IndoorData> indoor_history = { WeatherDataCreator::createIndoorData(now, 22) };
+	scheduler.calculateDeviceStates(rule_set, device_ids, weather_history, indoor_history);
+
+	// No rule reads the humidity
+	scheduler.markSample(SensorDataSource::IndoorData, sensorFieldBit(SensorField::IndoorHumidity));
+	EXPECT_FALSE(scheduler.hasPendingRules());
+
+	scheduler.markAllDirty();
+	EXPECT_TRUE(scheduler.hasPendingRules());
+}
+
+TEST(RuleSchedulerTest, GroupOnlyWakesOnTheFieldsOfItsDurationConditions)
+{
+	// Warm inside and calm for 3 minutes: only the wind makes the rule time based, not the indoor temperature
+	std::vector<std::unique_ptr<AbstractCondition>> children;
+	children.push_back(std::make_unique<NumericThresholdCondition>(SensorDataSource::IndoorData, "indoor_temp", ConditionOperator::GreaterThan, 20));
+	children.push_back(std::make_unique<NumericTimeDurationCondition>(SensorDataSource::WeatherData, "wind_speed", ConditionOperator::LessThan, 20, 3 * 60));
+
+	auto open_when_warm_and_calm = createSchedulerRule("window", 500, Device::DevicePosition::Open);
+	open_when_warm_and_calm.conditions.push_back(std::make_unique<ConditionGroup>(ConditionGroup::All, std::move(children)));
+	EXPECT_EQ(open_when_warm_and_calm.conditions.front()->timeFields(), sensorFieldBit(SensorField::WindSpeed));
+
+	std::vector<Rule> rules;
+	rules.push_back(std::move(open_when_warm_and_calm));
+	RuleSet rule_set;
+	rule_set.setRules(std::move(rules));
+
+	RuleScheduler scheduler;
+	scheduler.setRules(rule_set);
+	const std::vector<QString> device_ids = { "window" };
+	const auto now = QDateTime::currentDateTime();
+	const std::vector<WeatherData> weather_history = { WeatherDataCreator::createWindy(now, 10) };
+	const std::vector<IndoorData> indoor_history = { WeatherDataCreator::createIndoorData(now, 22) };
+	scheduler.calculateDeviceStates(rule_set, device_ids, weather_history, indoor_history);
+
+	// Unchanged indoor sample: the threshold result stays the same
+	scheduler.markSample(SensorDataSource::IndoorData, 0);
+	EXPECT_FALSE(scheduler.hasPendingRules());
+
+	// Unchanged weather sample: the calm period may have passed
+	scheduler.markSample(SensorDataSource::WeatherData, 0);
+	EXPECT_TRUE(scheduler.hasPendingRules());
+}
@@ -26,6 +26,74 @@ struct DeviceConfig
 	int safety_pos; // 1 = Open, 2 = Close (keep in sync with DevicePosition)
 };
 
+// Optional ingestion stage, that only forwards samples differing from the last forwarded one by more than a deadband
+struct DeltaFilterConfig
+{
+	bool enabled = false;
+	double temperature_deadband = 0.1; // Celsius
+	double sun_deadband = 1.0;         // kLux
+	double daylight_deadband = 5.0;    // Lux
+	double wind_deadband = 0.3;        // m/s
+	int keyframe_interval_sec = 60;    // A sample is forwarded at least this often
+};
+
+enum class LogFormat
+{
+	JsonLines, // One JSON object per line
+	Binary     // Versioned header + fixed-size records (see WeatherLogBinary.h)
+};
+
+// When the log file is synced to the storage (SD card) after buffered entries were written
+enum class FsyncPolicy
+{
+	Never,   // Left to the OS
+	OnFlush, // After every flush
+	Interval // At most every fsync_interval_sec
+};
+
+// Buffered log writing: entries are collected in memory and written once the size or time threshold is reached
+struct LogWriterConfig
+{
+	int flush_interval_sec = 60;
+	int flush_size_bytes = 4096;
+	FsyncPolicy fsync_policy = FsyncPolicy::OnFlush;
+	int fsync_interval_sec = 600;
+};
+
+// Time-based log storage: one log segment per day, listed in a manifest next to log_file_path.
+// Closed segments are compressed in the background, old ones are removed by the retention policy.
+struct LogStorageConfig
+{
+	bool segmented = false;
+	bool compress_closed_segments = true;
+	int retention_days = 0; // 0 = keep all
+	int max_total_mb = 0;   // 0 = unlimited, otherwise the oldest segments are removed first
+};
+
+// What the logger writes besides the main log, all files are written by a single writer thread.
+// Without aggregate the main log gets the last changed sample of each log interval, with aggregate the average
+// of all samples of the interval.
+struct LogPipelineConfig
+{
+	bool aggregate = false;    // Plus min/max/avg of each interval in <log>_aggregated.jsonl
+	bool raw_capture = false;  // Every sample in <log>_raw.<jsonl|bin>
+	bool events = false;       // Rain and twighlight changes in <log>_events.jsonl
+	int queue_capacity = 1024; // Pending writes, raw samples are dropped while the queue is full
+};
+
+// Mock weather station, used if port_name is empty
+struct MockConfig
+{
+	// Follow mode (default): mock_weather_data.json next to the log file is followed, new entries are emitted
+	// when it changes and the latest one is repeated every repeat_interval_sec.
+	int repeat_interval_sec = 5;
+
+	// Replay mode: a recorded log is replayed at its original cadence, divided by replay_speed
+	QString replay_file;
+	double replay_speed = 1.0;
+	bool replay_loop = true;
+};
+
 struct WeatherStationConfig
 {
 	QString port_name;
@@ -36,6 +104,14 @@ struct WeatherStationConfig
 	int log_frequency_sec;
 	int watchdog_timeout_sec;
 	QString log_file_path;
+	LogFormat log_format = LogFormat::JsonLines;
+	bool log_rollups = false; // Minute/hour/day rollups next to the log (see WeatherRollup.h)
+
+	DeltaFilterConfig delta_filter_cfg;
+	LogWriterConfig log_writer_cfg;
+	LogStorageConfig log_storage_cfg;
+	LogPipelineConfig log_pipeline_cfg;
+	MockConfig mock_cfg;
 };
 
 struct IndoorStationConfig
@@ -6,6 +6,8 @@
 #include <QtCore/QJsonDocument>
 #include <QtCore/QJsonObject>
 
+#include <algorithm>
+
 namespace Cfg
 {
 
@@ -40,6 +42,21 @@ int extractInt(const QJsonObject& obj, const QString& key)
 	return obj[key].toInt();
 }
 
+// Optional keys fall back to the default value, if present they must have the right type
+int extractOptionalInt(const QJsonObject& obj, const QString& key, int default_value)
+{
+	if (!obj.contains(key))
+		return default_value;
+	return extractInt(obj, key);
+}
+
+double extractOptionalDouble(const QJsonObject& obj, const QString& key, double default_value)
+{
+	if (!obj.contains(key))
+		return default_value;
+	return extractDouble(obj, key);
+}
+
 bool extractBool(const QJsonObject& obj, const QString& key)
 {
 	if (!obj.contains(key) || !obj[key].isBool())
@@ -104,6 +121,129 @@ DeviceConfigList parseDeviceConfig(const QJsonObject& root_obj, const QString& o
 	return config_list;
 }
 
+DeltaFilterConfig parseDeltaFilterConfig(const QJsonObject& weather_station_obj, const QString& obj_name)
+{
+	DeltaFilterConfig delta_filter_cfg;
+	if (!weather_station_obj.contains(obj_name))
+		return delta_filter_cfg; // Disabled
+
+	if (!weather_station_obj[obj_name].isObject())
+		throw std::runtime_error(QString("%1 is not an object in config file").arg(obj_name).toStdString());
+
+	QJsonObject delta_filter_obj = weather_station_obj[obj_name].toObject();
+	delta_filter_cfg.enabled = extractBool(delta_filter_obj, "enabled");
+	delta_filter_cfg.temperature_deadband = extractOptionalDouble(delta_filter_obj, "temperature_deadband", delta_filter_cfg.temperature_deadband);
+	delta_filter_cfg.sun_deadband = extractOptionalDouble(delta_filter_obj, "sun_deadband", delta_filter_cfg.sun_deadband);
+	delta_filter_cfg.daylight_deadband = extractOptionalDouble(delta_filter_obj, "daylight_deadband", delta_filter_cfg.daylight_deadband);
+	delta_filter_cfg.wind_deadband = extractOptionalDouble(delta_filter_obj, "wind_deadband", delta_filter_cfg.wind_deadband);
+	delta_filter_cfg.keyframe_interval_sec = extractOptionalInt(delta_filter_obj, "keyframe_interval_sec", delta_filter_cfg.keyframe_interval_sec);
+
+	return delta_filter_cfg;
+}
+
+LogFormat parseLogFormat(const QString& format)
+{
+	if (format == "jsonl")
+		return LogFormat::JsonLines;
+	if (format == "binary")
+		return LogFormat::Binary;
+
+	throw std::runtime_error(QString("Unknown log format '%1' in config file").arg(format).toStdString());
+}
+
+FsyncPolicy parseFsyncPolicy(const QString& policy)
+{
+	if (policy == "never")
+		return FsyncPolicy::Never;
+	if (policy == "on_flush")
+		return FsyncPolicy::OnFlush;
+	if (policy == "interval")
+		return FsyncPolicy::Interval;
+
+	throw std::runtime_error(QString("Unknown fsync policy '%1' in config file").arg(policy).toStdString());
+}
+
+LogWriterConfig parseLogWriterConfig(const QJsonObject& weather_station_obj, const QString& obj_name)
+{
+	LogWriterConfig log_writer_cfg;
+	if (!weather_station_obj.contains(obj_name))
+		return log_writer_cfg; // Defaults
+
+	if (!weather_station_obj[obj_name].isObject())
+		throw std::runtime_error(QString("%1 is not an object in config file").arg(obj_name).toStdString());
+
+	QJsonObject log_writer_obj = weather_station_obj[obj_name].toObject();
+	log_writer_cfg.flush_interval_sec = std::max(1, extractOptionalInt(log_writer_obj, "flush_interval_sec", log_writer_cfg.flush_interval_sec));
+	log_writer_cfg.flush_size_bytes = std::max(0, extractOptionalInt(log_writer_obj, "flush_size_bytes", log_writer_cfg.flush_size_bytes));
+	if (log_writer_obj.contains("fsync_policy"))
+		log_writer_cfg.fsync_policy = parseFsyncPolicy(extractString(log_writer_obj, "fsync_policy"));
+	log_writer_cfg.fsync_interval_sec = extractOptionalInt(log_writer_obj, "fsync_interval_sec", log_writer_cfg.fsync_interval_sec);
+
+	return log_writer_cfg;
+}
+
+LogStorageConfig parseLogStorageConfig(const QJsonObject& weather_station_obj, const QString& obj_name)
+{
+	LogStorageConfig log_storage_cfg;
+	if (!weather_station_obj.contains(obj_name))
+		return log_storage_cfg; // Single log file
+
+	if (!weather_station_obj[obj_name].isObject())
+		throw std::runtime_error(QString("%1 is not an object in config file").arg(obj_name).toStdString());
+
+	QJsonObject log_storage_obj = weather_station_obj[obj_name].toObject();
+	log_storage_cfg.segmented = extractBool(log_storage_obj, "segmented");
+	if (log_storage_obj.contains("compress_closed_segments"))
+		log_storage_cfg.compress_closed_segments = extractBool(log_storage_obj, "compress_closed_segments");
+	log_storage_cfg.retention_days = std::max(0, extractOptionalInt(log_storage_obj, "retention_days", log_storage_cfg.retention_days));
+	log_storage_cfg.max_total_mb = std::max(0, extractOptionalInt(log_storage_obj, "max_total_mb", log_storage_cfg.max_total_mb));
+
+	return log_storage_cfg;
+}
+
+LogPipelineConfig parseLogPipelineConfig(const QJsonObject& weather_station_obj, const QString& obj_name)
+{
+	LogPipelineConfig log_pipeline_cfg;
+	if (!weather_station_obj.contains(obj_name))
+		return log_pipeline_cfg; // Main log only
+
+	if (!weather_station_obj[obj_name].isObject())
+		throw std::runtime_error(QString("%1 is not an object in config file").arg(obj_name).toStdString());
+
+	QJsonObject log_pipeline_obj = weather_station_obj[obj_name].toObject();
+	if (log_pipeline_obj.contains("aggregate"))
+		log_pipeline_cfg.aggregate = extractBool(log_pipeline_obj, "aggregate");
+	if (log_pipeline_obj.contains("raw_capture"))
+		log_pipeline_cfg.raw_capture = extractBool(log_pipeline_obj, "raw_capture");
+	if (log_pipeline_obj.contains("events"))
+		log_pipeline_cfg.events = extractBool(log_pipeline_obj, "events");
+	log_pipeline_cfg.queue_capacity = std::max(16, extractOptionalInt(log_pipeline_obj, "queue_capacity", log_pipeline_cfg.queue_capacity));
+
+	return log_pipeline_cfg;
+}
+
+MockConfig parseMockConfig(const QJsonObject& weather_station_obj, const QString& obj_name)
+{
+	MockConfig mock_cfg;
+	if (!weather_station_obj.contains(obj_name))
+		return mock_cfg; // Follow mode
+
+	if (!weather_station_obj[obj_name].isObject())
+		throw std::runtime_error(QString("%1 is not an object in config file").arg(obj_name).toStdString());
+
+	QJsonObject mock_obj = weather_station_obj[obj_name].toObject();
+	mock_cfg.repeat_interval_sec = std::max(1, extractOptionalInt(mock_obj, "repeat_interval_sec", mock_cfg.repeat_interval_sec));
+	if (mock_obj.contains("replay_file"))
+		mock_cfg.replay_file = getConfigPath() + QDir::separator() + extractString(mock_obj, "replay_file");
+	mock_cfg.replay_speed = extractOptionalDouble(mock_obj, "replay_speed", mock_cfg.replay_speed);
+	if (mock_cfg.replay_speed <= 0.0)
+		throw std::runtime_error("replay_speed must be greater than 0 in config file");
+	if (mock_obj.contains("replay_loop"))
+		mock_cfg.replay_loop = extractBool(mock_obj, "replay_loop");
+
+	return mock_cfg;
+}
+
 WeatherStationConfig parseWeatherStationConfig(const QJsonObject& root_obj, const QString& obj_name)
 {
 	if (!root_obj.contains(obj_name) || !root_obj[obj_name].isObject())
@@ -120,6 +260,15 @@ WeatherStationConfig parseWeatherStationConfig(const QJsonObject& root_obj, cons
 	weather_station_cfg.log_frequency_sec = extractInt(weather_station_obj, "log_frequency_sec");
 	weather_station_cfg.watchdog_timeout_sec = extractInt(weather_station_obj, "watchdog_timeout_sec");
 	weather_station_cfg.log_file_path = getConfigPath() + QDir::separator() + extractString(weather_station_obj, "log_file");
+	if (weather_station_obj.contains("log_format"))
+		weather_station_cfg.log_format = parseLogFormat(extractString(weather_station_obj, "log_format"));
+	if (weather_station_obj.contains("log_rollups"))
+		weather_station_cfg.log_rollups = extractBool(weather_station_obj, "log_rollups");
+	weather_station_cfg.delta_filter_cfg = parseDeltaFilterConfig(weather_station_obj, "delta_filter");
+	weather_station_cfg.log_writer_cfg = parseLogWriterConfig(weather_station_obj, "log_writer");
+	weather_station_cfg.log_storage_cfg = parseLogStorageConfig(weather_station_obj, "log_storage");
+	weather_station_cfg.log_pipeline_cfg = parseLogPipelineConfig(weather_station_obj, "log_pipeline");
+	weather_station_cfg.mock_cfg = parseMockConfig(weather_station_obj, "mock");
 
 	return weather_station_cfg;
 }
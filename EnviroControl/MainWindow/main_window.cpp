@@ -8,17 +8,38 @@
 #include "WeatherStation.h"
 #include "WeatherStationMock.h"
 #include "WeatherHistoryWidget.h"
+#include "WeatherHistoryWarmUp.h"
 #include "IndoorStationWidget.h"
 #include "ErrorDetailsWidget.h"
 
 #include <QtCore/QThread>
+#include <QtCore/QMetaObject>
 #include <QtCore/QFile>
 #include <QtWidgets/QStyle>
 #include <QtWidgets/QButtonGroup>
 #include <QtWidgets/QToolButton>
 
+#include <algorithm>
+
 namespace
 {
+// Rings are sized for bursts of the station well above the engine's minimum evaluation interval
+const size_t ENGINE_READER_CAPACITY = 4096;
+const size_t WIDGET_READER_CAPACITY = 256;
+
+// Rules wait at most this long for the history from the log after startup
+const int HISTORY_WARM_UP_MAX_WAIT_SEC = 30;
+
+// Wakes the receiver in its own thread, called from the acquisition thread
+template<typename Receiver>
+std::function<void()> queuedWake(Receiver* receiver)
+{
+	return [receiver]()
+		{
+			QMetaObject::invokeMethod(receiver, &Receiver::onSamplesAvailable, Qt::QueuedConnection);
+		};
+}
+
 QString getStyleSheet(const QString& file_name)
 {
 	QFile style_file(QString(":/styles/style_sheets/%1.qss").arg(file_name));
@@ -51,6 +72,13 @@ MainWindow::MainWindow(const Cfg::Config& cfg, QWidget* parent)
 
 MainWindow::~MainWindow()
 {
+	// Stop the acquisition threads first, they wake widgets owned by the ui
+	for (QThread* thread : { _weather_station_thread, _indoor_station_thread })
+	{
+		thread->quit();
+		thread->wait();
+	}
+
 	delete ui;
 
 	// Clean up weatherforecast
@@ -168,14 +196,25 @@ void MainWindow::initWeatherStationThread()
 		weather_station = new WeatherStation(_cfg.weather_station_cfg);
 	}
 
+	// Samples reach the GUI thread through the channel, every reader gets woken once per burst.
+	// Duration conditions and the history charts (10 s averages) need every sample, averaging only the forwarded
+	// changes would bias the charts towards them. The live display only needs the changes.
+	auto weather_channel = std::make_shared<SampleChannel<WeatherData>>();
+	auto weather_history_widget = new WeatherHistoryWidget(this);
+	_automation_engine->setWeatherSampleReader(weather_channel->subscribe(ENGINE_READER_CAPACITY,
+		queuedWake(_automation_engine), SampleDelivery::FullRate));
+	weather_history_widget->setSampleReader(weather_channel->subscribe(WIDGET_READER_CAPACITY,
+		queuedWake(weather_history_widget), SampleDelivery::FullRate));
+	ui->_weather_station_widget->setSampleReader(weather_channel->subscribe(WIDGET_READER_CAPACITY,
+		queuedWake(ui->_weather_station_widget), SampleDelivery::ChangesOnly));
+	weather_station->setSampleChannel(weather_channel);
+
 	weather_station->moveToThread(_weather_station_thread);
 
 	// Start & finish signals
 	QObject::connect(_weather_station_thread, &QThread::started, weather_station, &IWeatherStation::startReading);
 	QObject::connect(_weather_station_thread, &QThread::finished, weather_station, &QObject::deleteLater);
 
-	// Notify AutomationEngine when weather data is ready
-	QObject::connect(weather_station, &IWeatherStation::weatherDataReady, _automation_engine, &Automation::AutomationEngine::onWeatherStationData);
 	QObject::connect(weather_station, &IWeatherStation::errorOccurred, _automation_engine, [this, weather_station](const QString& error)
 		{
 			weather_station->stopReading(); // Stop reading to avoid further errors
@@ -187,10 +226,15 @@ void MainWindow::initWeatherStationThread()
 	ui->_weather_station_widget->setStyleSheet(getStyleSheet("station_frame"));
 	QObject::connect(weather_station, &IWeatherStation::errorOccurred, _error_details_widget, &ErrorDetailsWidget::onErrorOccurred);
 
-	auto weather_history_widget = new WeatherHistoryWidget(this);
 	ui->_weather_history_layout->addWidget(weather_history_widget);
-	QObject::connect(weather_station, &IWeatherStation::weatherDataReady, weather_history_widget, &WeatherHistoryWidget::onWeatherData);
-	QObject::connect(weather_station, &IWeatherStation::weatherDataReady, ui->_weather_station_widget, &WeatherStationWidget::onWeatherData);
+
+	// Seed the rule and chart histories from the log, without blocking the window from showing
+	auto history_warm_up = new WeatherHistoryWarmUp(_cfg.weather_station_cfg,
+		std::max(_automation_engine->historyLengthSec(), weather_history_widget->historyLengthSec()), this);
+	QObject::connect(history_warm_up, &WeatherHistoryWarmUp::historyLoaded, _automation_engine, &Automation::AutomationEngine::onWeatherHistoryLoaded);
+	QObject::connect(history_warm_up, &WeatherHistoryWarmUp::historyLoaded, weather_history_widget, &WeatherHistoryWidget::onWeatherHistoryLoaded);
+	_automation_engine->waitForWeatherHistory(HISTORY_WARM_UP_MAX_WAIT_SEC);
+	history_warm_up->start();
 
 	_weather_station_thread->start();
 }
@@ -199,14 +243,19 @@ void MainWindow::initIndoorStationThread()
 {
 	_indoor_station_thread = new QThread();
 	auto indoor_station = new IndoorStation(_cfg.indoor_station_cfg);
+
+	auto indoor_channel = std::make_shared<SampleChannel<IndoorData>>();
+	_automation_engine->setIndoorSampleReader(indoor_channel->subscribe(ENGINE_READER_CAPACITY, queuedWake(_automation_engine)));
+	ui->_indoor_station_widget->setSampleReader(indoor_channel->subscribe(WIDGET_READER_CAPACITY, queuedWake(ui->_indoor_station_widget)));
+	indoor_station->setSampleChannel(indoor_channel);
+
 	indoor_station->moveToThread(_indoor_station_thread);
 
 	// Start & finish signals
 	QObject::connect(_indoor_station_thread, &QThread::started, indoor_station, &IndoorStation::startReading);
 	QObject::connect(_indoor_station_thread, &QThread::finished, indoor_station, &QObject::deleteLater);
 
-	// Notify AutomationEngine when indoor data is ready
-	QObject::connect(indoor_station, &IndoorStation::indoorDataReady, _automation_engine, &Automation::AutomationEngine::onIndoorStationData);
+	// Notify AutomationEngine on errors, the data itself is pulled from the sample channel
 	QObject::connect(indoor_station, &IndoorStation::errorOccurred, _automation_engine, [this](const QString& error)
 		{
 			_automation_engine->onError(error);
@@ -214,7 +263,6 @@ void MainWindow::initIndoorStationThread()
 
 	// Connect to widgets
 	ui->_indoor_station_widget->setStyleSheet(ui->_indoor_station_widget->styleSheet() + getStyleSheet("station_frame"));
-	QObject::connect(indoor_station, &IndoorStation::indoorDataReady, ui->_indoor_station_widget, &IndoorStationWidget::onIndoorDataChanged);
 
 	QObject::connect(indoor_station, &IndoorStation::errorOccurred, _error_details_widget, &ErrorDetailsWidget::onErrorOccurred);
 
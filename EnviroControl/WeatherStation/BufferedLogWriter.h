@@ -0,0 +1,55 @@
+#pragma once
+
+#include "ConfigParser.h"
+
+#include <QtCore/QByteArray>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <QtCore/QString>
+
+/*
+* Append-only log file writer, that keeps the file open and collects entries in memory.
+* Entries are written once flush_size_bytes are pending, or when flush() is called (the owner calls it every
+* flush_interval_sec). Afterwards the file is synced according to the fsync policy.
+* If the file was rotated (moved away, replaced or truncated) or a write failed, the file is reopened on the
+* next flush. A replaced file is detected by its identity (device and inode, or volume and file index), so a new
+* file of any size at the path is found. Pending entries are kept until they could be written.
+* Whenever the file is opened, a torn entry at its end is removed first (see WeatherLogRecovery.h).
+*/
+class BufferedLogWriter
+{
+public:
+	BufferedLogWriter(const QString& file_path, const Cfg::LogWriterConfig& cfg);
+	~BufferedLogWriter();
+
+	// Written first, whenever an empty or new file is opened
+	void setFileHeader(const QByteArray& header);
+
+	// Appends a single text entry, a newline is added
+	void append(const QByteArray& entry);
+
+	// Appends bytes as they are (binary records)
+	void appendRaw(const QByteArray& data);
+
+	// Writes all pending entries, returns false if they could not be written
+	bool flush();
+
+	// Flushes and closes the file, it is reopened by the next flush
+	void close();
+
+	qint64 pendingBytes() const;
+	const QString& filePath() const;
+
+private:
+	bool ensureOpen();
+	bool fileWasReplaced() const;
+	void sync(bool force);
+
+	const QString _file_path;
+	const Cfg::LogWriterConfig _cfg;
+	QFile _file;
+	QByteArray _file_header;
+	QByteArray _buffer;
+	qint64 _file_size = 0; // Size after the last own write, a smaller file was truncated
+	QElapsedTimer _last_sync;
+};
@@ -1,9 +1,10 @@
 #pragma once
 
 #include "ConfigParser.h"
+#include "SampleTime.h"
+#include "SampleChannel.h"
 
 #include <QtCore/QObject>
-#include <QtCore/QDateTime>
 #include <QtCore/QPointer>
 
 class QProcess;
@@ -12,14 +13,14 @@ struct IndoorData
 {
 	double temperature = 0.0; // in Celsius
 	double humidity = 0.0;    // in percentage
-	QDateTime timestamp;
+	SampleTime timestamp;
 
 	QString toString() const
 	{
 		return QString("Temperature: %1 C\nHumidity: %2 %\nTimestamp: %3")
 			.arg(temperature)
 			.arg(humidity)
-			.arg(timestamp.toString(Qt::ISODate));
+			.arg(timestamp.toDateTime().toString(Qt::ISODate));
 	};
 };
 
@@ -30,6 +31,9 @@ class IndoorStation : public QObject
 public:
 	IndoorStation(const Cfg::IndoorStationConfig& cfg, QObject* parent = nullptr);
 
+	// Samples are additionally published to the channel. Must be set before the station is moved to its thread.
+	void setSampleChannel(std::shared_ptr<SampleChannel<IndoorData>> channel);
+
 public Q_SLOTS:
 	void startReading();
 	void stopReading();
@@ -44,4 +48,5 @@ private:
 
 	Cfg::IndoorStationConfig _cfg;
 	QPointer<QProcess> _dht_reader_process; // Pointer to the Python process for reading data
+	std::shared_ptr<SampleChannel<IndoorData>> _sample_channel;
 };
\ No newline at end of file
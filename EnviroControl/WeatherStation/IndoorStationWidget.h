@@ -3,9 +3,10 @@
 #include <QtWidgets/QFrame>
 #include <QtCore/QPointer>
 
+#include "IndoorStation.h"
+
 class QLabel;
 
-struct IndoorData;
 class ThermometerWidget;
 
 class IndoorStationWidget : public QFrame
@@ -16,12 +17,18 @@ public:
 	explicit IndoorStationWidget(QWidget* parent = nullptr);
 	~IndoorStationWidget() override;
 
+	// The reader wakes onSamplesAvailable() in the GUI thread
+	void setSampleReader(std::shared_ptr<SampleChannel<IndoorData>::Reader> reader);
+
 public Q_SLOTS:
 	void onIndoorDataChanged(const IndoorData& data);
+	void onSamplesAvailable();
 
 private:
 	void initLayout();
 
+	std::shared_ptr<SampleChannel<IndoorData>::Reader> _sample_reader;
+
 	QPointer<QLabel> _data_label;
 	QPointer<ThermometerWidget> _thermometer_widget;
 };
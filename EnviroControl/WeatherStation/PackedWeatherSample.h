@@ -0,0 +1,84 @@
+#pragma once
+
+#include "WeatherData.h"
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+/*
+* Compact in-memory form of WeatherData for long histories (automation engine, history charts).
+* Values are stored in fixed-point units, rain/twighlight in a bitfield -> 32 bytes per sample instead of ~80.
+* Both parts of the SampleTime are kept, so a packed history is ordered, evicted and measured on the monotonic
+* timeline (SampleTime::timelineMs()) and a wall-clock jump does not reorder it or change a duration.
+* Convert at the API boundary with pack()/unpack().
+*/
+struct PackedWeatherSample
+{
+	qint64 epoch_ms = 0;
+	qint64 steady_ms = SampleTime::NO_STEADY_TIME;
+	int16_t temperature_cc = 0; // 0.01 Celsius
+	uint16_t sun_south_dk = 0;  // 0.01 kLux
+	uint16_t sun_east_dk = 0;   // 0.01 kLux
+	uint16_t sun_west_dk = 0;   // 0.01 kLux
+	uint16_t daylight_dl = 0;   // 0.1 Lux
+	uint16_t wind_cms = 0;      // 0.01 m/s
+	uint8_t twighlight : 1;
+	uint8_t rain : 1;
+
+	PackedWeatherSample() : twighlight(0), rain(0) {}
+
+	static PackedWeatherSample pack(const WeatherData& data)
+	{
+		PackedWeatherSample sample;
+		sample.epoch_ms = data.timestamp.epoch_ms;
+		sample.steady_ms = data.timestamp.steady_ms;
+		sample.temperature_cc = toFixed<int16_t>(data.temperature, 100.0);
+		sample.sun_south_dk = toFixed<uint16_t>(data.sun_south, 100.0);
+		sample.sun_east_dk = toFixed<uint16_t>(data.sun_east, 100.0);
+		sample.sun_west_dk = toFixed<uint16_t>(data.sun_west, 100.0);
+		sample.daylight_dl = toFixed<uint16_t>(data.daylight, 10.0);
+		sample.wind_cms = toFixed<uint16_t>(data.wind, 100.0);
+		sample.twighlight = data.twighlight ? 1 : 0;
+		sample.rain = data.rain ? 1 : 0;
+		return sample;
+	}
+
+	WeatherData unpack() const
+	{
+		WeatherData data;
+		data.temperature = temperature_cc / 100.0;
+		data.sun_south = sun_south_dk / 100.0;
+		data.sun_east = sun_east_dk / 100.0;
+		data.sun_west = sun_west_dk / 100.0;
+		data.twighlight = twighlight != 0;
+		data.daylight = daylight_dl / 10.0;
+		data.wind = wind_cms / 100.0;
+		data.rain = rain != 0;
+		data.timestamp = timestamp();
+		return data;
+	}
+
+	SampleTime timestamp() const
+	{
+		SampleTime time;
+		time.epoch_ms = epoch_ms;
+		time.steady_ms = steady_ms;
+		return time;
+	}
+
+private:
+	// Rounds to the nearest fixed-point step, out of range values are clamped
+	template<typename T>
+	static T toFixed(double value, double scale)
+	{
+		const double scaled = std::round(value * scale);
+		if (!(scaled > std::numeric_limits<T>::min()))
+			return std::numeric_limits<T>::min(); // Also catches NaN
+		if (scaled >= std::numeric_limits<T>::max())
+			return std::numeric_limits<T>::max();
+		return static_cast<T>(scaled);
+	}
+};
+
+static_assert(sizeof(PackedWeatherSample) == 32, "PackedWeatherSample is expected to stay at 32 bytes");
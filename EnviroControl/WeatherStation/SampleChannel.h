@@ -0,0 +1,236 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+/*
+* Lock-free single producer / single consumer ring buffer.
+* The capacity is rounded up to a power of two. If the ring is full, the new sample is dropped and counted,
+* the producer never waits for the consumer.
+*/
+template<typename T>
+class SpscRing
+{
+public:
+	explicit SpscRing(size_t min_capacity) :
+		_capacity(roundUpPowerOfTwo(min_capacity)), _mask(_capacity - 1), _slots(_capacity)
+	{
+	}
+
+	// Producer thread only
+	bool tryPush(const T& value)
+	{
+		const size_t head = _head.load(std::memory_order_relaxed);
+		if (head - _tail.load(std::memory_order_acquire) == _capacity)
+		{
+			_dropped.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+
+		_slots[head & _mask] = value;
+		_head.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Consumer thread only
+	bool tryPop(T& value)
+	{
+		const size_t tail = _tail.load(std::memory_order_relaxed);
+		if (tail == _head.load(std::memory_order_acquire))
+			return false;
+
+		value = _slots[tail & _mask];
+		_tail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	size_t size() const
+	{
+		return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire);
+	}
+
+	size_t capacity() const
+	{
+		return _capacity;
+	}
+
+	uint64_t droppedCount() const
+	{
+		return _dropped.load(std::memory_order_relaxed);
+	}
+
+private:
+	static size_t roundUpPowerOfTwo(size_t value)
+	{
+		size_t capacity = 1;
+		while (capacity < value)
+			capacity <<= 1;
+		return capacity;
+	}
+
+	const size_t _capacity;
+	const size_t _mask;
+	std::vector<T> _slots;
+
+	// Producer and consumer indices on separate cache lines
+	alignas(64) std::atomic<size_t> _head = 0;
+	alignas(64) std::atomic<size_t> _tail = 0;
+	std::atomic<uint64_t> _dropped = 0;
+};
+
+/*
+* Single writer "latest value" cell. Readers never block the writer, they retry if a write happened meanwhile.
+* The value is stored as atomic words, so concurrent reads of a torn value are well defined and get discarded.
+*/
+template<typename T>
+class SeqLockCell
+{
+	static_assert(std::is_trivially_copyable_v<T>, "SeqLockCell needs a trivially copyable type");
+	static constexpr size_t WORD_COUNT = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+public:
+	// Writer thread only
+	void store(const T& value)
+	{
+		std::array<uint64_t, WORD_COUNT> words{};
+		std::memcpy(words.data(), &value, sizeof(T));
+
+		const uint32_t seq = _seq.load(std::memory_order_relaxed);
+		_seq.store(seq + 1, std::memory_order_relaxed); // Odd -> write in progress
+		std::atomic_thread_fence(std::memory_order_release);
+
+		for (size_t i = 0; i < WORD_COUNT; ++i)
+			_words[i].store(words[i], std::memory_order_relaxed);
+
+		_seq.store(seq + 2, std::memory_order_release);
+	}
+
+	// Any thread, returns nullopt until the first store
+	std::optional<T> load() const
+	{
+		std::array<uint64_t, WORD_COUNT> words;
+		uint32_t seq_before = 0;
+		uint32_t seq_after = 0;
+		do
+		{
+			seq_before = _seq.load(std::memory_order_acquire);
+			if (seq_before == 0)
+				return {};
+
+			for (size_t i = 0; i < WORD_COUNT; ++i)
+				words[i] = _words[i].load(std::memory_order_relaxed);
+
+			std::atomic_thread_fence(std::memory_order_acquire);
+			seq_after = _seq.load(std::memory_order_relaxed);
+		} while ((seq_before & 1) != 0 || seq_before != seq_after);
+
+		T value;
+		std::memcpy(&value, words.data(), sizeof(T));
+		return value;
+	}
+
+private:
+	std::atomic<uint32_t> _seq = 0;
+	std::array<std::atomic<uint64_t>, WORD_COUNT> _words{};
+};
+
+// Which samples a reader receives, if the producer marks unchanged samples (see WeatherDeltaFilter)
+enum class SampleDelivery
+{
+	FullRate,   // Every sample
+	ChangesOnly // Only samples marked as changed
+};
+
+/*
+* Hands samples from an acquisition thread to consumers in other threads without locks or event-loop allocations.
+* Every consumer subscribes its own Reader (SPSC ring) and either pulls from it at its own rate,
+* or gets woken through the wake function. The wake function is called in the producer thread, at most once
+* until the reader is drained again, so a burst of samples results in a single wake-up.
+* latest() returns the newest sample to any thread.
+*
+* All subscriptions have to be made before the producer publishes the first sample.
+*/
+template<typename T>
+class SampleChannel
+{
+public:
+	class Reader
+	{
+	public:
+		Reader(size_t capacity, std::function<void()> wake, SampleDelivery delivery) :
+			_ring(capacity), _wake(std::move(wake)), _delivery(delivery)
+		{
+		}
+
+		// Consumer thread only, calls func for every pending sample (oldest first) and returns their number
+		template<typename Func>
+		size_t drain(Func&& func)
+		{
+			// Re-arm the wake-up before draining, samples published meanwhile either get drained now or wake again
+			_wake_pending.store(false, std::memory_order_seq_cst);
+
+			size_t count = 0;
+			T value;
+			while (_ring.tryPop(value))
+			{
+				func(value);
+				++count;
+			}
+			return count;
+		}
+
+		uint64_t droppedCount() const
+		{
+			return _ring.droppedCount();
+		}
+
+	private:
+		friend class SampleChannel;
+
+		void push(const T& value, bool changed)
+		{
+			if (!changed && _delivery == SampleDelivery::ChangesOnly)
+				return;
+
+			_ring.tryPush(value);
+			if (_wake && !_wake_pending.exchange(true, std::memory_order_seq_cst))
+				_wake();
+		}
+
+		SpscRing<T> _ring;
+		std::function<void()> _wake;
+		const SampleDelivery _delivery;
+		std::atomic<bool> _wake_pending = false;
+	};
+
+	std::shared_ptr<Reader> subscribe(size_t capacity, std::function<void()> wake = {}, SampleDelivery delivery = SampleDelivery::FullRate)
+	{
+		auto reader = std::make_shared<Reader>(capacity, std::move(wake), delivery);
+		_readers.push_back(reader);
+		return reader;
+	}
+
+	// Producer thread only. Unchanged samples only reach FullRate readers, latest() always gets updated.
+	void publish(const T& value, bool changed = true)
+	{
+		_latest.store(value);
+		for (const auto& reader : _readers)
+			reader->push(value, changed);
+	}
+
+	std::optional<T> latest() const
+	{
+		return _latest.load();
+	}
+
+private:
+	std::vector<std::shared_ptr<Reader>> _readers;
+	SeqLockCell<T> _latest;
+};
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <QtCore/QDateTime>
+
+#include <chrono>
+#include <limits>
+
+/*
+* Compact timestamp of a sensor sample.
+*  epoch_ms:  UTC wall-clock time in ms since epoch, used for display and logging (QDateTime is only created there)
+*  steady_ms: monotonic clock value captured at frame arrival, used for durations, so they are not affected
+*             by DST changes or wall-clock jumps
+* Durations and ordering use one clock, the timeline (timelineMs()): the steady value mapped to the epoch scale with
+* an offset taken once per process, or the epoch value for samples restored from a log file (no steady value).
+* Live and logged samples can be mixed, a wall-clock jump after the start only shifts the logged samples against
+* the live ones, it never changes the distance between two live samples.
+*/
+struct SampleTime
+{
+	static constexpr qint64 NO_STEADY_TIME = std::numeric_limits<qint64>::min();
+
+	qint64 epoch_ms = 0;
+	qint64 steady_ms = NO_STEADY_TIME;
+
+	static SampleTime now()
+	{
+		SampleTime time;
+		time.epoch_ms = QDateTime::currentMSecsSinceEpoch();
+		time.steady_ms = steadyNowMs();
+		return time;
+	}
+
+	static SampleTime fromEpochMs(qint64 epoch_ms)
+	{
+		SampleTime time;
+		time.epoch_ms = epoch_ms;
+		return time;
+	}
+
+	static SampleTime fromDateTime(const QDateTime& date_time)
+	{
+		return fromEpochMs(date_time.toMSecsSinceEpoch());
+	}
+
+	QDateTime toDateTime() const
+	{
+		return QDateTime::fromMSecsSinceEpoch(epoch_ms);
+	}
+
+	bool hasSteadyTime() const
+	{
+		return steady_ms != NO_STEADY_TIME;
+	}
+
+	// Steady clock on the epoch scale, the epoch value if there is no steady value
+	qint64 timelineMs() const
+	{
+		return hasSteadyTime() ? steady_ms + steadyToEpochOffsetMs() : epoch_ms;
+	}
+
+	// Milliseconds from this sample to other on the timeline (positive if other is newer)
+	qint64 msecsTo(const SampleTime& other) const
+	{
+		return other.timelineMs() - timelineMs();
+	}
+
+	qint64 secsTo(const SampleTime& other) const
+	{
+		return msecsTo(other) / 1000;
+	}
+
+	SampleTime addMSecs(qint64 msecs) const
+	{
+		SampleTime time = *this;
+		time.epoch_ms += msecs;
+		if (hasSteadyTime())
+			time.steady_ms += msecs;
+		return time;
+	}
+
+	// Ordered by the timeline, ties by the epoch and steady values, so the order is strict and transitive
+	bool operator<(const SampleTime& other) const
+	{
+		const qint64 timeline_ms = timelineMs();
+		const qint64 other_timeline_ms = other.timelineMs();
+		if (timeline_ms != other_timeline_ms)
+			return timeline_ms < other_timeline_ms;
+		if (epoch_ms != other.epoch_ms)
+			return epoch_ms < other.epoch_ms;
+		return steady_ms < other.steady_ms;
+	}
+
+	// Wall-clock minus steady clock, taken once, so later wall-clock jumps do not move the timeline
+	static qint64 steadyToEpochOffsetMs()
+	{
+		static const qint64 offset_ms = QDateTime::currentMSecsSinceEpoch() - steadyNowMs();
+		return offset_ms;
+	}
+
+private:
+	static qint64 steadyNowMs()
+	{
+		return std::chrono::duration_cast<std::chrono::milliseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+};
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
+
+/*
+* Fixed-capacity ring buffer, that extracts fixed-length frames from a serial byte stream.
+* A frame starts with start_byte and its last byte is end_byte.
+*
+* The first (frame_length - 1) bytes of the ring are mirrored behind its end, so a frame is always
+* readable as one contiguous block, even if it wraps around. Nothing is shifted or allocated after construction.
+*
+* Frames returned by nextFrame() point into the ring and stay valid until the next write.
+*/
+class SerialFrameBuffer
+{
+public:
+	SerialFrameBuffer(size_t capacity, size_t frame_length, char start_byte, char end_byte);
+	~SerialFrameBuffer();
+
+	SerialFrameBuffer(const SerialFrameBuffer&) = delete;
+	SerialFrameBuffer& operator=(const SerialFrameBuffer&) = delete;
+
+	// Direct write access, e.g. for QIODevice::read(writePtr(), writableSize()) followed by commitWrite()
+	char* writePtr();
+	size_t writableSize() const;
+	void commitWrite(size_t len);
+
+	// Copies as many bytes as fit into the buffer, returns the number of copied bytes
+	size_t write(const char* data, size_t len);
+
+	// Returns the next complete frame, or an empty view if more data is needed
+	std::string_view nextFrame();
+
+	void clear();
+
+	size_t size() const;
+	size_t capacity() const;
+	size_t discardedBytes() const;
+
+private:
+	void consume(size_t len);
+	size_t findStart() const;
+
+	std::unique_ptr<char[]> _data;
+	const size_t _capacity;
+	const size_t _frame_length;
+	const char _start_byte;
+	const char _end_byte;
+
+	size_t _read_pos = 0;
+	size_t _size = 0;
+	size_t _discarded_bytes = 0; // Junk bytes dropped while searching for a frame start
+};
@@ -0,0 +1,295 @@
+#pragma once
+
+#include "SampleTime.h"
+
+#include <QtCore/QtGlobal>
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Monotonic timeline of a sample (SampleTime::timelineMs()): PackedWeatherSample::timestamp(), or timestamp (WeatherData, IndoorData)
+struct SampleTimelineMs
+{
+	template<typename T>
+	qint64 operator()(const T& sample) const
+	{
+		if constexpr (hasTimestampMethod<T>(0))
+			return sample.timestamp().timelineMs();
+		else
+			return sample.timestamp.timelineMs();
+	}
+
+private:
+	template<typename T>
+	static constexpr auto hasTimestampMethod(int) -> decltype(std::declval<const T&>().timestamp(), bool())
+	{
+		return true;
+	}
+
+	template<typename T>
+	static constexpr bool hasTimestampMethod(...)
+	{
+		return false;
+	}
+};
+
+/*
+* Sensor history with a fixed capacity and a maximum age, all storage is allocated in the constructor.
+* Samples are pushed at the new end (O(1)), samples older than max_age_ms relative to the newest sample are
+* evicted from the old end (O(evicted)). Ages are measured on the sample timeline, which is monotonic for live
+* samples, so a wall-clock jump neither flushes nor reorders the buffer. If the buffer is full, the oldest sample is overwritten and counted,
+* the window then gets shorter than max_age_ms, but never allocates.
+*
+* Indexing is newest first (operator[], like the engine's histories and HistoryView), iterating is oldest first
+* (begin/end, like the charts), rbegin/rend iterate newest first. segments() gives the samples as at most two
+* contiguous arrays, oldest first, for tight loops over the raw storage.
+*/
+template<typename T, typename TimelineMsOf = SampleTimelineMs>
+class TimeRingBuffer
+{
+public:
+	using value_type = T;
+
+	// Oldest first
+	class const_iterator
+	{
+	public:
+		using iterator_category = std::bidirectional_iterator_tag;
+		using value_type = T;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const T*;
+		using reference = const T&;
+
+		const_iterator() = default;
+		const_iterator(const TimeRingBuffer* buffer, size_t position) : _buffer(buffer), _position(position)
+		{
+		}
+
+		reference operator*() const
+		{
+			return _buffer->fromOldest(_position);
+		}
+
+		pointer operator->() const
+		{
+			return &_buffer->fromOldest(_position);
+		}
+
+		const_iterator& operator++()
+		{
+			++_position;
+			return *this;
+		}
+
+		const_iterator operator++(int)
+		{
+			const_iterator it = *this;
+			++_position;
+			return it;
+		}
+
+		const_iterator& operator--()
+		{
+			--_position;
+			return *this;
+		}
+
+		const_iterator operator--(int)
+		{
+			const_iterator it = *this;
+			--_position;
+			return it;
+		}
+
+		bool operator==(const const_iterator& other) const
+		{
+			return _position == other._position && _buffer == other._buffer;
+		}
+
+		bool operator!=(const const_iterator& other) const
+		{
+			return !(*this == other);
+		}
+
+	private:
+		const TimeRingBuffer* _buffer = nullptr;
+		size_t _position = 0;
+	};
+
+	using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+	// Contiguous parts of the buffer, oldest first. second is empty, unless the samples wrap around.
+	struct Segments
+	{
+		const T* first = nullptr;
+		size_t first_size = 0;
+		const T* second = nullptr;
+		size_t second_size = 0;
+	};
+
+	TimeRingBuffer(size_t capacity, qint64 max_age_ms) :
+		_slots(capacity > 0 ? capacity : 1), _max_age_ms(max_age_ms)
+	{
+	}
+
+	// Adds the newest sample and evicts the samples, that got too old
+	void push(const T& sample)
+	{
+		// Evicted first, so a full buffer only overwrites samples, that are still within the age
+		evictOlderThan(_timeline_ms_of(sample) - _max_age_ms);
+
+		if (_size == _slots.size())
+		{
+			_slots[_oldest] = sample;
+			_oldest = wrap(_oldest + 1);
+			++_overwritten;
+		}
+		else
+		{
+			_slots[wrap(_oldest + _size)] = sample;
+			++_size;
+		}
+	}
+
+	/*
+	* Adds a sample at the old end (e.g. logged samples behind the live ones). Only taken if it is older than the
+	* oldest sample, within max_age_ms of the newest one and the buffer is not full, so the order is kept.
+	*/
+	bool pushOldest(const T& sample)
+	{
+		if (_size == _slots.size())
+			return false;
+
+		if (_size > 0)
+		{
+			const qint64 timeline_ms = _timeline_ms_of(sample);
+			if (timeline_ms >= _timeline_ms_of(oldest()) || _timeline_ms_of(newest()) - timeline_ms > _max_age_ms)
+				return false;
+		}
+
+		_oldest = wrap(_oldest + _slots.size() - 1);
+		_slots[_oldest] = sample;
+		++_size;
+		return true;
+	}
+
+	// Removes all samples older than timeline_ms from the old end, returns the number of evicted samples
+	size_t evictOlderThan(qint64 timeline_ms)
+	{
+		size_t evicted = 0;
+		while (_size > 0 && _timeline_ms_of(_slots[_oldest]) < timeline_ms)
+		{
+			_oldest = wrap(_oldest + 1);
+			--_size;
+			++evicted;
+		}
+		return evicted;
+	}
+
+	void clear()
+	{
+		_oldest = 0;
+		_size = 0;
+	}
+
+	size_t size() const
+	{
+		return _size;
+	}
+
+	bool empty() const
+	{
+		return _size == 0;
+	}
+
+	size_t capacity() const
+	{
+		return _slots.size();
+	}
+
+	qint64 maxAgeMs() const
+	{
+		return _max_age_ms;
+	}
+
+	// Samples overwritten because the buffer was full, before they reached the maximum age
+	quint64 overwritten() const
+	{
+		return _overwritten;
+	}
+
+	// Newest first, 0 is the newest sample
+	const T& operator[](size_t index) const
+	{
+		return _slots[wrap(_oldest + _size - 1 - index)];
+	}
+
+	// Oldest first, 0 is the oldest sample
+	const T& fromOldest(size_t index) const
+	{
+		return _slots[wrap(_oldest + index)];
+	}
+
+	const T& newest() const
+	{
+		return (*this)[0];
+	}
+
+	const T& oldest() const
+	{
+		return _slots[_oldest];
+	}
+
+	const_iterator begin() const
+	{
+		return const_iterator(this, 0);
+	}
+
+	const_iterator end() const
+	{
+		return const_iterator(this, _size);
+	}
+
+	const_reverse_iterator rbegin() const
+	{
+		return const_reverse_iterator(end());
+	}
+
+	const_reverse_iterator rend() const
+	{
+		return const_reverse_iterator(begin());
+	}
+
+	Segments segments() const
+	{
+		Segments segments;
+		if (_size == 0)
+			return segments;
+
+		segments.first = &_slots[_oldest];
+		segments.first_size = std::min(_size, _slots.size() - _oldest);
+		if (segments.first_size < _size)
+		{
+			segments.second = _slots.data();
+			segments.second_size = _size - segments.first_size;
+		}
+		return segments;
+	}
+
+private:
+	size_t wrap(size_t index) const
+	{
+		return index >= _slots.size() ? index - _slots.size() : index;
+	}
+
+	std::vector<T> _slots;
+	size_t _oldest = 0; // Slot of the oldest sample
+	size_t _size = 0;
+	qint64 _max_age_ms;
+	quint64 _overwritten = 0;
+	TimelineMsOf _timeline_ms_of;
+};
@@ -1,6 +1,9 @@
 #pragma once
 
-#include <QtCore/QDateTime>
+#include "SampleTime.h"
+
+#include <QtCore/QList>
+#include <QtCore/QString>
 
 struct WeatherData
 {
@@ -12,7 +15,7 @@ struct WeatherData
 	double daylight;    // Lux
 	double wind;        // m/s
 	bool rain;
-	QDateTime timestamp;
+	SampleTime timestamp;
 
 	QString toDebugString() const
 	{
@@ -26,4 +29,8 @@ struct WeatherData
 			.arg(wind)
 			.arg(rain ? "Yes" : "No");
 	};
-};
\ No newline at end of file
+};
+
+// Samples delivered to the consumers at once, oldest first (e.g. the logged history, see WeatherHistoryWarmUp).
+// QList is implicitly shared, so a queued connection only copies a reference. Consumers must not modify it.
+using WeatherDataBatch = QList<WeatherData>;
\ No newline at end of file
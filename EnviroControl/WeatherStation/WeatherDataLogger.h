@@ -1,37 +1,76 @@
 #pragma once
 
 #include "WeatherData.h"
+#include "WeatherRollup.h"
 
 #include <QtCore/QObject>
 #include <QtCore/QTimer>
 
+#include <atomic>
+#include <optional>
+
 class QString;
 class QJsonObject;
+class QThread;
+class WeatherLogWriter;
 
-class WeatherData;
-
+/*
+* Lives in the station thread and decides what is logged: the main log entry of each log interval, optionally
+* every raw sample, the interval aggregates and rain/twighlight events. The files are written by a WeatherLogWriter
+* in a dedicated writer thread, fed through a bounded queue. While the writer lags (e.g. a slow SD card), samples
+* for the raw capture are dropped and counted, the drops are reported once per log interval. The rollups and the
+* low-rate entries are always queued, the rollups must see every sample.
+*/
 class WeatherDataLogger : public QObject
 {
 	Q_OBJECT
 
 public:
-	WeatherDataLogger(const QString& file_path, int log_frequency_sec, QObject* parent);
-	~WeatherDataLogger();
+	WeatherDataLogger(const Cfg::WeatherStationConfig& cfg, QObject* parent);
+	~WeatherDataLogger(); // Writes the queued entries before it returns
+
+	// Raw capture samples dropped, because the queue was full
+	quint64 droppedSamples() const;
 
 public Q_SLOTS:
-		void onWeatherDataReady(const WeatherData& data);
+	void onWeatherDataReady(const WeatherData& data);
+	// Every sample, for the aggregates, events, raw capture and rollups
+	void onRawWeatherData(const WeatherData& data);
 
 private Q_SLOTS:
 	void logCurrentData();
+	void flushLogFile();
 
 private:
-	void appendToLogFile(const QJsonObject& entry);
+	template <typename Func>
+	bool post(Func&& func, bool droppable);
+	void detectEvents(const WeatherData& data);
+	void reportDroppedSamples();
 
-	QString _log_file_path;
+	const Cfg::LogPipelineConfig _pipeline_cfg;
+	const bool _log_rollups;
+	QThread* _writer_thread;
+	WeatherLogWriter* _writer; // Lives in _writer_thread
+	std::atomic<int> _queued_writes = 0;
+	quint64 _dropped_samples = 0;
+	quint64 _reported_dropped_samples = 0;
 	QTimer* _log_timer;
+	QTimer* _flush_timer;
 	std::optional<WeatherData> _last_logged_data = std::nullopt;
+	std::optional<RollupBucket> _interval = std::nullopt;  // Aggregate of the current log interval
+	std::optional<WeatherData> _last_raw_data = std::nullopt; // For the events
 
 	// For parsing
 public:
+	// Format of an existing log file, nullopt if the file is missing or empty
+	static std::optional<Cfg::LogFormat> detectLogFormat(const QString& file_path);
+
+	// Reads JSON Lines and binary log files
 	static std::vector<WeatherData> parseWeatherDataFromFile(const QString& file_path);
-};
\ No newline at end of file
+
+	// Converts a log file in either format to the target format
+	static bool convertLogFile(const QString& input_path, const QString& output_path, Cfg::LogFormat target_format);
+
+	static QJsonObject toJsonEntry(const WeatherData& data);
+	static WeatherData fromJsonEntry(const QJsonObject& entry);
+};
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "ConfigParser.h"
+#include "WeatherData.h"
+
+#include <cstdint>
+#include <optional>
+
+/*
+* Change detection after parsing: a sample is forwarded if any field differs from the last forwarded sample
+* by more than its deadband, a boolean flips, or the keyframe interval elapsed. Everything else is suppressed.
+* If disabled, every sample is forwarded.
+* Only the live display and the logger get the forwarded samples. Averaging consumers (history charts) and the
+* duration conditions read the full rate, averages over the changes alone would be biased towards them.
+* The station logs the forwarded and suppressed counts once an hour.
+*/
+class WeatherDeltaFilter
+{
+public:
+	explicit WeatherDeltaFilter(const Cfg::DeltaFilterConfig& cfg);
+
+	// Returns true if the sample should be forwarded to the change consumers
+	bool accept(const WeatherData& data);
+
+	void reset();
+
+	uint64_t forwardedCount() const;
+	uint64_t suppressedCount() const;
+
+private:
+	bool differs(const WeatherData& data) const;
+
+	Cfg::DeltaFilterConfig _cfg;
+	std::optional<WeatherData> _last_forwarded;
+	uint64_t _forwarded_count = 0;
+	uint64_t _suppressed_count = 0;
+};
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "ConfigParser.h"
+#include "WeatherData.h"
+
+#include <QtCore/QObject>
+
+class QThread;
+
+/*
+* Loads the most recent samples from the weather log on a worker thread after startup, so histories
+* (rule engine, charts) do not start empty. historyLoaded is emitted once, queued to the receivers' threads,
+* with the samples of the last history_secs, oldest first (empty if there is no log).
+*/
+class WeatherHistoryWarmUp : public QObject
+{
+	Q_OBJECT
+
+public:
+	WeatherHistoryWarmUp(const Cfg::WeatherStationConfig& cfg, int history_secs, QObject* parent = nullptr);
+	~WeatherHistoryWarmUp();
+
+	void start();
+
+	// Blocking, the samples of the last history_secs
+	static WeatherDataBatch loadRecentHistory(const Cfg::WeatherStationConfig& cfg, int history_secs);
+
+Q_SIGNALS:
+	void historyLoaded(const WeatherDataBatch& history);
+
+private:
+	const Cfg::WeatherStationConfig _cfg;
+	const int _history_secs;
+	QThread* _thread = nullptr;
+};
@@ -4,7 +4,9 @@
 #include <QtCore/QPointer>
 #include <vector>
 
-#include "WeatherData.h"
+#include "PackedWeatherSample.h"
+#include "TimeRingBuffer.h"
+#include "SampleChannel.h"
 
 class QTabWidget;
 
@@ -19,18 +21,29 @@ public:
 	explicit WeatherHistoryWidget(QWidget* parent = nullptr);
 	~WeatherHistoryWidget();
 
+	// The reader wakes onSamplesAvailable() in the GUI thread
+	void setSampleReader(std::shared_ptr<SampleChannel<WeatherData>::Reader> reader);
+
+	int historyLengthSec() const;
+
 public Q_SLOTS:
 	void onWeatherData(const WeatherData& data);
+	void onSamplesAvailable();
+	void onWeatherHistoryLoaded(const WeatherDataBatch& history);
 
 private:
+	bool addWeatherData(const WeatherData& data);
+	void updateCharts();
 	void initLayout();
 
 private:
-	std::shared_ptr<std::vector<WeatherData>> _weather_history;
+	std::shared_ptr<TimeRingBuffer<PackedWeatherSample>> _weather_history;
 		int _history_length_sec;
 
-		// Buffer holding fine-grained incoming WeatherData for a short period before aggregation
-		std::vector<WeatherData> _short_buffer;
+		// Buffer holding fine-grained incoming samples for a short period before aggregation
+		std::vector<PackedWeatherSample> _short_buffer;
+
+	std::shared_ptr<SampleChannel<WeatherData>::Reader> _sample_reader;
 
 	QPointer<QTabWidget> _tab_widget;
 	QPointer<WindRainChartWidget> _wind_rain_chart;
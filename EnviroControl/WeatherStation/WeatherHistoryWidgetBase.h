@@ -1,6 +1,7 @@
 #pragma once
 
-#include "WeatherData.h"
+#include "PackedWeatherSample.h"
+#include "TimeRingBuffer.h"
 
 #include <QtWidgets/QWidget>
 #include <QtCore/QPointer>
@@ -35,7 +36,7 @@ private:
 class WeatherHistoryWidgetBase : public QWidget
 {
 public:
-	explicit WeatherHistoryWidgetBase(std::shared_ptr<std::vector<WeatherData>> weather_history, QWidget* parent = nullptr);
+	explicit WeatherHistoryWidgetBase(std::shared_ptr<TimeRingBuffer<PackedWeatherSample>> weather_history, QWidget* parent = nullptr);
 	~WeatherHistoryWidgetBase();
 
 	// Helper to set a gradient fill on an area series. The topColor will be used
@@ -56,6 +57,6 @@ protected:
 	QPointer<QChart> _chart;
 	QPointer<ScrollableChartView> _chart_view;
 
-	std::shared_ptr<std::vector<WeatherData>> _weather_history;
+	std::shared_ptr<TimeRingBuffer<PackedWeatherSample>> _weather_history;
 	int _display_length_sec;
 };
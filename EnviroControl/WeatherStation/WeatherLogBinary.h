@@ -0,0 +1,73 @@
+#pragma once
+
+#include "WeatherData.h"
+
+#include <QtCore/QByteArray>
+
+#include <cstdint>
+#include <vector>
+
+/*
+* Binary weather log format: a versioned header followed by fixed-size little-endian records.
+*
+* Header (16 bytes):
+*   0  char[4]  magic "ECWL"
+*   4  uint16   format version
+*   6  uint16   record size in bytes
+*   8  uint8[8] reserved, 0
+*
+* Record (RECORD_SIZE bytes, values in the fixed-point units of PackedWeatherSample):
+*   0  int64    timestamp, ms since epoch (UTC)
+*   8  int16    temperature, 0.01 Celsius
+*  10  uint16   sun south, 0.01 kLux
+*  12  uint16   sun east, 0.01 kLux
+*  14  uint16   sun west, 0.01 kLux
+*  16  uint16   daylight, 0.1 Lux
+*  18  uint16   wind, 0.01 m/s
+*  20  uint8    flags: bit 0 twilight, bit 1 rain
+*  21  uint8    reserved, 0
+*  22  uint16   CRC-16 (qChecksum, ISO 3309) of bytes 0-21, since version 2
+*
+* Records are framed by the record size of the header, the checksum detects records torn by a power loss
+* (see WeatherLogRecovery.h). Version 1 files have no checksum, new records appended to them carry one anyway.
+* Readers accept larger record sizes of newer versions and ignore the additional bytes.
+*/
+namespace WeatherLogBinary
+{
+constexpr char MAGIC[4] = { 'E', 'C', 'W', 'L' };
+constexpr uint16_t VERSION = 2;
+constexpr uint16_t FIRST_CHECKSUM_VERSION = 2;
+constexpr int HEADER_SIZE = 16;
+constexpr int RECORD_SIZE = 24;
+constexpr int CHECKSUM_OFFSET = 22;
+
+constexpr uint8_t FLAG_TWILIGHT = 0x01;
+constexpr uint8_t FLAG_RAIN = 0x02;
+
+struct Header
+{
+	uint16_t version = VERSION;
+	uint16_t record_size = RECORD_SIZE;
+};
+
+QByteArray encodeHeader();
+
+// Returns false if data does not start with a valid header
+bool decodeHeader(const char* data, qint64 size, Header& header);
+
+// Writes RECORD_SIZE bytes to out
+void encodeRecord(const WeatherData& data, char* out);
+QByteArray encodeRecord(const WeatherData& data);
+
+// Reads RECORD_SIZE bytes from record
+WeatherData decodeRecord(const char* record);
+
+// Timestamp of a record without decoding the rest, for searching
+qint64 recordTimestamp(const char* record);
+
+// False for torn records: checksum mismatch (version 2+) or no timestamp (all versions)
+bool isValidRecord(const char* record, const Header& header);
+
+// Decodes a complete binary log (header + records). A trailing partial record and torn records are skipped.
+std::vector<WeatherData> decodeLog(const QByteArray& log);
+}
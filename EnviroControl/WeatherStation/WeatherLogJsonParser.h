@@ -0,0 +1,34 @@
+#pragma once
+
+#include "WeatherData.h"
+
+#include <QtCore/QByteArray>
+
+#include <vector>
+
+/*
+* Streaming parser for JSON Lines weather logs (schema in WeatherDataFormat.h).
+* Works directly on the raw bytes, without a QJsonDocument or QString per line. Lines it does not understand
+* (e.g. nested values or escaped keys) fall back to QJsonDocument, so every valid line is read like before.
+*
+* Timestamps without an offset are local time, as written by WeatherDataLogger. The UTC offset is looked up once
+* per local hour and cached, because consecutive lines nearly always share it.
+*/
+namespace WeatherLogJsonParser
+{
+// Minimum chunk size for parallel parsing, smaller buffers are parsed on the calling thread
+static constexpr qint64 MIN_CHUNK_SIZE = 4 * 1024 * 1024;
+
+// Parses a single line (without the newline), returns false for blank or invalid lines
+bool parseLine(const char* begin, const char* end, WeatherData& data);
+
+// Timestamp of a single line, without decoding the other fields. Returns false for blank or invalid lines.
+bool parseTimestamp(const char* begin, const char* end, qint64& epoch_ms);
+
+/*
+* Parses all lines of a JSON Lines buffer, in order. Large buffers are split at line boundaries into chunks of
+* at least MIN_CHUNK_SIZE, that are parsed in parallel (max_threads = 0: one per core).
+*/
+std::vector<WeatherData> parse(const char* data, qint64 size, int max_threads = 0);
+std::vector<WeatherData> parse(const QByteArray& data, int max_threads = 0);
+}
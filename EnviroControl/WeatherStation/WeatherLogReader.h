@@ -0,0 +1,124 @@
+#pragma once
+
+#include "ConfigParser.h"
+#include "WeatherData.h"
+
+#include <QtCore/QByteArray>
+#include <QtCore/QFile>
+
+#include <iterator>
+#include <vector>
+
+/*
+* Lightweight range of log entries inside a memory-mapped weather log. Entries are decoded while iterating.
+* Invalid entries (corrupt JSON lines, binary records failing the checksum or without timestamp) are skipped,
+* like parseWeatherDataFromFile() does, so a damaged entry in the middle of a file never shows up as a sample.
+* A view is only valid as long as the WeatherLogReader it came from is neither refreshed nor destroyed.
+*/
+class WeatherLogView
+{
+public:
+	class Iterator
+	{
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = WeatherData;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const WeatherData*;
+		using reference = const WeatherData&;
+
+		Iterator() = default;
+		Iterator(const WeatherLogView* view, const char* pos); // Moves to the first valid entry at or after pos
+
+		const WeatherData& operator*() const { return _data; }
+		Iterator& operator++();
+		Iterator operator++(int);
+		bool operator==(const Iterator& other) const { return _pos == other._pos; }
+		bool operator!=(const Iterator& other) const { return _pos != other._pos; }
+
+	private:
+		void seekValidEntry();
+
+		const WeatherLogView* _view = nullptr;
+		const char* _pos = nullptr;
+		WeatherData _data{}; // Entry at _pos, decoded once
+	};
+
+	WeatherLogView() = default;
+	WeatherLogView(Cfg::LogFormat format, const char* begin, const char* end, int record_size, int binary_version);
+
+	Iterator begin() const;
+	Iterator end() const;
+
+	bool empty() const;
+	size_t size() const; // Valid entries, decodes the whole range
+	std::vector<WeatherData> toVector() const;
+
+private:
+	friend class Iterator;
+
+	Cfg::LogFormat _format = Cfg::LogFormat::Binary;
+	const char* _begin = nullptr;
+	const char* _end = nullptr;
+	int _record_size = 0;
+	int _binary_version = 0;
+};
+
+/*
+* Memory-maps a weather log (binary or JSON Lines, detected from the file) and serves time ranges out of it.
+* Entries are expected in chronological order (as written by WeatherDataLogger), the range boundaries are found
+* with a binary search over the timestamps, so only the touched part of the file is read.
+* The mapping is a snapshot, refresh() maps entries appended since.
+* openData() serves the same queries out of a log already in memory (e.g. a decompressed log segment).
+*/
+class WeatherLogReader
+{
+public:
+	WeatherLogReader() = default;
+	~WeatherLogReader();
+
+	WeatherLogReader(const WeatherLogReader&) = delete;
+	WeatherLogReader& operator=(const WeatherLogReader&) = delete;
+
+	bool open(const QString& file_path);
+	bool openData(const QByteArray& data);
+	void close();
+
+	// Maps the file again if it grew or changed, returns false if it could not be mapped (always true for openData())
+	bool refresh();
+
+	bool isOpen() const;
+	Cfg::LogFormat format() const;
+
+	// Entries with from <= timestamp < to
+	WeatherLogView query(qint64 from_epoch_ms, qint64 to_epoch_ms) const;
+	WeatherLogView query(const SampleTime& from, const SampleTime& to) const;
+
+	// The newest n entries, oldest first. Fewer, if some of them are invalid.
+	WeatherLogView latest(size_t n) const;
+
+	// All entries
+	WeatherLogView all() const;
+
+private:
+	bool map();
+	void unmap();
+	void detectFormat();
+
+	const char* dataBegin() const;
+	const char* dataEnd() const;
+
+	// First entry position with timestamp >= epoch_ms
+	const char* lowerBound(qint64 epoch_ms) const;
+	const char* lowerBoundBinary(qint64 epoch_ms) const;
+	const char* lowerBoundJsonLines(qint64 epoch_ms) const;
+
+	QFile _file;
+	QByteArray _data; // Only for openData()
+	const uchar* _mapped = nullptr;
+	qint64 _mapped_size = 0;
+	qint64 _valid_size = 0; // Without a torn tail
+	Cfg::LogFormat _format = Cfg::LogFormat::JsonLines;
+	int _record_size = 0;
+	int _binary_version = 0;
+};
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <QtCore/QString>
+
+/*
+* A power loss while appending can leave a torn entry at the end of a log: a partial record or line, or a block
+* the file system allocated but never wrote (zeros or old disk content). Appending after it would corrupt the
+* next entry as well, so the writer truncates the file to its valid prefix before appending.
+*
+* Only the tail is scanned, backwards from the end until the first valid entry and at most as far as a torn append
+* can reach (2 MiB), so recovery stays fast on large files. Damage in the middle of a file, or more invalid data at
+* its end, is left to the readers, which skip invalid entries.
+*  - Binary logs: records are framed by the record size of the header and carry a checksum (WeatherLogBinary.h)
+*  - JSON Lines (weather logs, rollups, events): entries are framed by the newline, valid if it is a JSON object
+*/
+namespace WeatherLogRecovery
+{
+// Size of the valid prefix of a log, including the binary header and the newline of the last valid line.
+// Without a valid entry near the end: the whole log, binary logs up to the last whole record.
+qint64 validSize(const char* data, qint64 size);
+
+// Truncates a torn tail. Returns the number of bytes removed, -1 if the file could not be read or truncated.
+qint64 recoverFile(const QString& file_path);
+}
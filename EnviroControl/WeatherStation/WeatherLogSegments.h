@@ -0,0 +1,104 @@
+#pragma once
+
+#include "ConfigParser.h"
+#include "WeatherData.h"
+
+#include <QtCore/QDate>
+#include <QtCore/QString>
+
+#include <limits>
+#include <vector>
+
+/*
+* One file of the segmented weather log, covering a single local day.
+* The open (active) segment is still written, its last timestamp is only known once it is closed.
+*/
+struct WeatherLogSegment
+{
+	QString file_name; // Relative to the segment directory, without the compression suffix
+	QDate day;
+	Cfg::LogFormat format = Cfg::LogFormat::JsonLines;
+	qint64 first_epoch_ms = 0;
+	qint64 last_epoch_ms = std::numeric_limits<qint64>::max();
+	qint64 size_bytes = 0; // On disk, after compression
+	bool closed = false;
+	bool compressed = false;
+
+	// Whether entries with from <= timestamp < to can be in this segment
+	bool overlaps(qint64 from_epoch_ms, qint64 to_epoch_ms) const
+	{
+		return first_epoch_ms < to_epoch_ms && from_epoch_ms <= last_epoch_ms;
+	}
+
+	QString storedFileName() const;
+};
+
+/*
+* Segment list of the segmented weather log, kept as manifest.json in the segment directory, so startup and
+* range queries know which files to touch without opening them. Segments are ordered by time (oldest first).
+* The manifest is only rewritten when a segment is opened, closed, compressed or removed.
+*/
+class WeatherLogManifest
+{
+public:
+	static constexpr const char* COMPRESSED_SUFFIX = ".z";
+
+	explicit WeatherLogManifest(const QString& directory);
+
+	// Directory of the segments belonging to the configured log file
+	static QString segmentDirectory(const QString& log_file_path);
+
+	// A missing manifest is an empty segment list, returns false if it exists but could not be read
+	bool load();
+	bool save() const;
+
+	const QString& directory() const;
+	QString filePath(const WeatherLogSegment& segment) const;
+
+	const std::vector<WeatherLogSegment>& segments() const;
+	WeatherLogSegment* activeSegment();
+	WeatherLogSegment* findSegment(const QString& file_name);
+
+	// Adds a new active segment, the file name is unique within the manifest
+	WeatherLogSegment& openSegment(const QDate& day, Cfg::LogFormat format, qint64 first_epoch_ms);
+
+	// Adds a closed segment for an existing file (e.g. the former single log file)
+	WeatherLogSegment& addClosedSegment(const WeatherLogSegment& segment);
+
+	void closeActiveSegment(qint64 last_epoch_ms, qint64 size_bytes);
+	void markCompressed(const QString& file_name, qint64 size_bytes);
+	void removeSegment(const QString& file_name);
+
+	// Segments that may hold entries with from <= timestamp < to, oldest first
+	std::vector<WeatherLogSegment> segmentsOverlapping(qint64 from_epoch_ms, qint64 to_epoch_ms) const;
+
+	// Closed segments the retention policy wants removed, oldest first. The active segment counts with its current file size.
+	std::vector<WeatherLogSegment> expiredSegments(const QDate& today, const Cfg::LogStorageConfig& cfg) const;
+
+private:
+	const QString _directory;
+	std::vector<WeatherLogSegment> _segments;
+};
+
+/*
+* Reads the weather log independent of how it is stored: a single file, or segments listed in the manifest.
+* Only the segments overlapping a query are opened, compressed segments are decompressed in memory.
+*/
+class WeatherLogArchive
+{
+public:
+	explicit WeatherLogArchive(const Cfg::WeatherStationConfig& cfg);
+
+	// Entries with from <= timestamp < to, oldest first
+	std::vector<WeatherData> query(qint64 from_epoch_ms, qint64 to_epoch_ms) const;
+
+	// The newest n entries, oldest first
+	std::vector<WeatherData> latest(size_t n) const;
+
+	// Reads a single segment file, compressed or not (qCompress format)
+	static std::vector<WeatherData> readSegment(const QString& file_path, bool compressed, qint64 from_epoch_ms, qint64 to_epoch_ms);
+
+private:
+	const QString _log_file_path;
+	const bool _segmented;
+};
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "BufferedLogWriter.h"
+#include "WeatherData.h"
+#include "WeatherLogSegments.h"
+#include "WeatherRollup.h"
+
+#include <QtCore/QObject>
+#include <QtCore/QThreadPool>
+
+#include <memory>
+
+/*
+* File side of WeatherDataLogger, lives in its writer thread and is only called through the logger's queue,
+* so the requests are handled in the order the samples arrived. Owns all log files:
+*  - main log: single file or daily segments (see WeatherLogSegments.h), one entry per log interval
+*  - raw capture: every sample, same format as the main log, <log>_raw.<jsonl|bin>
+*  - aggregated: min/max/avg of each log interval as RollupBucket JSON, <log>_aggregated.jsonl
+*  - events: rain and twighlight changes, <log>_events.jsonl
+*  - rollups: see WeatherRollup.h
+*/
+class WeatherLogWriter : public QObject
+{
+	Q_OBJECT
+
+public:
+	explicit WeatherLogWriter(const Cfg::WeatherStationConfig& cfg);
+	~WeatherLogWriter();
+
+	// Opens the files, called first in the writer thread. Adopting and compressing segments can take a while.
+	void open();
+	// Writes the pending entries and closes the files
+	void close();
+
+	void writeLogEntry(const WeatherData& data);
+	void writeRawSample(const WeatherData& data); // Raw capture
+	void addToRollups(const WeatherData& data);
+	void writeAggregate(const RollupBucket& interval);
+	void writeEvent(const WeatherData& data, const QString& event);
+	void flush();
+
+	static QString streamFilePath(const QString& log_file_path, const QString& stream, Cfg::LogFormat format);
+
+private:
+	void moveAwayMismatchingLogFile(const QString& file_path);
+	void openWriter(const QString& file_path);
+	static void appendEntry(BufferedLogWriter& writer, Cfg::LogFormat format, const WeatherData& data);
+
+	// Segmented storage
+	void initSegments();
+	void adoptSingleLogFile();
+	void rotateSegment(const WeatherData& data);
+	void closeActiveSegment(qint64 last_epoch_ms);
+	void compressSegment(const WeatherLogSegment& segment);
+	void onSegmentCompressed(const QString& file_name, qint64 size_bytes);
+	void applyRetention();
+
+	const QString _log_file_path;
+	const Cfg::LogFormat _log_format;
+	const Cfg::LogWriterConfig _writer_cfg;
+	const Cfg::LogStorageConfig _storage_cfg;
+	const Cfg::LogPipelineConfig _pipeline_cfg;
+	const bool _log_rollups;
+
+	std::unique_ptr<BufferedLogWriter> _writer;
+	std::unique_ptr<BufferedLogWriter> _raw_writer;        // Only if enabled
+	std::unique_ptr<BufferedLogWriter> _aggregated_writer; // Only if enabled
+	std::unique_ptr<BufferedLogWriter> _event_writer;      // Only if enabled
+	std::unique_ptr<WeatherLogManifest> _manifest;         // Only for segmented storage
+	std::unique_ptr<WeatherRollupStore> _rollups;          // Only if enabled
+	qint64 _last_written_epoch_ms = 0;
+	QThreadPool _compression_pool;
+};
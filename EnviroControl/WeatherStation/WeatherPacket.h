@@ -0,0 +1,114 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <optional>
+
+// Layout and decoding of the 40-byte ASCII packet sent by the weather station
+
+namespace WeatherPacket
+{
+constexpr int PACKET_LENGTH = 40;
+constexpr char START_IDENTIFIER = 'W'; // Start of Weather Data
+constexpr unsigned char END_IDENTIFIER = 0x03; // End identifier 0x03
+constexpr char FLAG_SET = 'J'; // 'J'a / 'N'ein for boolean fields
+
+// Byte offsets for various data fields within the 40-byte packet
+constexpr int TEMP_SIGN_OFFSET = 1;
+constexpr int TEMP_DIGIT1_OFFSET = 2;
+constexpr int TEMP_DIGIT2_OFFSET = 3;
+constexpr int TEMP_DECIMAL_OFFSET = 4; // This is where the decimal point is implied, not a character
+constexpr int TEMP_DIGIT3_OFFSET = 5;
+
+constexpr int SUN_SOUTH_DIGIT1_OFFSET = 6;
+constexpr int SUN_SOUTH_DIGIT2_OFFSET = 7;
+constexpr int SUN_WEST_DIGIT1_OFFSET = 8;
+constexpr int SUN_WEST_DIGIT2_OFFSET = 9;
+constexpr int SUN_EAST_DIGIT1_OFFSET = 10;
+constexpr int SUN_EAST_DIGIT2_OFFSET = 11;
+
+constexpr int TWILIGHT_OFFSET = 12;
+
+constexpr int DAYLIGHT_DIGIT1_OFFSET = 13;
+constexpr int DAYLIGHT_DIGIT2_OFFSET = 14;
+constexpr int DAYLIGHT_DIGIT3_OFFSET = 15;
+
+constexpr int WIND_DIGIT1_OFFSET = 16;
+constexpr int WIND_DIGIT2_OFFSET = 17;
+constexpr int WIND_DECIMAL_OFFSET = 18; // Implied decimal point
+constexpr int WIND_DIGIT3_OFFSET = 19;
+
+constexpr int RAIN_OFFSET = 20;
+
+// Checksum offsets
+constexpr int CHECKSUM_DIGIT1_OFFSET = 35; // Thousands digit
+constexpr int CHECKSUM_DIGIT2_OFFSET = 36; // Hundreds digit
+constexpr int CHECKSUM_DIGIT3_OFFSET = 37; // Tens digit
+constexpr int CHECKSUM_DIGIT4_OFFSET = 38; // Units digit
+constexpr int CHECKSUM_CALC_MAX_BYTE = 35; // Checksum is calculated up to byte 35
+
+// Numeric field, made of up to 3 ASCII digits. Decimal points are implied by the unit.
+struct DigitField
+{
+	std::array<int, 3> offsets;
+	int digit_count;
+};
+
+enum NumericField
+{
+	Temperature, // 0.1 Celsius (without sign)
+	SunSouth,    // kLux
+	SunWest,     // kLux
+	SunEast,     // kLux
+	Daylight,    // Lux
+	Wind,        // 0.1 m/s
+	NumericFieldCount
+};
+
+constexpr std::array<DigitField, NumericFieldCount> NUMERIC_FIELDS = { {
+	{ { TEMP_DIGIT1_OFFSET, TEMP_DIGIT2_OFFSET, TEMP_DIGIT3_OFFSET }, 3 },
+	{ { SUN_SOUTH_DIGIT1_OFFSET, SUN_SOUTH_DIGIT2_OFFSET, 0 }, 2 },
+	{ { SUN_WEST_DIGIT1_OFFSET, SUN_WEST_DIGIT2_OFFSET, 0 }, 2 },
+	{ { SUN_EAST_DIGIT1_OFFSET, SUN_EAST_DIGIT2_OFFSET, 0 }, 2 },
+	{ { DAYLIGHT_DIGIT1_OFFSET, DAYLIGHT_DIGIT2_OFFSET, DAYLIGHT_DIGIT3_OFFSET }, 3 },
+	{ { WIND_DIGIT1_OFFSET, WIND_DIGIT2_OFFSET, WIND_DIGIT3_OFFSET }, 3 },
+} };
+
+// Decoded packet in fixed-point units, as sent by the station
+struct DecodedPacket
+{
+	int16_t temperature_dc = 0; // 0.1 Celsius
+	uint8_t sun_south = 0;      // kLux
+	uint8_t sun_west = 0;       // kLux
+	uint8_t sun_east = 0;       // kLux
+	uint16_t daylight = 0;      // Lux
+	uint16_t wind_dms = 0;      // 0.1 m/s
+	bool twilight = false;
+	bool rain = false;
+};
+
+// Result of the packet validation, in the order the checks are applied
+enum class PacketStatus : uint8_t
+{
+	Valid,
+	InvalidStart,
+	InvalidEnd,
+	InvalidChecksumDigit,
+	ChecksumMismatch,
+	InvalidDigit // Set by the decoder, not by validate()
+};
+
+const char* packetStatusToString(PacketStatus status);
+
+// Checks start identifier, end identifier and checksum of a PACKET_LENGTH byte packet in a single walk over the bytes
+PacketStatus validate(const char* packet);
+
+// Validates count packets in one go (e.g. a burst after a serial stall). results[i] is the status of packets[i].
+// Returns the number of valid packets.
+int validateBatch(const char* const* packets, int count, PacketStatus* results);
+
+// Decodes the data fields of a PACKET_LENGTH byte packet without any allocation.
+// Returns nullopt if a digit position does not contain an ASCII digit.
+// Start, end and checksum are not checked here.
+std::optional<DecodedPacket> decode(const char* packet);
+}
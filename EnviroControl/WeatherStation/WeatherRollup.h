@@ -0,0 +1,136 @@
+#pragma once
+
+#include "ConfigParser.h"
+#include "BufferedLogWriter.h"
+#include "WeatherData.h"
+
+#include <QtCore/QJsonObject>
+
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <optional>
+#include <vector>
+
+enum class RollupResolution
+{
+	Minute,
+	Hour,
+	Day // Local calendar day
+};
+
+static constexpr size_t ROLLUP_RESOLUTION_COUNT = 3;
+
+// Min/max/avg/last of a single field inside a rollup bucket
+struct RollupField
+{
+	double min = 0.0;
+	double max = 0.0;
+	double sum = 0.0;
+	double last = 0.0;
+
+	void add(double value, bool first)
+	{
+		min = first ? value : std::min(min, value);
+		max = first ? value : std::max(max, value);
+		sum = first ? value : sum + value;
+		last = value;
+	}
+
+	double avg(int count) const
+	{
+		return count > 0 ? sum / count : 0.0;
+	}
+};
+
+/*
+* Aggregate of all samples with start <= timestamp < end. Rain and twighlight are counted,
+* count - rain_count samples had no rain.
+*/
+struct RollupBucket
+{
+	qint64 start_epoch_ms = 0;
+	qint64 end_epoch_ms = 0;
+	qint64 last_epoch_ms = 0;
+	int count = 0;
+
+	RollupField temperature;
+	RollupField sun_south;
+	RollupField sun_east;
+	RollupField sun_west;
+	RollupField daylight;
+	RollupField wind;
+	int twighlight_count = 0;
+	int rain_count = 0;
+
+	// Empty bucket of the given resolution, containing epoch_ms
+	static RollupBucket forSample(RollupResolution resolution, qint64 epoch_ms);
+
+	bool contains(qint64 epoch_ms) const
+	{
+		return start_epoch_ms <= epoch_ms && epoch_ms < end_epoch_ms;
+	}
+
+	void add(const WeatherData& data);
+
+	// Average of each field, at the time of the last sample. Rain if any sample had rain, twighlight by majority.
+	WeatherData average() const;
+
+	QJsonObject toJson() const;
+	static RollupBucket fromJson(const QJsonObject& obj);
+};
+
+/*
+* Incrementally maintained minute/hour/day rollups. Every sample updates the open (partial) bucket of each
+* resolution in O(1). A sample outside of the partial bucket completes it and opens the next one.
+* Samples older than the partial bucket are ignored for that resolution.
+*/
+class WeatherRollups
+{
+public:
+	struct CompletedBucket
+	{
+		RollupResolution resolution;
+		RollupBucket bucket;
+	};
+
+	// Returns the buckets completed by this sample, at most one per resolution
+	std::vector<CompletedBucket> add(const WeatherData& data);
+
+	const std::optional<RollupBucket>& partial(RollupResolution resolution) const;
+	void restorePartial(RollupResolution resolution, const RollupBucket& bucket);
+
+private:
+	std::array<std::optional<RollupBucket>, ROLLUP_RESOLUTION_COUNT> _partial;
+};
+
+/*
+* Persists the rollups next to the raw log: one JSON Lines file per resolution with the completed buckets,
+* plus a state file with the partial buckets, so aggregation resumes where it stopped after a restart.
+* Completed buckets are written through a BufferedLogWriter, the state file is rewritten on every flush().
+*/
+class WeatherRollupStore
+{
+public:
+	WeatherRollupStore(const QString& log_file_path, const Cfg::LogWriterConfig& cfg);
+	~WeatherRollupStore();
+
+	void add(const WeatherData& data);
+
+	// Writes the completed buckets, then the partial state
+	void flush();
+
+	static QString rollupDirectory(const QString& log_file_path);
+
+	// Buckets with from <= start < to, oldest first. The persisted partial bucket is included, if in range.
+	// The file is searched by time, only the buckets in range are parsed.
+	static std::vector<RollupBucket> query(const QString& log_file_path, RollupResolution resolution, qint64 from_epoch_ms, qint64 to_epoch_ms);
+
+private:
+	void restoreState();
+	void saveState() const;
+
+	const QString _directory;
+	WeatherRollups _rollups;
+	std::array<std::unique_ptr<BufferedLogWriter>, ROLLUP_RESOLUTION_COUNT> _writers;
+};
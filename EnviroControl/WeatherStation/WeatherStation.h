@@ -2,8 +2,14 @@
 
 #include "WeatherDataLogger.h"
 #include "ConfigParser.h"
+#include "SerialFrameBuffer.h"
+#include "WeatherPacket.h"
+#include "SampleChannel.h"
+#include "WeatherDeltaFilter.h"
+#include "WeatherData.h"
 
 #include <QtCore/QDateTime>
+#include <QtCore/QElapsedTimer>
 #include <QtCore/QObject>
 #include <QtSerialPort/QSerialPort>
 #include <QtCore/QByteArray>
@@ -14,8 +20,6 @@ namespace Cfg
 struct WeatherStationConfig;
 }
 
-class WeatherData;
-
 class IWeatherStation : public QObject
 {
 	Q_OBJECT
@@ -24,22 +28,37 @@ public:
 	IWeatherStation(const Cfg::WeatherStationConfig& cfg, QObject* parent = nullptr);
 	~IWeatherStation();
 
+	// Samples are handed to consumers in other threads through the channel.
+	// Must be set before the station is moved to its thread.
+	void setSampleChannel(std::shared_ptr<SampleChannel<WeatherData>> channel);
+
 public Q_SLOTS:
 	virtual void startReading() = 0;
 	virtual void stopReading() = 0;
 
 Q_SIGNALS:
+	// Emitted for every parsed sample, for listeners that need the full rate
+	void rawWeatherDataReady(const WeatherData& data);
+	// Emitted for every sample passing the delta filter, intended for listeners in the station thread (logger)
 	void weatherDataReady(const WeatherData& data);
 	void errorOccurred(const QString& error);
 
 protected:
+	void publishWeatherData(const WeatherData& data);
+
 	Cfg::WeatherStationConfig _cfg;
 	WeatherDataLogger _data_logger;
+	WeatherDeltaFilter _delta_filter;
 
 private:
 	void initWatchdog();
+	void reportDeltaFilterStatistics();
 
 	QTimer* _watchdog;
+	QElapsedTimer _delta_filter_report_timer;
+	uint64_t _reported_forwarded_count = 0;
+	uint64_t _reported_suppressed_count = 0;
+	std::shared_ptr<SampleChannel<WeatherData>> _sample_channel;
 	QDateTime _last_data_timestamp;
 };
 
@@ -55,12 +74,15 @@ public Q_SLOTS:
 	void startReading() override;
 	void stopReading() override;
 
+Q_SIGNALS:
+	void packetRejected(WeatherPacket::PacketStatus status);
+
 private:
 	void initSerialPort();
 	void handleReadyRead();
-	std::optional<WeatherData> parseWeatherData(QByteArray data);
-	bool compareChecksum(const QByteArray& data) const;
+	std::optional<WeatherData> parseWeatherData(const char* packet);
+	void rejectPacket(const char* packet, WeatherPacket::PacketStatus status);
 
 	QSerialPort* _port = nullptr;
-	QByteArray _read_buffer;
+	SerialFrameBuffer _frame_buffer;
 };
\ No newline at end of file
@@ -1,7 +1,18 @@
 #pragma once
 
 #include "WeatherStation.h"
+#include "WeatherLogReader.h"
 
+#include <optional>
+
+class QFileSystemWatcher;
+
+/*
+* Follow mode: the mock file is only read when the file system watcher reports a change, then just its newest
+* entry is decoded. In between, the cached entry is repeated every repeat_interval_sec, without file access.
+* Replay mode: the entries of a recorded log are emitted one after the other, at their original cadence
+* divided by the replay speed.
+*/
 class WeatherStationMock : public IWeatherStation
 {
 	Q_OBJECT
@@ -15,9 +26,23 @@ public Q_SLOTS:
 	void stopReading() override;
 
 private Q_SLOTS:
-	void readAndEmitLatestMockData();
+	void onMockFileChanged();
+	void emitLatestMockData();
+	void emitNextReplayData();
 
 private:
+	void startFollowing();
+	void startReplay();
+	void watchMockFile();
+
+	const Cfg::MockConfig _mock_cfg;
 	QTimer* _read_timer = nullptr;
 	const QString _mock_file_path;
-};
\ No newline at end of file
+	WeatherLogReader _mock_file_reader;
+	QFileSystemWatcher* _file_watcher = nullptr;
+	std::optional<WeatherData> _latest_data;
+
+	// Replay mode
+	WeatherLogView _replay_view;
+	WeatherLogView::Iterator _replay_pos;
+};
@@ -4,6 +4,7 @@
 #include <QtCore/QPointer>
 
 #include "WeatherData.h"
+#include "SampleChannel.h"
 
 class WindWheelWidget;
 class SunPlotWidget;
@@ -17,13 +18,19 @@ public:
 	explicit WeatherStationWidget(QWidget* parent = nullptr);
 	~WeatherStationWidget();
 
+	// The reader wakes onSamplesAvailable() in the GUI thread
+	void setSampleReader(std::shared_ptr<SampleChannel<WeatherData>::Reader> reader);
+
 public Q_SLOTS:
 	void onWeatherData(const WeatherData& data);
+	void onSamplesAvailable();
 
 private:
 	void initLayout();
 	void updateDisplay(const WeatherData& data);
 
+	std::shared_ptr<SampleChannel<WeatherData>::Reader> _sample_reader;
+
 	QPointer<WindWheelWidget> _wind_wheel_widget;
 	QPointer<SunPlotWidget> _sun_plot_widget;
 	QPointer<ThermometerWidget> _thermometer_widget;
@@ -15,7 +15,7 @@ class WindRainChartWidget : public WeatherHistoryWidgetBase
   Q_OBJECT
 
 public:
-  explicit WindRainChartWidget(std::shared_ptr<std::vector<WeatherData>> weather_history, QWidget* parent = nullptr);
+  explicit WindRainChartWidget(std::shared_ptr<TimeRingBuffer<PackedWeatherSample>> weather_history, QWidget* parent = nullptr);
   ~WindRainChartWidget();
 
 private:
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <functional>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Minimal timing helper for the micro benchmarks (no external benchmark library needed on the pi)
+
+namespace Bench
+{
+// Prevents the compiler from optimizing away a computed value
+template <typename T>
+inline void doNotOptimize(const T& value)
+{
+#ifdef _MSC_VER
+	const volatile char sink = *reinterpret_cast<const volatile char*>(&value);
+	(void)sink;
+	_ReadWriteBarrier();
+#else
+	asm volatile("" : : "r,m"(value) : "memory");
+#endif
+}
+
+// Runs func iterations times and prints the average time per iteration, returns ns per iteration
+inline double run(const char* name, long long iterations, const std::function<void()>& func)
+{
+	// Warm-up
+	for (long long i = 0; i < iterations / 10; ++i)
+		func();
+
+	const auto start = std::chrono::steady_clock::now();
+	for (long long i = 0; i < iterations; ++i)
+		func();
+	const auto end = std::chrono::steady_clock::now();
+
+	const double total_ns = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+	const double ns_per_iteration = total_ns / static_cast<double>(iterations);
+	std::printf("%-40s %12.1f ns/iter (%lld iterations)\n", name, ns_per_iteration, iterations);
+	return ns_per_iteration;
+}
+}
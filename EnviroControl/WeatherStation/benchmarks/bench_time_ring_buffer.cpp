@@ -0,0 +1,97 @@
+#include "Benchmark.h"
+
+#include "PackedWeatherSample.h"
+#include "TimeRingBuffer.h"
+
+#include <cstdio>
+#include <deque>
+#include <vector>
+
+namespace
+{
+// One hour of samples at 20 Hz, far above the station rate
+const qint64 HISTORY_MS = 3600 * 1000;
+const qint64 SAMPLE_INTERVAL_MS = 50;
+const size_t CAPACITY = HISTORY_MS / SAMPLE_INTERVAL_MS + 1;
+
+PackedWeatherSample sampleAt(qint64 epoch_ms)
+{
+	PackedWeatherSample sample;
+	sample.epoch_ms = epoch_ms;
+	sample.wind_cms = static_cast<uint16_t>(epoch_ms % 3000);
+	return sample;
+}
+
+// The previous engine history: newest at the front, too old samples popped from the back
+void pushDeque(std::deque<PackedWeatherSample>& history, const PackedWeatherSample& sample)
+{
+	history.push_front(sample);
+	while (!history.empty() && sample.epoch_ms - history.back().epoch_ms > HISTORY_MS)
+		history.pop_back();
+}
+
+// The previous chart history: oldest first, too old samples erased from the front
+void pushVector(std::vector<PackedWeatherSample>& history, const PackedWeatherSample& sample)
+{
+	history.push_back(sample);
+	while (!history.empty() && sample.epoch_ms - history.front().epoch_ms > HISTORY_MS)
+		history.erase(history.begin());
+}
+}
+
+int main()
+{
+	const long long iterations = 2000000;
+
+	// Filled up, every push evicts a sample
+	std::deque<PackedWeatherSample> deque_history;
+	std::vector<PackedWeatherSample> vector_history;
+	TimeRingBuffer<PackedWeatherSample> ring_history(CAPACITY, HISTORY_MS);
+	qint64 deque_time = 0, vector_time = 0, ring_time = 0;
+	for (size_t i = 0; i < CAPACITY; ++i)
+	{
+		pushDeque(deque_history, sampleAt(deque_time += SAMPLE_INTERVAL_MS));
+		pushVector(vector_history, sampleAt(vector_time += SAMPLE_INTERVAL_MS));
+		ring_history.push(sampleAt(ring_time += SAMPLE_INTERVAL_MS));
+	}
+
+	const double deque_ns = Bench::run("deque push + evict", iterations, [&]()
+		{
+			pushDeque(deque_history, sampleAt(deque_time += SAMPLE_INTERVAL_MS));
+		});
+
+	const double vector_ns = Bench::run("vector push + erase front", iterations / 100, [&]()
+		{
+			pushVector(vector_history, sampleAt(vector_time += SAMPLE_INTERVAL_MS));
+		});
+
+	const double ring_ns = Bench::run("TimeRingBuffer push + evict", iterations, [&]()
+		{
+			ring_history.push(sampleAt(ring_time += SAMPLE_INTERVAL_MS));
+		});
+
+	// Full scan, e.g. a chart update
+	const double scan_deque_ns = Bench::run("deque scan", 200, [&]()
+		{
+			quint64 sum = 0;
+			for (const auto& sample : deque_history)
+				sum += sample.wind_cms;
+			Bench::doNotOptimize(sum);
+		});
+
+	const double scan_ring_ns = Bench::run("TimeRingBuffer segment scan", 200, [&]()
+		{
+			quint64 sum = 0;
+			const auto segments = ring_history.segments();
+			for (size_t i = 0; i < segments.first_size; ++i)
+				sum += segments.first[i].wind_cms;
+			for (size_t i = 0; i < segments.second_size; ++i)
+				sum += segments.second[i].wind_cms;
+			Bench::doNotOptimize(sum);
+		});
+
+	std::printf("push speedup vs deque: %.1fx, vs vector: %.1fx\n", deque_ns / ring_ns, vector_ns / ring_ns);
+	std::printf("scan speedup vs deque: %.1fx\n", scan_deque_ns / scan_ring_ns);
+	std::printf("samples: %zu, overwritten: %llu\n", ring_history.size(), static_cast<unsigned long long>(ring_history.overwritten()));
+	return 0;
+}
@@ -0,0 +1,108 @@
+#include "Benchmark.h"
+
+#include "WeatherDataLogger.h"
+#include "WeatherLogJsonParser.h"
+
+#include <QtCore/QByteArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+#include <QtCore/QList>
+#include <QtCore/QThread>
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+// One year of entries, one per minute (as with log_frequency_sec = 60)
+const int ENTRY_COUNT = 365 * 24 * 60;
+
+QByteArray createYearLog()
+{
+	QByteArray content;
+	content.reserve(ENTRY_COUNT * 200);
+
+	const qint64 start_ms = 1735689600000; // 2025-01-01
+	for (int i = 0; i < ENTRY_COUNT; ++i)
+	{
+		WeatherData data{};
+		data.timestamp = SampleTime::fromEpochMs(start_ms + i * 60000LL);
+		data.temperature = 10.0 + 8.0 * std::sin(i / 229.0);
+		data.sun_south = (i % 1440) / 20.0;
+		data.sun_east = (i % 720) / 10.0;
+		data.sun_west = (i % 360) / 5.0;
+		data.twighlight = (i % 1440) < 30;
+		data.daylight = (i % 1440) * 0.5;
+		data.wind = (i % 97) / 10.0;
+		data.rain = (i % 1000) < 50;
+
+		content.append(QJsonDocument(WeatherDataLogger::toJsonEntry(data)).toJson(QJsonDocument::Compact));
+		content.append('\n');
+	}
+	return content;
+}
+
+// The previous parser of WeatherDataLogger::parseWeatherDataFromFile: QString + QJsonDocument per line
+std::vector<WeatherData> legacyParse(const QByteArray& content)
+{
+	std::vector<WeatherData> weather_data_list;
+	const QList<QByteArray> lines = content.split('\n');
+	for (const QByteArray& raw_line : lines)
+	{
+		QString line = QString::fromUtf8(raw_line).trimmed();
+		if (line.isEmpty())
+			continue;
+
+		QJsonDocument doc = QJsonDocument::fromJson(line.toUtf8());
+		if (!doc.isObject())
+			continue;
+
+		weather_data_list.push_back(WeatherDataLogger::fromJsonEntry(doc.object()));
+	}
+	return weather_data_list;
+}
+}
+
+int main()
+{
+	std::printf("Creating a 1-year log (%d entries)...\n", ENTRY_COUNT);
+	const QByteArray content = createYearLog();
+	std::printf("Log size: %.1f MB, %d cores\n", content.size() / (1024.0 * 1024.0), QThread::idealThreadCount());
+
+	const auto legacy = legacyParse(content);
+	const auto streaming = WeatherLogJsonParser::parse(content);
+	if (legacy.size() != streaming.size())
+	{
+		std::printf("Parsers disagree on the entry count: %zu vs %zu\n", legacy.size(), streaming.size());
+		return 1;
+	}
+	for (size_t i = 0; i < legacy.size(); ++i)
+	{
+		if (legacy[i].timestamp.epoch_ms != streaming[i].timestamp.epoch_ms || legacy[i].temperature != streaming[i].temperature ||
+			legacy[i].rain != streaming[i].rain || legacy[i].daylight != streaming[i].daylight)
+		{
+			std::printf("Parsers disagree at entry %zu\n", i);
+			return 1;
+		}
+	}
+
+	const long long iterations = 3;
+	const double legacy_ns = Bench::run("legacy QJsonDocument parse", iterations, [&]()
+		{
+			Bench::doNotOptimize(legacyParse(content).size());
+		});
+
+	const double single_ns = Bench::run("streaming parse, 1 thread", iterations, [&]()
+		{
+			Bench::doNotOptimize(WeatherLogJsonParser::parse(content, 1).size());
+		});
+
+	const double parallel_ns = Bench::run("streaming parse, all cores", iterations, [&]()
+		{
+			Bench::doNotOptimize(WeatherLogJsonParser::parse(content).size());
+		});
+
+	std::printf("speedup 1 thread: %.1fx, all cores: %.1fx\n", legacy_ns / single_ns, legacy_ns / parallel_ns);
+	return 0;
+}
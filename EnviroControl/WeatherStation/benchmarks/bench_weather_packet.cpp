@@ -0,0 +1,107 @@
+#include "Benchmark.h"
+
+#include "WeatherPacket.h"
+#include "WeatherData.h"
+
+#include <QtCore/QByteArray>
+#include <QtCore/QString>
+
+#include <cstdio>
+
+using namespace WeatherPacket;
+
+namespace
+{
+QByteArray createPacket()
+{
+	//                     0         1         2         3
+	//                     0123456789012345678901234567890123456789
+	QByteArray packet("W+21.4120507N99912.5N000000000000000000000");
+	packet.resize(PACKET_LENGTH);
+
+	unsigned int checksum = 0;
+	for (int i = 0; i < CHECKSUM_CALC_MAX_BYTE; ++i)
+		checksum += static_cast<unsigned char>(packet.at(i));
+
+	const QByteArray checksum_str = QByteArray::number(checksum).rightJustified(4, '0');
+	packet.replace(CHECKSUM_DIGIT1_OFFSET, 4, checksum_str);
+	packet[PACKET_LENGTH - 1] = static_cast<char>(END_IDENTIFIER);
+	return packet;
+}
+
+// The previous QString based implementation of WeatherStation::parseWeatherData (without validation)
+WeatherData legacyParse(const QByteArray& data)
+{
+	WeatherData weather_data;
+
+	QString temp_sign = (data.at(TEMP_SIGN_OFFSET) == '-') ? "-" : "";
+	QString temp_str = temp_sign + QString(data.at(TEMP_DIGIT1_OFFSET)) +
+		QString(data.at(TEMP_DIGIT2_OFFSET)) +
+		QString(data.at(TEMP_DECIMAL_OFFSET)) +
+		QString(data.at(TEMP_DIGIT3_OFFSET));
+	weather_data.temperature = temp_str.toDouble();
+
+	weather_data.sun_south = (QString(data.at(SUN_SOUTH_DIGIT1_OFFSET)) + QString(data.at(SUN_SOUTH_DIGIT2_OFFSET))).toDouble();
+	weather_data.sun_west = (QString(data.at(SUN_WEST_DIGIT1_OFFSET)) + QString(data.at(SUN_WEST_DIGIT2_OFFSET))).toDouble();
+	weather_data.sun_east = (QString(data.at(SUN_EAST_DIGIT1_OFFSET)) + QString(data.at(SUN_EAST_DIGIT2_OFFSET))).toDouble();
+
+	weather_data.twighlight = (data.at(TWILIGHT_OFFSET) == 'J');
+
+	weather_data.daylight = (QString(data.at(DAYLIGHT_DIGIT1_OFFSET)).toInt() * 100) +
+		(QString(data.at(DAYLIGHT_DIGIT2_OFFSET)).toInt() * 10) +
+		QString(data.at(DAYLIGHT_DIGIT3_OFFSET)).toInt();
+
+	QString wind_str = QString(data.at(WIND_DIGIT1_OFFSET)) +
+		QString(data.at(WIND_DIGIT2_OFFSET)) +
+		"." + QString(data.at(WIND_DIGIT3_OFFSET));
+	weather_data.wind = wind_str.toDouble();
+
+	weather_data.rain = (data.at(RAIN_OFFSET) == 'J');
+
+	return weather_data;
+}
+
+WeatherData fixedPointParse(const QByteArray& data)
+{
+	WeatherData weather_data{};
+	if (const auto packet = decode(data.constData()))
+	{
+		weather_data.temperature = packet->temperature_dc / 10.0;
+		weather_data.sun_south = packet->sun_south;
+		weather_data.sun_west = packet->sun_west;
+		weather_data.sun_east = packet->sun_east;
+		weather_data.twighlight = packet->twilight;
+		weather_data.daylight = packet->daylight;
+		weather_data.wind = packet->wind_dms / 10.0;
+		weather_data.rain = packet->rain;
+	}
+	return weather_data;
+}
+}
+
+int main()
+{
+	const QByteArray packet = createPacket();
+	const long long iterations = 1000000;
+
+	const WeatherData legacy = legacyParse(packet);
+	const WeatherData fixed_point = fixedPointParse(packet);
+	if (legacy.temperature != fixed_point.temperature || legacy.wind != fixed_point.wind || legacy.daylight != fixed_point.daylight)
+	{
+		std::printf("Decoders disagree: %s vs %s\n", qPrintable(legacy.toDebugString()), qPrintable(fixed_point.toDebugString()));
+		return 1;
+	}
+
+	const double legacy_ns = Bench::run("legacy QString parse", iterations, [&]()
+		{
+			Bench::doNotOptimize(legacyParse(packet));
+		});
+
+	const double fixed_point_ns = Bench::run("fixed-point decode", iterations, [&]()
+		{
+			Bench::doNotOptimize(fixedPointParse(packet));
+		});
+
+	std::printf("speedup: %.1fx\n", legacy_ns / fixed_point_ns);
+	return 0;
+}
@@ -0,0 +1,97 @@
+#include "Benchmark.h"
+
+#include "WeatherRollup.h"
+
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QTemporaryDir>
+
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+// A month of minute buckets
+const int BUCKET_COUNT = 30 * 24 * 60;
+const qint64 START_MS = 1735689600000; // 2025-01-01
+
+bool createMinuteRollups(const QString& log_file_path)
+{
+	const QString directory = WeatherRollupStore::rollupDirectory(log_file_path);
+	QDir().mkpath(directory);
+	QFile file(QDir(directory).filePath("rollup_minute.jsonl"));
+	if (!file.open(QIODevice::WriteOnly))
+		return false;
+
+	for (int i = 0; i < BUCKET_COUNT; ++i)
+	{
+		RollupBucket bucket = RollupBucket::forSample(RollupResolution::Minute, START_MS + i * 60000LL);
+		WeatherData data{};
+		data.temperature = 10.0 + (i % 600) / 100.0;
+		data.timestamp = SampleTime::fromEpochMs(START_MS + i * 60000LL);
+		bucket.add(data);
+		file.write(QJsonDocument(bucket.toJson()).toJson(QJsonDocument::Compact));
+		file.write("\n");
+	}
+	return true;
+}
+
+// The previous query: every line parsed from the start of the file
+std::vector<RollupBucket> linearQuery(const QString& log_file_path, qint64 from_epoch_ms, qint64 to_epoch_ms)
+{
+	std::vector<RollupBucket> buckets;
+	QFile file(QDir(WeatherRollupStore::rollupDirectory(log_file_path)).filePath("rollup_minute.jsonl"));
+	if (!file.open(QIODevice::ReadOnly))
+		return buckets;
+
+	while (!file.atEnd())
+	{
+		const QJsonDocument doc = QJsonDocument::fromJson(file.readLine().trimmed());
+		if (!doc.isObject())
+			continue;
+
+		const RollupBucket bucket = RollupBucket::fromJson(doc.object());
+		if (bucket.start_epoch_ms >= to_epoch_ms)
+			break;
+		if (bucket.start_epoch_ms >= from_epoch_ms)
+			buckets.push_back(bucket);
+	}
+	return buckets;
+}
+}
+
+int main()
+{
+	QTemporaryDir dir;
+	const QString log_file_path = dir.filePath("weather_log.json");
+	std::printf("Creating a month of minute rollups (%d buckets)...\n", BUCKET_COUNT);
+	if (!createMinuteRollups(log_file_path))
+	{
+		std::printf("Failed to write the rollup file\n");
+		return 1;
+	}
+
+	// The last hour, as a chart of the recent history would ask for
+	const qint64 to_ms = START_MS + BUCKET_COUNT * 60000LL;
+	const qint64 from_ms = to_ms - 3600 * 1000;
+	if (linearQuery(log_file_path, from_ms, to_ms).size() != 60 ||
+		WeatherRollupStore::query(log_file_path, RollupResolution::Minute, from_ms, to_ms).size() != 60)
+	{
+		std::printf("Queries did not return the last hour\n");
+		return 1;
+	}
+
+	const double linear_ns = Bench::run("linear query, last hour", 3, [&]()
+		{
+			Bench::doNotOptimize(linearQuery(log_file_path, from_ms, to_ms).size());
+		});
+
+	const double seek_ns = Bench::run("seeking query, last hour", 100, [&]()
+		{
+			Bench::doNotOptimize(WeatherRollupStore::query(log_file_path, RollupResolution::Minute, from_ms, to_ms).size());
+		});
+
+	std::printf("speedup: %.1fx\n", linear_ns / seek_ns);
+	return 0;
+}
@@ -0,0 +1,196 @@
+#include "BufferedLogWriter.h"
+#include "WeatherLogRecovery.h"
+
+#include <QtCore/QFileInfo>
+#include <QtCore/QDebug>
+
+#ifdef Q_OS_WIN
+#include <io.h>
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Pending entries are dropped beyond this size, if the file can not be written for a long time
+static const qint64 MAX_PENDING_BYTES = 1024 * 1024;
+
+namespace
+{
+// True if the path still refers to the open file. If the open file can not be identified, it is kept.
+bool isSameFile(const QFile& file, const QString& file_path)
+{
+#ifdef Q_OS_WIN
+	BY_HANDLE_FILE_INFORMATION open_info;
+	if (!GetFileInformationByHandle(reinterpret_cast<HANDLE>(_get_osfhandle(file.handle())), &open_info))
+		return true;
+
+	// No access rights needed to read the file index, all sharing modes, so the writer's handle is not disturbed
+	const HANDLE path_handle = CreateFileW(reinterpret_cast<const wchar_t*>(file_path.utf16()), 0,
+		FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (path_handle == INVALID_HANDLE_VALUE)
+		return false;
+
+	BY_HANDLE_FILE_INFORMATION path_info;
+	const bool identified = GetFileInformationByHandle(path_handle, &path_info);
+	CloseHandle(path_handle);
+	return !identified || (open_info.dwVolumeSerialNumber == path_info.dwVolumeSerialNumber
+		&& open_info.nFileIndexHigh == path_info.nFileIndexHigh && open_info.nFileIndexLow == path_info.nFileIndexLow);
+#else
+	struct stat open_stat;
+	if (::fstat(file.handle(), &open_stat) != 0)
+		return true;
+
+	struct stat path_stat;
+	if (::stat(QFile::encodeName(file_path).constData(), &path_stat) != 0)
+		return false;
+
+	return open_stat.st_dev == path_stat.st_dev && open_stat.st_ino == path_stat.st_ino;
+#endif
+}
+}
+
+BufferedLogWriter::BufferedLogWriter(const QString& file_path, const Cfg::LogWriterConfig& cfg) :
+	_file_path(file_path), _cfg(cfg), _file(file_path)
+{
+	_buffer.reserve(_cfg.flush_size_bytes + 512);
+}
+
+BufferedLogWriter::~BufferedLogWriter()
+{
+	close();
+}
+
+void BufferedLogWriter::setFileHeader(const QByteArray& header)
+{
+	_file_header = header;
+}
+
+void BufferedLogWriter::append(const QByteArray& entry)
+{
+	appendRaw(entry + '\n');
+}
+
+void BufferedLogWriter::appendRaw(const QByteArray& data)
+{
+	if (_buffer.size() + data.size() > MAX_PENDING_BYTES)
+	{
+		qWarning() << "BufferedLogWriter: Dropping" << _buffer.size() << "pending bytes, log file can not be written:" << _file_path;
+		_buffer.clear();
+	}
+
+	_buffer.append(data);
+
+	if (_buffer.size() >= _cfg.flush_size_bytes)
+		flush();
+}
+
+bool BufferedLogWriter::flush()
+{
+	if (_buffer.isEmpty())
+		return true;
+
+	if (!ensureOpen())
+		return false;
+
+	const qint64 size_before = _file.size();
+	const qint64 written = _file.write(_buffer);
+	if (written != _buffer.size() || !_file.flush())
+	{
+		qWarning() << "BufferedLogWriter: Failed to write log file:" << _file_path << _file.errorString();
+
+		// Written entries may end in the middle, so all are written again. If the partial write can not be
+		// removed now, the recovery on reopening cuts it back to the last complete entry (at worst, a few
+		// entries are duplicated).
+		if (written > 0 && !_file.resize(size_before))
+			qWarning() << "BufferedLogWriter: Failed to remove partial write:" << _file_path;
+		_file.close();
+		return false;
+	}
+
+	_buffer.clear();
+	_file_size = size_before + written;
+	sync(_cfg.fsync_policy == Cfg::FsyncPolicy::OnFlush);
+	return true;
+}
+
+void BufferedLogWriter::close()
+{
+	flush();
+	if (_file.isOpen())
+	{
+		sync(_cfg.fsync_policy != Cfg::FsyncPolicy::Never);
+		_file.close();
+	}
+}
+
+qint64 BufferedLogWriter::pendingBytes() const
+{
+	return _buffer.size();
+}
+
+const QString& BufferedLogWriter::filePath() const
+{
+	return _file_path;
+}
+
+bool BufferedLogWriter::ensureOpen()
+{
+	if (_file.isOpen() && fileWasReplaced())
+	{
+		qDebug() << "BufferedLogWriter: Log file was rotated, reopening:" << _file_path;
+		_file.close();
+	}
+
+	if (_file.isOpen())
+		return true;
+
+	// A power loss or failed write may have left a torn entry at the end
+	WeatherLogRecovery::recoverFile(_file_path);
+
+	if (!_file.open(QIODevice::WriteOnly | QIODevice::Append))
+	{
+		qWarning() << "BufferedLogWriter: Failed to open log file for appending:" << _file_path << _file.errorString();
+		return false;
+	}
+
+	if (_file.size() == 0 && !_file_header.isEmpty() && _file.write(_file_header) != _file_header.size())
+	{
+		qWarning() << "BufferedLogWriter: Failed to write file header:" << _file_path << _file.errorString();
+		_file.close();
+		return false;
+	}
+
+	_file_size = _file.size();
+	_last_sync.start();
+	return true;
+}
+
+// The path no longer points to the open file, or the file was truncated
+bool BufferedLogWriter::fileWasReplaced() const
+{
+	const QFileInfo info(_file_path);
+	if (!info.exists() || info.size() < _file_size)
+		return true;
+
+	return !isSameFile(_file, _file_path);
+}
+
+void BufferedLogWriter::sync(bool force)
+{
+	if (!force)
+	{
+		if (_cfg.fsync_policy != Cfg::FsyncPolicy::Interval || _last_sync.elapsed() < _cfg.fsync_interval_sec * 1000LL)
+			return;
+	}
+
+#ifdef Q_OS_WIN
+	const int result = _commit(_file.handle());
+#else
+	const int result = ::fsync(_file.handle());
+#endif
+	if (result != 0)
+		qWarning() << "BufferedLogWriter: Failed to sync log file:" << _file_path;
+
+	_last_sync.restart();
+}
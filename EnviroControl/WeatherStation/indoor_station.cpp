@@ -9,6 +9,11 @@ IndoorStation::IndoorStation(const Cfg::IndoorStationConfig& cfg, QObject* paren
 {
 }
 
+void IndoorStation::setSampleChannel(std::shared_ptr<SampleChannel<IndoorData>> channel)
+{
+	_sample_channel = std::move(channel);
+}
+
 void IndoorStation::startReading()
 {
 	if (_dht_reader_process && _dht_reader_process->state() == QProcess::Running)
@@ -71,7 +76,11 @@ void IndoorStation::initPyDHT22Process()
 			if (!output.isEmpty())
 			{
 				if (auto data = parseData(output))
+				{
+					if (_sample_channel)
+						_sample_channel->publish(*data);
 					Q_EMIT indoorDataReady(*data);
+				}
 			}
 		});
 
@@ -147,6 +156,6 @@ std::optional<IndoorData> IndoorStation::parseData(const QString& data_str) cons
 		return std::nullopt;
 	}
 
-	IndoorData data{ temp_celsius, humidity, QDateTime::currentDateTime()};
+	IndoorData data{ temp_celsius, humidity, SampleTime::now() };
 	return data;
 }
@@ -20,6 +20,24 @@ void IndoorStationWidget::onIndoorDataChanged(const IndoorData& data)
 	_thermometer_widget->temperatureChanged(data.temperature);
 }
 
+void IndoorStationWidget::setSampleReader(std::shared_ptr<SampleChannel<IndoorData>::Reader> reader)
+{
+	_sample_reader = std::move(reader);
+}
+
+// Only the latest of the pending samples is displayed
+void IndoorStationWidget::onSamplesAvailable()
+{
+	if (!_sample_reader)
+		return;
+
+	std::optional<IndoorData> latest;
+	_sample_reader->drain([&latest](const IndoorData& data) { latest = data; });
+
+	if (latest)
+		onIndoorDataChanged(*latest);
+}
+
 void IndoorStationWidget::initLayout()
 {
 	auto layout = new QVBoxLayout(this);
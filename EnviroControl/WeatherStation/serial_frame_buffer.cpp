@@ -0,0 +1,138 @@
+#include "SerialFrameBuffer.h"
+
+#include <algorithm>
+#include <cstring>
+
+SerialFrameBuffer::SerialFrameBuffer(size_t capacity, size_t frame_length, char start_byte, char end_byte) :
+	_data(new char[capacity + frame_length - 1]),
+	_capacity(capacity), _frame_length(frame_length), _start_byte(start_byte), _end_byte(end_byte)
+{
+}
+
+SerialFrameBuffer::~SerialFrameBuffer()
+{
+}
+
+char* SerialFrameBuffer::writePtr()
+{
+	return _data.get() + (_read_pos + _size) % _capacity;
+}
+
+size_t SerialFrameBuffer::writableSize() const
+{
+	const size_t write_pos = (_read_pos + _size) % _capacity;
+	const size_t free_bytes = _capacity - _size;
+
+	// Only the contiguous part up to the physical end of the ring
+	return std::min(free_bytes, _capacity - write_pos);
+}
+
+void SerialFrameBuffer::commitWrite(size_t len)
+{
+	len = std::min(len, writableSize());
+	const size_t write_pos = (_read_pos + _size) % _capacity;
+
+	// Keep the mirror behind the ring end in sync, so frames crossing the end stay contiguous
+	const size_t mirror_length = _frame_length - 1;
+	if (write_pos < mirror_length)
+	{
+		const size_t mirror_end = std::min(write_pos + len, mirror_length);
+		std::memcpy(_data.get() + _capacity + write_pos, _data.get() + write_pos, mirror_end - write_pos);
+	}
+
+	_size += len;
+}
+
+size_t SerialFrameBuffer::write(const char* data, size_t len)
+{
+	size_t written = 0;
+	while (written < len)
+	{
+		const size_t chunk = std::min(len - written, writableSize());
+		if (chunk == 0)
+			break; // Buffer is full
+
+		std::memcpy(writePtr(), data + written, chunk);
+		commitWrite(chunk);
+		written += chunk;
+	}
+
+	return written;
+}
+
+/*
+* Searches for the start byte, drops everything before it and checks the end byte of the candidate frame.
+* If the end byte does not match, only the false start byte is dropped, so a real frame hidden behind junk is still found.
+*/
+std::string_view SerialFrameBuffer::nextFrame()
+{
+	while (_size > 0)
+	{
+		const size_t start_offset = findStart();
+		if (start_offset > 0)
+		{
+			_discarded_bytes += start_offset;
+			consume(start_offset);
+		}
+
+		if (_size < _frame_length)
+			return {}; // Not enough data for a full frame yet (or no start found at all)
+
+		const char* frame = _data.get() + _read_pos;
+		if (frame[_frame_length - 1] != _end_byte)
+		{
+			// False start (e.g. 'W' inside junk data) -> resync on the next start byte
+			++_discarded_bytes;
+			consume(1);
+			continue;
+		}
+
+		consume(_frame_length);
+		return std::string_view(frame, _frame_length);
+	}
+
+	return {};
+}
+
+void SerialFrameBuffer::clear()
+{
+	_read_pos = 0;
+	_size = 0;
+}
+
+size_t SerialFrameBuffer::size() const
+{
+	return _size;
+}
+
+size_t SerialFrameBuffer::capacity() const
+{
+	return _capacity;
+}
+
+size_t SerialFrameBuffer::discardedBytes() const
+{
+	return _discarded_bytes;
+}
+
+void SerialFrameBuffer::consume(size_t len)
+{
+	_read_pos = (_read_pos + len) % _capacity;
+	_size -= len;
+	if (_size == 0)
+		_read_pos = 0; // Keep the writable region as large as possible
+}
+
+// Offset of the first start byte relative to the read position, or _size if there is none
+size_t SerialFrameBuffer::findStart() const
+{
+	const size_t first_length = std::min(_size, _capacity - _read_pos);
+	if (const void* found = std::memchr(_data.get() + _read_pos, _start_byte, first_length))
+		return static_cast<const char*>(found) - (_data.get() + _read_pos);
+
+	const size_t second_length = _size - first_length;
+	if (const void* found = std::memchr(_data.get(), _start_byte, second_length))
+		return first_length + (static_cast<const char*>(found) - _data.get());
+
+	return _size;
+}
@@ -16,7 +16,7 @@
 #include <QtCore/QElapsedTimer>
 
 // SingleSunChart
-SingleSunChart::SingleSunChart(std::shared_ptr<std::vector<WeatherData>> weather_history, const QString& title, QWidget* parent)
+SingleSunChart::SingleSunChart(std::shared_ptr<TimeRingBuffer<PackedWeatherSample>> weather_history, const QString& title, QWidget* parent)
 	: WeatherHistoryWidgetBase(weather_history, parent), _upper_series(new QLineSeries(_chart)), _lower_series(new QLineSeries(_chart)), _area_series(nullptr)
 {
 	_chart->legend()->hide();
@@ -77,10 +77,11 @@ void SingleSunChart::updateCharts()
 	timer.start();
 
 	QVector<QPointF> points;
-	for (const auto& data : *_weather_history)
+	points.reserve(static_cast<int>(_weather_history->size()));
+	for (const auto& sample : *_weather_history)
 	{
-		const qint64 t = data.timestamp.toMSecsSinceEpoch();
-		points.append(QPointF(t, _get_point_func(data)));
+		const qint64 t = sample.epoch_ms;
+		points.append(QPointF(t, _get_point_func(sample.unpack())));
 	}
 
 	setPoints(points);
@@ -132,7 +133,7 @@ void SingleSunChart::setGetPointFunc(std::function<double(const WeatherData&)> f
 }
 
 // SunChartWidget
-SunChartWidget::SunChartWidget(std::shared_ptr<std::vector<WeatherData>> weather_history, QWidget* parent)
+SunChartWidget::SunChartWidget(std::shared_ptr<TimeRingBuffer<PackedWeatherSample>> weather_history, QWidget* parent)
 	: QWidget(parent),
 	_south_chart(new SingleSunChart(weather_history, "South", this)),
 	_east_chart(new SingleSunChart(weather_history, "East", this)),
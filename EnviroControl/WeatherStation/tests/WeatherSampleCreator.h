@@ -0,0 +1,109 @@
+#pragma once
+
+#include "gtest/gtest.h"
+
+#include "WeatherData.h"
+#include "WeatherDataLogger.h"
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QFile>
+#include <QtCore/QJsonDocument>
+
+const qint64 START_MS = 1735732800000; // 2025-01-01 12:00 UTC, full hour
+
+struct WeatherSampleCreator
+{
+	static WeatherData create(qint64 epoch_ms, double temperature, bool rain = false)
+	{
+		WeatherData data{};
+		data.temperature = temperature;
+		data.rain = rain;
+		data.timestamp = SampleTime::fromEpochMs(epoch_ms);
+		return data;
+	}
+
+	static WeatherData createWindy(qint64 epoch_ms, double temperature, double wind, bool rain = false)
+	{
+		WeatherData data = create(epoch_ms, temperature, rain);
+		data.wind = wind;
+		return data;
+	}
+
+	// All values set, within the range and precision of the packed and binary samples
+	static WeatherData createFull(qint64 epoch_ms)
+	{
+		WeatherData data{};
+		data.temperature = -5.37;
+		data.sun_south = 12.0;
+		data.sun_east = 7.25;
+		data.sun_west = 0.0;
+		data.twighlight = false;
+		data.daylight = 999.0;
+		data.wind = 12.5;
+		data.rain = true;
+		data.timestamp = SampleTime::fromEpochMs(epoch_ms);
+		return data;
+	}
+
+	// Entry of a series with one sample per minute from START_MS
+	static WeatherData createSeries(int index)
+	{
+		WeatherData data = createFull(START_MS + index * 60000LL);
+		data.temperature = -5.0 + index / 10.0;
+		data.twighlight = index % 2 == 0;
+		data.rain = index % 3 == 0;
+		return data;
+	}
+
+	static QByteArray toJsonLine(const WeatherData& data)
+	{
+		return QJsonDocument(WeatherDataLogger::toJsonEntry(data)).toJson(QJsonDocument::Compact) + "\n";
+	}
+
+	static QByteArray toJsonLines(const std::vector<WeatherData>& weather_data_list)
+	{
+		QByteArray content;
+		for (const auto& data : weather_data_list)
+			content += toJsonLine(data);
+		return content;
+	}
+
+	static Cfg::WeatherStationConfig createConfig(const QString& log_file_path, Cfg::LogFormat format = Cfg::LogFormat::JsonLines)
+	{
+		Cfg::WeatherStationConfig cfg{};
+		cfg.log_file_path = log_file_path;
+		cfg.log_format = format;
+		cfg.log_frequency_sec = 60;
+		cfg.watchdog_timeout_sec = 60;
+		return cfg;
+	}
+
+	// Raw capture, aggregate and event streams enabled
+	static Cfg::WeatherStationConfig createPipelineConfig(const QString& log_file_path, Cfg::LogFormat format = Cfg::LogFormat::JsonLines)
+	{
+		Cfg::WeatherStationConfig cfg = createConfig(log_file_path, format);
+		cfg.log_pipeline_cfg.aggregate = true;
+		cfg.log_pipeline_cfg.raw_capture = true;
+		cfg.log_pipeline_cfg.events = true;
+		return cfg;
+	}
+
+	static void writeFile(const QString& file_path, const QByteArray& content, QIODevice::OpenMode mode = QIODevice::Truncate)
+	{
+		QFile file(file_path);
+		ASSERT_TRUE(file.open(QIODevice::WriteOnly | mode));
+		ASSERT_EQ(file.write(content), content.size());
+	}
+
+	// For the tests of classes with timers or queued connections
+	static void createCoreApplication()
+	{
+		if (QCoreApplication::instance())
+			return;
+
+		static int argc = 1;
+		static char app_name[] = "WeatherStationTests";
+		static char* argv[] = { app_name, nullptr };
+		new QCoreApplication(argc, argv);
+	}
+};
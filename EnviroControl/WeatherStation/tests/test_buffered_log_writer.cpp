@@ -0,0 +1,110 @@
+#include "gtest/gtest.h"
+
+#include "BufferedLogWriter.h"
+
+#include <QtCore/QFile>
+#include <QtCore/QTemporaryDir>
+
+namespace
+{
+QByteArray readFile(const QString& file_path)
+{
+	QFile file(file_path);
+	if (!file.open(QIODevice::ReadOnly))
+		return {};
+	return file.readAll();
+}
+
+Cfg::LogWriterConfig createConfig(int flush_size_bytes)
+{
+	Cfg::LogWriterConfig cfg;
+	cfg.flush_size_bytes = flush_size_bytes;
+	cfg.fsync_policy = Cfg::FsyncPolicy::Never;
+	return cfg;
+}
+}
+
+TEST(BufferedLogWriterTest, WritesOnceSizeThresholdIsReached)
+{
+	QTemporaryDir dir;
+	const QString file_path = dir.filePath("log.json");
+	BufferedLogWriter writer(file_path, createConfig(16));
+
+	writer.append("{\"a\":1}");
+	EXPECT_TRUE(readFile(file_path).isEmpty());
+	EXPECT_EQ(writer.pendingBytes(), 8);
+
+	writer.append("{\"b\":2}");
+	EXPECT_EQ(readFile(file_path), QByteArray("{\"a\":1}\n{\"b\":2}\n"));
+	EXPECT_EQ(writer.pendingBytes(), 0);
+}
+
+TEST(BufferedLogWriterTest, FlushWritesPendingEntries)
+{
+	QTemporaryDir dir;
+	const QString file_path = dir.filePath("log.json");
+	BufferedLogWriter writer(file_path, createConfig(4096));
+
+	writer.append("{\"a\":1}");
+	EXPECT_TRUE(writer.flush());
+	EXPECT_EQ(readFile(file_path), QByteArray("{\"a\":1}\n"));
+}
+
+TEST(BufferedLogWriterTest, ReopensRotatedFile)
+{
+	QTemporaryDir dir;
+	const QString file_path = dir.filePath("log.json");
+	BufferedLogWriter writer(file_path, createConfig(4096));
+
+	writer.append("{\"a\":1}");
+	ASSERT_TRUE(writer.flush());
+
+	// Rotate the file away, the next entries go to a new file at the original path
+	ASSERT_TRUE(QFile::rename(file_path, dir.filePath("log.json.1")));
+
+	writer.append("{\"b\":2}");
+	ASSERT_TRUE(writer.flush());
+
+	EXPECT_EQ(readFile(dir.filePath("log.json.1")), QByteArray("{\"a\":1}\n"));
+	EXPECT_EQ(readFile(file_path), QByteArray("{\"b\":2}\n"));
+}
+
+TEST(BufferedLogWriterTest, ReopensFileReplacedByLargerFile)
+{
+	QTemporaryDir dir;
+	const QString file_path = dir.filePath("log.json");
+	BufferedLogWriter writer(file_path, createConfig(4096));
+
+	writer.append("{\"a\":1}");
+	ASSERT_TRUE(writer.flush());
+
+	// Rotated, and a larger file put in its place: the size alone does not show the rotation
+	ASSERT_TRUE(QFile::rename(file_path, dir.filePath("log.json.1")));
+	{
+		QFile replacement(file_path);
+		ASSERT_TRUE(replacement.open(QIODevice::WriteOnly));
+		replacement.write("{\"x\":0}\n{\"y\":0}\n");
+	}
+
+	writer.append("{\"b\":2}");
+	ASSERT_TRUE(writer.flush());
+
+	EXPECT_EQ(readFile(dir.filePath("log.json.1")), QByteArray("{\"a\":1}\n"));
+	EXPECT_EQ(readFile(file_path), QByteArray("{\"x\":0}\n{\"y\":0}\n{\"b\":2}\n"));
+}
+
+TEST(BufferedLogWriterTest, WritesHeaderAgainIntoTruncatedFile)
+{
+	QTemporaryDir dir;
+	const QString file_path = dir.filePath("log.json");
+	BufferedLogWriter writer(file_path, createConfig(4096));
+	writer.setFileHeader("#header\n");
+
+	writer.append("{\"a\":1}");
+	ASSERT_TRUE(writer.flush());
+	ASSERT_TRUE(QFile::resize(file_path, 0));
+
+	writer.append("{\"b\":2}");
+	ASSERT_TRUE(writer.flush());
+	EXPECT_EQ(readFile(file_path), QByteArray("#header\n{\"b\":2}\n"));
+}
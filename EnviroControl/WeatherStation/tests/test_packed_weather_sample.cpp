@@ -0,0 +1,45 @@
+#include "gtest/gtest.h"
+
+#include "PackedWeatherSample.h"
+#include "WeatherSampleCreator.h"
+
+TEST(PackedWeatherSampleTest, RoundTripKeepsFixedPointPrecision)
+{
+	const WeatherData data = WeatherSampleCreator::createFull(START_MS + 123);
+	const WeatherData unpacked = PackedWeatherSample::pack(data).unpack();
+
+	EXPECT_DOUBLE_EQ(unpacked.temperature, -5.37);
+	EXPECT_DOUBLE_EQ(unpacked.sun_south, 12.0);
+	EXPECT_DOUBLE_EQ(unpacked.sun_east, 7.25);
+	EXPECT_DOUBLE_EQ(unpacked.sun_west, 0.0);
+	EXPECT_FALSE(unpacked.twighlight);
+	EXPECT_DOUBLE_EQ(unpacked.daylight, 999.0);
+	EXPECT_DOUBLE_EQ(unpacked.wind, 12.5);
+	EXPECT_TRUE(unpacked.rain);
+	EXPECT_EQ(unpacked.timestamp.epoch_ms, START_MS + 123);
+	EXPECT_FALSE(unpacked.timestamp.hasSteadyTime());
+}
+
+TEST(PackedWeatherSampleTest, ClampsOutOfRangeValues)
+{
+	WeatherData data = WeatherSampleCreator::createFull(START_MS + 123);
+	data.temperature = 1000.0;
+	data.wind = -1.0;
+	data.daylight = 1e9;
+
+	const PackedWeatherSample sample = PackedWeatherSample::pack(data);
+	EXPECT_EQ(sample.temperature_cc, std::numeric_limits<int16_t>::max());
+	EXPECT_EQ(sample.wind_cms, 0);
+	EXPECT_EQ(sample.daylight_dl, std::numeric_limits<uint16_t>::max());
+}
+
+TEST(PackedWeatherSampleTest, KeepsSteadyTime)
+{
+	WeatherData data = WeatherSampleCreator::createFull(START_MS + 123);
+	data.timestamp = SampleTime::now();
+
+	const SampleTime timestamp = PackedWeatherSample::pack(data).unpack().timestamp;
+	EXPECT_TRUE(timestamp.hasSteadyTime());
+	EXPECT_EQ(timestamp.steady_ms, data.timestamp.steady_ms);
+	EXPECT_EQ(timestamp.timelineMs(), data.timestamp.timelineMs());
+}
@@ -0,0 +1,85 @@
+#include "gtest/gtest.h"
+
+#include "SampleChannel.h"
+
+#include <thread>
+
+namespace
+{
+struct TestSample
+{
+	int64_t timestamp;
+	double value;
+	bool flag;
+};
+}
+
+TEST(SampleChannelTest, RingDropsNewSamplesWhenFull)
+{
+	SpscRing<int> ring(3);
+	EXPECT_EQ(ring.capacity(), 4u);
+
+	for (int i = 0; i < 6; ++i)
+		ring.tryPush(i);
+
+	EXPECT_EQ(ring.size(), 4u);
+	EXPECT_EQ(ring.droppedCount(), 2u);
+
+	int value = -1;
+	ASSERT_TRUE(ring.tryPop(value));
+	EXPECT_EQ(value, 0);
+}
+
+TEST(SampleChannelTest, WakesOnceUntilDrained)
+{
+	SampleChannel<TestSample> channel;
+	int wake_count = 0;
+	auto reader = channel.subscribe(16, [&wake_count]() { ++wake_count; });
+
+	EXPECT_FALSE(channel.latest().has_value());
+
+	channel.publish({ 1, 1.5, false });
+	channel.publish({ 2, 2.5, true });
+	EXPECT_EQ(wake_count, 1);
+
+	std::vector<int64_t> timestamps;
+	EXPECT_EQ(reader->drain([&](const TestSample& sample) { timestamps.push_back(sample.timestamp); }), 2u);
+	EXPECT_EQ(timestamps, (std::vector<int64_t>{ 1, 2 }));
+
+	channel.publish({ 3, 3.5, false });
+	EXPECT_EQ(wake_count, 2);
+	EXPECT_EQ(channel.latest()->timestamp, 3);
+}
+
+TEST(SampleChannelTest, DeliversAllSamplesAcrossThreads)
+{
+	constexpr int SAMPLE_COUNT = 100000;
+
+	SampleChannel<TestSample> channel;
+	auto reader = channel.subscribe(SAMPLE_COUNT);
+
+	std::thread producer([&channel]()
+		{
+			for (int i = 1; i <= SAMPLE_COUNT; ++i)
+				channel.publish({ i, i * 0.5, (i % 2) == 0 });
+		});
+
+	int64_t expected = 1;
+	bool in_order = true;
+	while (expected <= SAMPLE_COUNT)
+	{
+		reader->drain([&](const TestSample& sample)
+			{
+				in_order = in_order && sample.timestamp == expected && sample.value == expected * 0.5;
+				++expected;
+			});
+
+		// A torn value would not match its timestamp
+		if (const auto latest = channel.latest())
+			in_order = in_order && latest->value == latest->timestamp * 0.5;
+	}
+	producer.join();
+
+	EXPECT_TRUE(in_order);
+	EXPECT_EQ(reader->droppedCount(), 0u);
+}
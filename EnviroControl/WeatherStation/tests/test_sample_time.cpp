@@ -0,0 +1,64 @@
+#include "gtest/gtest.h"
+
+#include "SampleTime.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+// Live sample: steady value on the timeline at timeline_ms, wall clock off by clock_error_ms
+SampleTime liveSample(qint64 timeline_ms, qint64 clock_error_ms = 0)
+{
+	SampleTime time;
+	time.steady_ms = timeline_ms - SampleTime::steadyToEpochOffsetMs();
+	time.epoch_ms = timeline_ms + clock_error_ms;
+	return time;
+}
+}
+
+TEST(SampleTimeTest, DurationsOfLiveSamplesIgnoreWallClockJumps)
+{
+	const SampleTime before = liveSample(1735732800000);
+	const SampleTime after = liveSample(1735732810000, -3600 * 1000); // Wall clock set back by an hour
+
+	EXPECT_EQ(before.msecsTo(after), 10000);
+	EXPECT_EQ(after.secsTo(before), -10);
+	EXPECT_TRUE(before < after);
+}
+
+TEST(SampleTimeTest, LoggedSamplesUseTheEpochTime)
+{
+	const SampleTime logged = SampleTime::fromEpochMs(1735732800000);
+	const SampleTime live = liveSample(1735732805000);
+
+	EXPECT_EQ(logged.timelineMs(), 1735732800000);
+	EXPECT_EQ(logged.msecsTo(live), 5000);
+	EXPECT_TRUE(logged < live);
+}
+
+TEST(SampleTimeTest, MixedSamplesSortConsistently)
+{
+	// Same timeline value, once live and once logged: ordered, but never both ways
+	const SampleTime live = liveSample(1735732800000, 500);
+	const SampleTime logged = SampleTime::fromEpochMs(1735732800000);
+	EXPECT_NE(live < logged, logged < live);
+
+	std::vector<SampleTime> times = {
+		liveSample(1735732803000, -2000),
+		SampleTime::fromEpochMs(1735732802000),
+		live,
+		liveSample(1735732801000, 7000),
+		logged,
+		SampleTime::fromEpochMs(1735732804000),
+	};
+	std::sort(times.begin(), times.end());
+
+	for (size_t i = 1; i < times.size(); ++i)
+	{
+		EXPECT_FALSE(times[i] < times[i - 1]);
+		EXPECT_GE(times[i - 1].msecsTo(times[i]), 0);
+	}
+	EXPECT_EQ(times.front().timelineMs(), 1735732800000);
+	EXPECT_EQ(times.back().timelineMs(), 1735732804000);
+}
@@ -0,0 +1,84 @@
+#include "gtest/gtest.h"
+
+#include "SerialFrameBuffer.h"
+
+#include <string>
+
+namespace
+{
+const size_t FRAME_LENGTH = 8;
+const char START = 'W';
+const char END = 0x03;
+
+std::string createFrame(char payload)
+{
+	std::string frame(FRAME_LENGTH, payload);
+	frame.front() = START;
+	frame.back() = END;
+	return frame;
+}
+}
+
+TEST(SerialFrameBufferTest, ExtractsConsecutiveFrames)
+{
+	SerialFrameBuffer buffer(64, FRAME_LENGTH, START, END);
+	const std::string data = createFrame('1') + createFrame('2');
+	buffer.write(data.data(), data.size());
+
+	EXPECT_EQ(buffer.nextFrame(), createFrame('1'));
+	EXPECT_EQ(buffer.nextFrame(), createFrame('2'));
+	EXPECT_TRUE(buffer.nextFrame().empty());
+	EXPECT_EQ(buffer.size(), 0u);
+}
+
+TEST(SerialFrameBufferTest, WaitsForIncompleteFrame)
+{
+	SerialFrameBuffer buffer(64, FRAME_LENGTH, START, END);
+	const std::string frame = createFrame('1');
+
+	buffer.write(frame.data(), 5);
+	EXPECT_TRUE(buffer.nextFrame().empty());
+
+	buffer.write(frame.data() + 5, frame.size() - 5);
+	EXPECT_EQ(buffer.nextFrame(), frame);
+}
+
+TEST(SerialFrameBufferTest, ResyncsAfterJunkAndFalseStart)
+{
+	SerialFrameBuffer buffer(64, FRAME_LENGTH, START, END);
+
+	// Junk containing a false start byte, directly followed by a valid frame
+	const std::string data = std::string("xxWyy") + createFrame('1');
+	buffer.write(data.data(), data.size());
+
+	EXPECT_EQ(buffer.nextFrame(), createFrame('1'));
+	EXPECT_EQ(buffer.discardedBytes(), 5u);
+}
+
+TEST(SerialFrameBufferTest, FrameWrappingAroundRingEndIsContiguous)
+{
+	SerialFrameBuffer buffer(20, FRAME_LENGTH, START, END);
+	const std::string data = createFrame('1') + createFrame('2') + createFrame('3');
+
+	// Always keep a partial frame in the buffer, so the third frame wraps around the ring end
+	buffer.write(data.data(), 12);
+	EXPECT_EQ(buffer.nextFrame(), createFrame('1'));
+
+	buffer.write(data.data() + 12, 8);
+	EXPECT_EQ(buffer.nextFrame(), createFrame('2'));
+
+	EXPECT_EQ(buffer.write(data.data() + 20, 4), 4u);
+	EXPECT_EQ(buffer.nextFrame(), createFrame('3'));
+	EXPECT_EQ(buffer.size(), 0u);
+}
+
+TEST(SerialFrameBufferTest, DoesNotOverflow)
+{
+	SerialFrameBuffer buffer(16, FRAME_LENGTH, START, END);
+	const std::string junk(32, 'x');
+
+	EXPECT_EQ(buffer.write(junk.data(), junk.size()), 16u);
+	EXPECT_TRUE(buffer.nextFrame().empty());
+	EXPECT_EQ(buffer.size(), 0u);
+	EXPECT_EQ(buffer.discardedBytes(), 16u);
+}
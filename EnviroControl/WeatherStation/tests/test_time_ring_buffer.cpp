@@ -0,0 +1,148 @@
+#include "gtest/gtest.h"
+
+#include "TimeRingBuffer.h"
+#include "PackedWeatherSample.h"
+
+#include <vector>
+
+namespace
+{
+struct TestSample
+{
+	SampleTime timestamp;
+	int value = 0;
+};
+
+TestSample sampleAt(qint64 epoch_ms, int value = 0)
+{
+	return { SampleTime::fromEpochMs(epoch_ms), value };
+}
+
+std::vector<int> valuesOldestFirst(const TimeRingBuffer<TestSample>& buffer)
+{
+	std::vector<int> values;
+	for (const auto& sample : buffer)
+		values.push_back(sample.value);
+	return values;
+}
+}
+
+TEST(TimeRingBufferTest, IndexesNewestFirstAndIteratesOldestFirst)
+{
+	TimeRingBuffer<TestSample> buffer(8, 10000);
+	for (int i = 0; i < 4; ++i)
+		buffer.push(sampleAt(i * 1000, i));
+
+	ASSERT_EQ(buffer.size(), 4u);
+	EXPECT_EQ(buffer[0].value, 3);
+	EXPECT_EQ(buffer[3].value, 0);
+	EXPECT_EQ(buffer.newest().value, 3);
+	EXPECT_EQ(buffer.oldest().value, 0);
+	EXPECT_EQ(valuesOldestFirst(buffer), std::vector<int>({ 0, 1, 2, 3 }));
+
+	std::vector<int> newest_first;
+	for (auto it = buffer.rbegin(); it != buffer.rend(); ++it)
+		newest_first.push_back(it->value);
+	EXPECT_EQ(newest_first, std::vector<int>({ 3, 2, 1, 0 }));
+}
+
+TEST(TimeRingBufferTest, EvictsSamplesOlderThanMaxAge)
+{
+	TimeRingBuffer<TestSample> buffer(16, 3000);
+	for (int i = 0; i < 6; ++i)
+		buffer.push(sampleAt(i * 1000, i));
+
+	// Newest at 5 s, everything up to 3 s older stays
+	EXPECT_EQ(valuesOldestFirst(buffer), std::vector<int>({ 2, 3, 4, 5 }));
+	EXPECT_EQ(buffer.overwritten(), 0u);
+
+	// A gap evicts everything, but the newest sample
+	buffer.push(sampleAt(60000, 60));
+	EXPECT_EQ(valuesOldestFirst(buffer), std::vector<int>({ 60 }));
+}
+
+TEST(TimeRingBufferTest, OverwritesOldestWhenFull)
+{
+	TimeRingBuffer<TestSample> buffer(3, 100000);
+	for (int i = 0; i < 5; ++i)
+		buffer.push(sampleAt(i * 1000, i));
+
+	EXPECT_EQ(buffer.size(), 3u);
+	EXPECT_EQ(buffer.capacity(), 3u);
+	EXPECT_EQ(buffer.overwritten(), 2u);
+	EXPECT_EQ(valuesOldestFirst(buffer), std::vector<int>({ 2, 3, 4 }));
+	EXPECT_EQ(buffer[0].value, 4);
+}
+
+TEST(TimeRingBufferTest, SegmentsCoverWrappedSamples)
+{
+	TimeRingBuffer<TestSample> buffer(4, 100000);
+	EXPECT_EQ(buffer.segments().first_size, 0u);
+
+	for (int i = 0; i < 6; ++i)
+		buffer.push(sampleAt(i * 1000, i));
+
+	const auto segments = buffer.segments();
+	ASSERT_EQ(segments.first_size + segments.second_size, 4u);
+	EXPECT_GT(segments.second_size, 0u); // Wrapped around
+
+	std::vector<int> values;
+	for (size_t i = 0; i < segments.first_size; ++i)
+		values.push_back(segments.first[i].value);
+	for (size_t i = 0; i < segments.second_size; ++i)
+		values.push_back(segments.second[i].value);
+	EXPECT_EQ(values, std::vector<int>({ 2, 3, 4, 5 }));
+}
+
+TEST(TimeRingBufferTest, PushOldestKeepsOrderAndAge)
+{
+	TimeRingBuffer<TestSample> buffer(4, 5000);
+	buffer.push(sampleAt(10000, 10));
+	buffer.push(sampleAt(11000, 11));
+
+	EXPECT_TRUE(buffer.pushOldest(sampleAt(9000, 9)));
+	EXPECT_FALSE(buffer.pushOldest(sampleAt(9500, 95))); // Not older than the oldest
+	EXPECT_FALSE(buffer.pushOldest(sampleAt(5000, 5)));  // Too old for the newest sample
+	EXPECT_TRUE(buffer.pushOldest(sampleAt(8000, 8)));
+	EXPECT_FALSE(buffer.pushOldest(sampleAt(7000, 7)));  // Full
+
+	EXPECT_EQ(valuesOldestFirst(buffer), std::vector<int>({ 8, 9, 10, 11 }));
+
+	// Live samples continue at the new end
+	buffer.push(sampleAt(13500, 13));
+	EXPECT_EQ(valuesOldestFirst(buffer), std::vector<int>({ 9, 10, 11, 13 }));
+}
+
+TEST(TimeRingBufferTest, ReadsTimestampOfPackedAndUnpackedSamples)
+{
+	TimeRingBuffer<PackedWeatherSample> packed(4, 1000);
+	WeatherData data{};
+	data.timestamp = SampleTime::fromEpochMs(5000);
+	packed.push(PackedWeatherSample::pack(data));
+	data.timestamp = SampleTime::fromEpochMs(7000);
+	packed.push(PackedWeatherSample::pack(data));
+	ASSERT_EQ(packed.size(), 1u);
+	EXPECT_EQ(packed.newest().epoch_ms, 7000);
+
+	TimeRingBuffer<WeatherData> unpacked(4, 1000);
+	unpacked.push(data);
+	EXPECT_EQ(unpacked.evictOlderThan(8000), 1u);
+	EXPECT_TRUE(unpacked.empty());
+}
+
+TEST(TimeRingBufferTest, WallClockJumpDoesNotEvictLiveSamples)
+{
+	TimeRingBuffer<PackedWeatherSample> buffer(16, 10000);
+	WeatherData data{};
+	const qint64 start_ms = 1735732800000;
+	for (int i = 0; i < 4; ++i)
+	{
+		// Wall clock set forward by a day after the second sample
+		data.timestamp.steady_ms = start_ms + i * 1000 - SampleTime::steadyToEpochOffsetMs();
+		data.timestamp.epoch_ms = start_ms + i * 1000 + (i >= 2 ? 24 * 3600 * 1000LL : 0);
+		buffer.push(PackedWeatherSample::pack(data));
+	}
+
+	ASSERT_EQ(buffer.size(), 4u);
+	EXPECT_EQ(buffer.oldest().timestamp().msecsTo(buffer.newest().timestamp()), 3000);
+}
@@ -0,0 +1,52 @@
+#include "gtest/gtest.h"
+
+#include "WeatherDeltaFilter.h"
+#include "WeatherSampleCreator.h"
+
+namespace
+{
+Cfg::DeltaFilterConfig createConfig()
+{
+	Cfg::DeltaFilterConfig cfg;
+	cfg.enabled = true;
+	cfg.temperature_deadband = 0.1;
+	cfg.wind_deadband = 0.3;
+	cfg.keyframe_interval_sec = 60;
+	return cfg;
+}
+}
+
+TEST(WeatherDeltaFilterTest, SuppressesChangesWithinDeadbands)
+{
+	WeatherDeltaFilter filter(createConfig());
+
+	EXPECT_TRUE(filter.accept(WeatherSampleCreator::createWindy(0, 20.0, 1.0)));     // First sample
+	EXPECT_FALSE(filter.accept(WeatherSampleCreator::createWindy(1000, 20.05, 1.2))); // Within deadbands
+	EXPECT_FALSE(filter.accept(WeatherSampleCreator::createWindy(2000, 20.08, 0.8)));  // Still within, compared to the forwarded sample
+	EXPECT_TRUE(filter.accept(WeatherSampleCreator::createWindy(3000, 20.2, 1.0)));   // Temperature exceeds
+	EXPECT_TRUE(filter.accept(WeatherSampleCreator::createWindy(4000, 20.2, 1.0, true))); // Rain starts
+
+	EXPECT_EQ(filter.forwardedCount(), 3u);
+	EXPECT_EQ(filter.suppressedCount(), 2u);
+}
+
+TEST(WeatherDeltaFilterTest, ForwardsKeyframes)
+{
+	WeatherDeltaFilter filter(createConfig());
+
+	EXPECT_TRUE(filter.accept(WeatherSampleCreator::createWindy(0, 20.0, 1.0)));
+	EXPECT_FALSE(filter.accept(WeatherSampleCreator::createWindy(59000, 20.0, 1.0)));
+	EXPECT_TRUE(filter.accept(WeatherSampleCreator::createWindy(60000, 20.0, 1.0)));
+	EXPECT_FALSE(filter.accept(WeatherSampleCreator::createWindy(61000, 20.0, 1.0)));
+}
+
+TEST(WeatherDeltaFilterTest, ForwardsEverythingIfDisabled)
+{
+	Cfg::DeltaFilterConfig cfg = createConfig();
+	cfg.enabled = false;
+	WeatherDeltaFilter filter(cfg);
+
+	for (int i = 0; i < 5; ++i)
+		EXPECT_TRUE(filter.accept(WeatherSampleCreator::createWindy(i * 1000, 20.0, 1.0)));
+	EXPECT_EQ(filter.suppressedCount(), 0u);
+}
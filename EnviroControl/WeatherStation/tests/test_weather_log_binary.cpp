@@ -0,0 +1,54 @@
+#include "gtest/gtest.h"
+
+#include "WeatherLogBinary.h"
+#include "WeatherSampleCreator.h"
+
+TEST(WeatherLogBinaryTest, RecordIsLittleEndian)
+{
+	const QByteArray record = WeatherLogBinary::encodeRecord(WeatherSampleCreator::createFull(0x0102030405060708));
+
+	ASSERT_EQ(record.size(), WeatherLogBinary::RECORD_SIZE);
+	EXPECT_EQ(static_cast<uint8_t>(record[0]), 0x08);
+	EXPECT_EQ(static_cast<uint8_t>(record[7]), 0x01);
+	EXPECT_EQ(static_cast<uint8_t>(record[20]), WeatherLogBinary::FLAG_RAIN);
+	EXPECT_EQ(WeatherLogBinary::recordTimestamp(record.constData()), 0x0102030405060708);
+}
+
+TEST(WeatherLogBinaryTest, DecodesLogWritten)
+{
+	QByteArray log = WeatherLogBinary::encodeHeader();
+	log.append(WeatherLogBinary::encodeRecord(WeatherSampleCreator::createFull(1000)));
+	log.append(WeatherLogBinary::encodeRecord(WeatherSampleCreator::createFull(2000)));
+	log.append("partial");
+
+	const auto weather_data_list = WeatherLogBinary::decodeLog(log);
+	ASSERT_EQ(weather_data_list.size(), 2u);
+	EXPECT_EQ(weather_data_list[1].timestamp.epoch_ms, 2000);
+	EXPECT_DOUBLE_EQ(weather_data_list[0].temperature, -5.37);
+	EXPECT_DOUBLE_EQ(weather_data_list[0].wind, 12.5);
+	EXPECT_DOUBLE_EQ(weather_data_list[0].daylight, 999.0);
+	EXPECT_TRUE(weather_data_list[0].rain);
+	EXPECT_FALSE(weather_data_list[0].twighlight);
+}
+
+TEST(WeatherLogBinaryTest, RejectsUnknownHeader)
+{
+	const QByteArray jsonl = "{\"timestamp\":\"2025-01-01T00:00:00\"}\n";
+	WeatherLogBinary::Header header;
+	EXPECT_FALSE(WeatherLogBinary::decodeHeader(jsonl.constData(), jsonl.size(), header));
+	EXPECT_TRUE(WeatherLogBinary::decodeLog(jsonl).empty());
+}
+
+TEST(WeatherLogBinaryTest, SkipsTornRecords)
+{
+	QByteArray log = WeatherLogBinary::encodeHeader();
+	log.append(WeatherLogBinary::encodeRecord(WeatherSampleCreator::createFull(1000)));
+	QByteArray torn = WeatherLogBinary::encodeRecord(WeatherSampleCreator::createFull(2000));
+	torn[9] = static_cast<char>(torn[9] ^ 0x01); // Temperature
+	log.append(torn);
+	log.append(WeatherLogBinary::encodeRecord(WeatherSampleCreator::createFull(3000)));
+
+	const auto weather_data_list = WeatherLogBinary::decodeLog(log);
+	ASSERT_EQ(weather_data_list.size(), 2u);
+	EXPECT_EQ(weather_data_list[1].timestamp.epoch_ms, 3000);
+}
@@ -0,0 +1,139 @@
+#include "gtest/gtest.h"
+
+#include "WeatherDataLogger.h"
+#include "WeatherLogJsonParser.h"
+#include "WeatherSampleCreator.h"
+
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+
+#include <cstring>
+
+namespace
+{
+QByteArray toLine(const WeatherData& data)
+{
+	return QJsonDocument(WeatherDataLogger::toJsonEntry(data)).toJson(QJsonDocument::Compact);
+}
+
+bool parseLine(const QByteArray& line, WeatherData& data)
+{
+	return WeatherLogJsonParser::parseLine(line.constData(), line.constData() + line.size(), data);
+}
+
+void expectEqual(const WeatherData& actual, const WeatherData& expected)
+{
+	EXPECT_EQ(actual.timestamp.epoch_ms, expected.timestamp.epoch_ms);
+	EXPECT_DOUBLE_EQ(actual.temperature, expected.temperature);
+	EXPECT_DOUBLE_EQ(actual.sun_south, expected.sun_south);
+	EXPECT_DOUBLE_EQ(actual.sun_east, expected.sun_east);
+	EXPECT_DOUBLE_EQ(actual.sun_west, expected.sun_west);
+	EXPECT_EQ(actual.twighlight, expected.twighlight);
+	EXPECT_DOUBLE_EQ(actual.daylight, expected.daylight);
+	EXPECT_DOUBLE_EQ(actual.wind, expected.wind);
+	EXPECT_EQ(actual.rain, expected.rain);
+}
+}
+
+TEST(WeatherLogJsonParserTest, ParsesLoggedEntries)
+{
+	for (int i = 0; i < 10; ++i)
+	{
+		WeatherData data;
+		ASSERT_TRUE(parseLine(toLine(WeatherSampleCreator::createSeries(i)), data));
+		expectEqual(data, WeatherSampleCreator::createSeries(i));
+	}
+}
+
+TEST(WeatherLogJsonParserTest, MatchesQJsonDocument)
+{
+	const QByteArray line = toLine(WeatherSampleCreator::createSeries(5));
+	const WeatherData expected = WeatherDataLogger::fromJsonEntry(QJsonDocument::fromJson(line).object());
+
+	WeatherData data;
+	ASSERT_TRUE(parseLine(line, data));
+	expectEqual(data, expected);
+}
+
+TEST(WeatherLogJsonParserTest, AcceptsWhitespaceOffsetsAndUnknownKeys)
+{
+	WeatherData data;
+	ASSERT_TRUE(parseLine(R"( { "timestamp" : "2025-01-01T12:00:00.250Z", "station": "roof", "extra": null, "temperature": 1e1 } )", data));
+	EXPECT_EQ(data.timestamp.epoch_ms, 1735732800250);
+	EXPECT_DOUBLE_EQ(data.temperature, 10.0);
+
+	ASSERT_TRUE(parseLine(R"({"timestamp":"2025-01-01T14:00:00+02:00","wind":3})", data));
+	EXPECT_EQ(data.timestamp.epoch_ms, 1735732800000);
+	EXPECT_DOUBLE_EQ(data.wind, 3.0);
+}
+
+TEST(WeatherLogJsonParserTest, FallsBackForNestedValues)
+{
+	WeatherData data;
+	ASSERT_TRUE(parseLine(R"({"timestamp":"2025-01-01T12:00:00Z","meta":{"a":1},"temperature":7.5})", data));
+	EXPECT_DOUBLE_EQ(data.temperature, 7.5);
+}
+
+TEST(WeatherLogJsonParserTest, RejectsBlankAndInvalidLines)
+{
+	WeatherData data;
+	EXPECT_FALSE(parseLine("   ", data));
+	EXPECT_FALSE(parseLine("{\"timestamp\":", data));
+	EXPECT_FALSE(parseLine("not json", data));
+}
+
+TEST(WeatherLogJsonParserTest, ParsesTimestampOnly)
+{
+	const QByteArray line = toLine(WeatherSampleCreator::createSeries(3));
+	qint64 epoch_ms = 0;
+	ASSERT_TRUE(WeatherLogJsonParser::parseTimestamp(line.constData(), line.constData() + line.size(), epoch_ms));
+	EXPECT_EQ(epoch_ms, WeatherSampleCreator::createSeries(3).timestamp.epoch_ms);
+}
+
+TEST(WeatherLogJsonParserTest, TimestampOnlyRejectsTornLines)
+{
+	// Cut off behind the timestamp (the keys are sorted), as by a power loss while writing
+	const QByteArray line = toLine(WeatherSampleCreator::createSeries(3));
+	const QByteArray torn = line.left(line.indexOf("\"twilight\""));
+	ASSERT_TRUE(torn.contains("\"timestamp\""));
+	qint64 epoch_ms = 0;
+	EXPECT_FALSE(WeatherLogJsonParser::parseTimestamp(torn.constData(), torn.constData() + torn.size(), epoch_ms));
+
+	WeatherData data;
+	EXPECT_FALSE(parseLine(torn, data));
+}
+
+TEST(WeatherLogJsonParserTest, RejectsDaysBeyondTheEndOfTheMonth)
+{
+	WeatherData data;
+	EXPECT_FALSE(parseLine(R"({"timestamp":"2025-04-31T12:00:00Z"})", data));
+	EXPECT_FALSE(parseLine(R"({"timestamp":"2025-02-29T12:00:00Z"})", data));
+	EXPECT_FALSE(parseLine(R"({"timestamp":"2100-02-29T12:00:00Z"})", data));
+
+	ASSERT_TRUE(parseLine(R"({"timestamp":"2024-02-29T12:00:00Z"})", data));
+	EXPECT_EQ(data.timestamp.epoch_ms, 1709208000000);
+	ASSERT_TRUE(parseLine(R"({"timestamp":"2000-02-29T00:00:00Z"})", data));
+	EXPECT_EQ(data.timestamp.epoch_ms, 951782400000);
+	EXPECT_TRUE(parseLine(R"({"timestamp":"2025-12-31T23:59:59Z"})", data));
+}
+
+TEST(WeatherLogJsonParserTest, ChunkedParsingKeepsOrder)
+{
+	// Large enough for several chunks
+	QByteArray content;
+	int count = 0;
+	while (content.size() < 3 * WeatherLogJsonParser::MIN_CHUNK_SIZE)
+	{
+		content += toLine(WeatherSampleCreator::createSeries(count++)) + "\n";
+		if (count % 1000 == 0)
+			content += "\n"; // Blank lines are skipped
+	}
+
+	const auto single = WeatherLogJsonParser::parse(content, 1);
+	const auto parallel = WeatherLogJsonParser::parse(content, 4);
+
+	ASSERT_EQ(single.size(), static_cast<size_t>(count));
+	ASSERT_EQ(parallel.size(), static_cast<size_t>(count));
+	for (int i = 0; i < count; ++i)
+		ASSERT_EQ(parallel[i].timestamp.epoch_ms, WeatherSampleCreator::createSeries(i).timestamp.epoch_ms);
+}
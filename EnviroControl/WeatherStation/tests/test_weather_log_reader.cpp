@@ -0,0 +1,142 @@
+#include "gtest/gtest.h"
+
+#include "WeatherLogBinary.h"
+#include "WeatherLogReader.h"
+#include "WeatherSampleCreator.h"
+
+#include <QtCore/QFile>
+#include <QtCore/QTemporaryDir>
+
+#include <limits>
+
+namespace
+{
+const int ENTRY_COUNT = 100;
+
+void writeLog(const QString& file_path, Cfg::LogFormat format)
+{
+	QFile file(file_path);
+	ASSERT_TRUE(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+
+	if (format == Cfg::LogFormat::Binary)
+		file.write(WeatherLogBinary::encodeHeader());
+
+	for (int i = 0; i < ENTRY_COUNT; ++i)
+	{
+		if (format == Cfg::LogFormat::Binary)
+			file.write(WeatherLogBinary::encodeRecord(WeatherSampleCreator::createSeries(i)));
+		else
+			file.write(WeatherSampleCreator::toJsonLine(WeatherSampleCreator::createSeries(i)));
+	}
+}
+
+class WeatherLogReaderTest : public ::testing::TestWithParam<Cfg::LogFormat>
+{
+protected:
+	void SetUp() override
+	{
+		_file_path = _dir.filePath("log");
+		writeLog(_file_path, GetParam());
+		ASSERT_TRUE(_reader.open(_file_path));
+	}
+
+	QTemporaryDir _dir;
+	QString _file_path;
+	WeatherLogReader _reader;
+};
+}
+
+TEST_P(WeatherLogReaderTest, DetectsFormat)
+{
+	EXPECT_EQ(_reader.format(), GetParam());
+	EXPECT_EQ(_reader.all().size(), static_cast<size_t>(ENTRY_COUNT));
+}
+
+TEST_P(WeatherLogReaderTest, QueriesTimeRange)
+{
+	const auto view = _reader.query(WeatherSampleCreator::createSeries(10).timestamp, WeatherSampleCreator::createSeries(20).timestamp);
+	const auto entries = view.toVector();
+
+	ASSERT_EQ(entries.size(), 10u);
+	EXPECT_EQ(entries.front().timestamp.epoch_ms, WeatherSampleCreator::createSeries(10).timestamp.epoch_ms);
+	EXPECT_EQ(entries.back().timestamp.epoch_ms, WeatherSampleCreator::createSeries(19).timestamp.epoch_ms);
+	EXPECT_DOUBLE_EQ(entries.front().temperature, -4.0);
+}
+
+TEST_P(WeatherLogReaderTest, QueryBetweenEntriesAndOutsideRange)
+{
+	// Boundaries between two entries
+	const qint64 from = WeatherSampleCreator::createSeries(10).timestamp.epoch_ms + 1;
+	const qint64 to = WeatherSampleCreator::createSeries(12).timestamp.epoch_ms + 1;
+	EXPECT_EQ(_reader.query(from, to).size(), 2u);
+
+	EXPECT_TRUE(_reader.query(0, WeatherSampleCreator::createSeries(0).timestamp.epoch_ms).empty());
+	EXPECT_EQ(_reader.query(0, std::numeric_limits<qint64>::max()).size(), static_cast<size_t>(ENTRY_COUNT));
+}
+
+TEST_P(WeatherLogReaderTest, ReturnsLatestEntries)
+{
+	const auto entries = _reader.latest(3).toVector();
+
+	ASSERT_EQ(entries.size(), 3u);
+	EXPECT_EQ(entries.front().timestamp.epoch_ms, WeatherSampleCreator::createSeries(ENTRY_COUNT - 3).timestamp.epoch_ms);
+	EXPECT_EQ(entries.back().timestamp.epoch_ms, WeatherSampleCreator::createSeries(ENTRY_COUNT - 1).timestamp.epoch_ms);
+	EXPECT_EQ(_reader.latest(1000).size(), static_cast<size_t>(ENTRY_COUNT));
+}
+
+TEST_P(WeatherLogReaderTest, RefreshMapsAppendedEntries)
+{
+	QFile file(_file_path);
+	ASSERT_TRUE(file.open(QIODevice::WriteOnly | QIODevice::Append));
+	if (GetParam() == Cfg::LogFormat::Binary)
+		file.write(WeatherLogBinary::encodeRecord(WeatherSampleCreator::createSeries(ENTRY_COUNT)));
+	else
+		file.write(WeatherSampleCreator::toJsonLine(WeatherSampleCreator::createSeries(ENTRY_COUNT)));
+	file.close();
+
+	ASSERT_TRUE(_reader.refresh());
+	EXPECT_EQ((*_reader.latest(1).begin()).timestamp.epoch_ms, WeatherSampleCreator::createSeries(ENTRY_COUNT).timestamp.epoch_ms);
+}
+
+TEST_P(WeatherLogReaderTest, SkipsInvalidEntriesInTheMiddle)
+{
+	_reader.close();
+	QFile file(_file_path);
+	ASSERT_TRUE(file.open(QIODevice::ReadOnly));
+	QByteArray content = file.readAll();
+	file.close();
+
+	if (GetParam() == Cfg::LogFormat::Binary)
+	{
+		// Damaged temperature: the timestamp is still plausible, only the checksum shows it
+		content[WeatherLogBinary::HEADER_SIZE + 50 * WeatherLogBinary::RECORD_SIZE + 8] ^= 0x40;
+	}
+	else
+	{
+		// Line 50 cut off in the middle
+		int line_start = 0;
+		for (int i = 0; i < 50; ++i)
+			line_start = content.indexOf('\n', line_start) + 1;
+		const int line_end = content.indexOf('\n', line_start);
+		content.remove(line_start + (line_end - line_start) / 2, (line_end - line_start) / 2);
+	}
+
+	ASSERT_TRUE(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+	file.write(content);
+	file.close();
+	ASSERT_TRUE(_reader.open(_file_path));
+
+	const auto entries = _reader.all().toVector();
+	ASSERT_EQ(entries.size(), static_cast<size_t>(ENTRY_COUNT - 1));
+	for (const auto& data : entries)
+		EXPECT_NE(data.timestamp.epoch_ms, 0);
+	EXPECT_EQ(entries[50].timestamp.epoch_ms, WeatherSampleCreator::createSeries(51).timestamp.epoch_ms);
+
+	// Ranges around the damaged entry, and one starting at it
+	EXPECT_EQ(_reader.query(WeatherSampleCreator::createSeries(49).timestamp, WeatherSampleCreator::createSeries(52).timestamp).size(), 2u);
+	const auto from_damaged = _reader.query(WeatherSampleCreator::createSeries(50).timestamp, WeatherSampleCreator::createSeries(52).timestamp).toVector();
+	ASSERT_EQ(from_damaged.size(), 1u);
+	EXPECT_EQ(from_damaged.front().timestamp.epoch_ms, WeatherSampleCreator::createSeries(51).timestamp.epoch_ms);
+}
+
+INSTANTIATE_TEST_SUITE_P(LogFormats, WeatherLogReaderTest, ::testing::Values(Cfg::LogFormat::JsonLines, Cfg::LogFormat::Binary));
@@ -0,0 +1,107 @@
+#include "gtest/gtest.h"
+
+#include "BufferedLogWriter.h"
+#include "WeatherLogBinary.h"
+#include "WeatherLogRecovery.h"
+#include "WeatherSampleCreator.h"
+
+#include <QtCore/QFile>
+#include <QtCore/QTemporaryDir>
+
+namespace
+{
+QByteArray createBinaryLog(int record_count)
+{
+	QByteArray log = WeatherLogBinary::encodeHeader();
+	for (int i = 0; i < record_count; ++i)
+		log.append(WeatherLogBinary::encodeRecord(WeatherSampleCreator::createFull(1000 * (i + 1))));
+	return log;
+}
+
+QByteArray readFile(const QString& file_path)
+{
+	QFile file(file_path);
+	if (!file.open(QIODevice::ReadOnly))
+		return {};
+	return file.readAll();
+}
+}
+
+TEST(WeatherLogRecoveryTest, KeepsIntactLogs)
+{
+	const QByteArray binary = createBinaryLog(3);
+	EXPECT_EQ(WeatherLogRecovery::validSize(binary.constData(), binary.size()), binary.size());
+
+	const QByteArray jsonl = "{\"a\":1}\n{\"a\":2}\n\n";
+	EXPECT_EQ(WeatherLogRecovery::validSize(jsonl.constData(), jsonl.size()), jsonl.size());
+}
+
+TEST(WeatherLogRecoveryTest, CutsTornBinaryRecords)
+{
+	const QByteArray valid = createBinaryLog(3);
+
+	QByteArray partial = valid + WeatherLogBinary::encodeRecord(WeatherSampleCreator::createFull(4000)).left(10);
+	EXPECT_EQ(WeatherLogRecovery::validSize(partial.constData(), partial.size()), valid.size());
+
+	QByteArray zeros = valid + QByteArray(2 * WeatherLogBinary::RECORD_SIZE, '\0');
+	EXPECT_EQ(WeatherLogRecovery::validSize(zeros.constData(), zeros.size()), valid.size());
+
+	QByteArray corrupted = valid + WeatherLogBinary::encodeRecord(WeatherSampleCreator::createFull(4000));
+	corrupted[corrupted.size() - 10] = static_cast<char>(corrupted[corrupted.size() - 10] ^ 0x40);
+	EXPECT_EQ(WeatherLogRecovery::validSize(corrupted.constData(), corrupted.size()), valid.size());
+
+	const QByteArray header = WeatherLogBinary::encodeHeader().left(6);
+	EXPECT_EQ(WeatherLogRecovery::validSize(header.constData(), header.size()), 0);
+}
+
+TEST(WeatherLogRecoveryTest, CutsTornJsonLines)
+{
+	const QByteArray valid = "{\"a\":1}\n{\"a\":2}\n";
+
+	const QByteArray partial = valid + "{\"a\":";
+	EXPECT_EQ(WeatherLogRecovery::validSize(partial.constData(), partial.size()), valid.size());
+
+	const QByteArray garbage = valid + "{\"a\":3" + QByteArray(20, '\0') + "\n\n";
+	EXPECT_EQ(WeatherLogRecovery::validSize(garbage.constData(), garbage.size()), valid.size());
+
+	const QByteArray nothing_valid = "{\"a\":";
+	EXPECT_EQ(WeatherLogRecovery::validSize(nothing_valid.constData(), nothing_valid.size()), 0);
+}
+
+TEST(WeatherLogRecoveryTest, WriterAppendsAfterValidEntries)
+{
+	QTemporaryDir dir;
+	const QString file_path = dir.filePath("weather_log.bin");
+	const QByteArray valid = createBinaryLog(2);
+	WeatherSampleCreator::writeFile(file_path, valid + WeatherLogBinary::encodeRecord(WeatherSampleCreator::createFull(3000)).left(7));
+
+	{
+		BufferedLogWriter writer(file_path, Cfg::LogWriterConfig());
+		writer.setFileHeader(WeatherLogBinary::encodeHeader());
+		writer.appendRaw(WeatherLogBinary::encodeRecord(WeatherSampleCreator::createFull(4000)));
+	}
+
+	const auto weather_data_list = WeatherLogBinary::decodeLog(readFile(file_path));
+	ASSERT_EQ(weather_data_list.size(), 3u);
+	EXPECT_EQ(weather_data_list[1].timestamp.epoch_ms, 2000);
+	EXPECT_EQ(weather_data_list[2].timestamp.epoch_ms, 4000);
+}
+
+TEST(WeatherLogRecoveryTest, LeavesLogsWithoutValidTailAlone)
+{
+	// More invalid data than a torn append leaves, the scan stops after 2 MiB
+	const QByteArray garbage(3 * 1024 * 1024, '\x7f');
+
+	const QByteArray jsonl = QByteArray("{\"a\":1}\n") + garbage + "\n";
+	EXPECT_EQ(WeatherLogRecovery::validSize(jsonl.constData(), jsonl.size()), jsonl.size());
+
+	const QByteArray binary = createBinaryLog(2) + garbage;
+	const qint64 whole_records = binary.size() - (binary.size() - WeatherLogBinary::HEADER_SIZE) % WeatherLogBinary::RECORD_SIZE;
+	EXPECT_EQ(WeatherLogRecovery::validSize(binary.constData(), binary.size()), whole_records);
+
+	QTemporaryDir dir;
+	const QString file_path = dir.filePath("weather_log.json");
+	WeatherSampleCreator::writeFile(file_path, jsonl);
+	EXPECT_EQ(WeatherLogRecovery::recoverFile(file_path), -1);
+	EXPECT_EQ(QFile(file_path).size(), jsonl.size());
+}
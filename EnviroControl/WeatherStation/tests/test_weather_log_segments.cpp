@@ -0,0 +1,153 @@
+#include "gtest/gtest.h"
+
+#include "WeatherLogSegments.h"
+#include "WeatherSampleCreator.h"
+
+#include <QtCore/QDir>
+#include <QtCore/QTemporaryDir>
+
+namespace
+{
+const qint64 DAY_MS = 24LL * 3600 * 1000;
+
+// Three closed daily segments with two entries each, the oldest one compressed
+void createSegments(WeatherLogManifest& manifest)
+{
+	QDir().mkpath(manifest.directory());
+	for (int day = 0; day < 3; ++day)
+	{
+		const qint64 first_ms = START_MS + day * DAY_MS;
+		WeatherLogSegment& segment = manifest.openSegment(QDate(2025, 1, 1).addDays(day), Cfg::LogFormat::JsonLines, first_ms);
+		const QByteArray content = WeatherSampleCreator::toJsonLines({ WeatherSampleCreator::create(first_ms, day), WeatherSampleCreator::create(first_ms + 60000, day + 0.5) });
+
+		const QString file_path = manifest.filePath(segment);
+		const QString file_name = segment.file_name;
+		manifest.closeActiveSegment(first_ms + 60000, content.size());
+
+		if (day == 0)
+		{
+			const QByteArray compressed = qCompress(content);
+			WeatherSampleCreator::writeFile(file_path + WeatherLogManifest::COMPRESSED_SUFFIX, compressed);
+			manifest.markCompressed(file_name, compressed.size());
+		}
+		else
+		{
+			WeatherSampleCreator::writeFile(file_path, content);
+		}
+	}
+}
+}
+
+TEST(WeatherLogManifestTest, SaveAndLoad)
+{
+	QTemporaryDir dir;
+	WeatherLogManifest manifest(dir.filePath("segments"));
+	createSegments(manifest);
+	manifest.openSegment(QDate(2025, 1, 4), Cfg::LogFormat::Binary, START_MS + 3 * DAY_MS);
+	ASSERT_TRUE(manifest.save());
+
+	WeatherLogManifest loaded(dir.filePath("segments"));
+	ASSERT_TRUE(loaded.load());
+	ASSERT_EQ(loaded.segments().size(), 4u);
+	EXPECT_TRUE(loaded.segments().front().compressed);
+	EXPECT_EQ(loaded.segments().front().last_epoch_ms, START_MS + 60000);
+
+	const WeatherLogSegment* active = loaded.activeSegment();
+	ASSERT_NE(active, nullptr);
+	EXPECT_EQ(active->format, Cfg::LogFormat::Binary);
+	EXPECT_EQ(active->day, QDate(2025, 1, 4));
+	EXPECT_EQ(active->file_name, "weather_2025-01-04.bin");
+}
+
+TEST(WeatherLogManifestTest, UniqueFileNamesPerDay)
+{
+	QTemporaryDir dir;
+	WeatherLogManifest manifest(dir.path());
+
+	manifest.openSegment(QDate(2025, 1, 1), Cfg::LogFormat::JsonLines, START_MS);
+	manifest.closeActiveSegment(START_MS + 1000, 0);
+	const WeatherLogSegment& second = manifest.openSegment(QDate(2025, 1, 1), Cfg::LogFormat::JsonLines, START_MS + 2000);
+
+	EXPECT_EQ(second.file_name, "weather_2025-01-01_2.jsonl");
+}
+
+TEST(WeatherLogManifestTest, OnlyOverlappingSegmentsAreSelected)
+{
+	QTemporaryDir dir;
+	WeatherLogManifest manifest(dir.path());
+	createSegments(manifest);
+	manifest.openSegment(QDate(2025, 1, 4), Cfg::LogFormat::JsonLines, START_MS + 3 * DAY_MS);
+
+	EXPECT_EQ(manifest.segmentsOverlapping(START_MS + DAY_MS, START_MS + DAY_MS + 1).size(), 1u);
+	EXPECT_EQ(manifest.segmentsOverlapping(START_MS + 120000, START_MS + DAY_MS).size(), 0u);
+	EXPECT_EQ(manifest.segmentsOverlapping(START_MS, START_MS + 3 * DAY_MS).size(), 3u);
+
+	// The active segment has no end yet
+	EXPECT_EQ(manifest.segmentsOverlapping(START_MS + 10 * DAY_MS, START_MS + 11 * DAY_MS).size(), 1u);
+}
+
+TEST(WeatherLogManifestTest, RetentionRemovesOldestClosedSegments)
+{
+	QTemporaryDir dir;
+	WeatherLogManifest manifest(dir.path());
+	createSegments(manifest);
+	manifest.openSegment(QDate(2025, 1, 4), Cfg::LogFormat::JsonLines, START_MS + 3 * DAY_MS);
+
+	Cfg::LogStorageConfig cfg;
+	EXPECT_TRUE(manifest.expiredSegments(QDate(2025, 1, 4), cfg).empty());
+
+	cfg.retention_days = 2;
+	auto expired = manifest.expiredSegments(QDate(2025, 1, 4), cfg);
+	ASSERT_EQ(expired.size(), 2u);
+	EXPECT_EQ(expired[0].day, QDate(2025, 1, 1));
+	EXPECT_EQ(expired[1].day, QDate(2025, 1, 2));
+
+	// The active segment is kept, even if it is too old
+	cfg.retention_days = 1;
+	EXPECT_EQ(manifest.expiredSegments(QDate(2025, 2, 1), cfg).size(), 3u);
+}
+
+TEST(WeatherLogManifestTest, SizeLimitCountsTheActiveSegmentFile)
+{
+	QTemporaryDir dir;
+	WeatherLogManifest manifest(dir.path());
+	for (int day = 0; day < 3; ++day)
+	{
+		manifest.openSegment(QDate(2025, 1, 1).addDays(day), Cfg::LogFormat::JsonLines, START_MS + day * DAY_MS);
+		manifest.closeActiveSegment(START_MS + day * DAY_MS + 60000, 300 * 1024);
+	}
+
+	// Grown since it was opened, the manifest still has size 0
+	const WeatherLogSegment& active = manifest.openSegment(QDate(2025, 1, 4), Cfg::LogFormat::JsonLines, START_MS + 3 * DAY_MS);
+	WeatherSampleCreator::writeFile(manifest.filePath(active), QByteArray(500 * 1024, 'x'));
+
+	Cfg::LogStorageConfig cfg;
+	cfg.max_total_mb = 1;
+	const auto expired = manifest.expiredSegments(QDate(2025, 1, 4), cfg);
+	ASSERT_EQ(expired.size(), 2u);
+	EXPECT_EQ(expired[0].day, QDate(2025, 1, 1));
+	EXPECT_EQ(expired[1].day, QDate(2025, 1, 2));
+}
+
+TEST(WeatherLogArchiveTest, QuerySpansSegments)
+{
+	QTemporaryDir dir;
+	Cfg::WeatherStationConfig cfg;
+	cfg.log_file_path = dir.filePath("weather_log.json");
+	cfg.log_storage_cfg.segmented = true;
+
+	WeatherLogManifest manifest(WeatherLogManifest::segmentDirectory(cfg.log_file_path));
+	createSegments(manifest);
+	ASSERT_TRUE(manifest.save());
+
+	WeatherLogArchive archive(cfg);
+	const auto entries = archive.query(START_MS + 60000, START_MS + 2 * DAY_MS + 1);
+	ASSERT_EQ(entries.size(), 4u);
+	EXPECT_DOUBLE_EQ(entries.front().temperature, 0.5); // From the compressed segment
+	EXPECT_DOUBLE_EQ(entries.back().temperature, 2.0);
+
+	const auto latest = archive.latest(3);
+	ASSERT_EQ(latest.size(), 3u);
+	EXPECT_DOUBLE_EQ(latest.front().temperature, 1.5);
+	EXPECT_DOUBLE_EQ(latest.back().temperature, 2.5);
+}
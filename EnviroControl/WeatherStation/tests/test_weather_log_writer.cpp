@@ -0,0 +1,158 @@
+#include "gtest/gtest.h"
+
+#include "WeatherDataLogger.h"
+#include "WeatherLogWriter.h"
+#include "WeatherSampleCreator.h"
+
+#include <QtCore/QFile>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+#include <QtCore/QTemporaryDir>
+
+#include <limits>
+
+namespace
+{
+std::vector<QJsonObject> readJsonLines(const QString& file_path)
+{
+	std::vector<QJsonObject> entries;
+	QFile file(file_path);
+	if (!file.open(QIODevice::ReadOnly))
+		return entries;
+
+	while (!file.atEnd())
+	{
+		const QJsonDocument doc = QJsonDocument::fromJson(file.readLine().trimmed());
+		if (doc.isObject())
+			entries.push_back(doc.object());
+	}
+	return entries;
+}
+}
+
+class WeatherLogWriterTest : public ::testing::TestWithParam<Cfg::LogFormat>
+{
+};
+
+TEST_P(WeatherLogWriterTest, WritesAllStreams)
+{
+	QTemporaryDir dir;
+	const QString log_file_path = dir.filePath("weather_log.json");
+
+	RollupBucket interval;
+	interval.start_epoch_ms = START_MS;
+	{
+		WeatherLogWriter writer(WeatherSampleCreator::createPipelineConfig(log_file_path, GetParam()));
+		writer.open();
+
+		for (int i = 0; i < 4; ++i)
+		{
+			const WeatherData data = WeatherSampleCreator::create(START_MS + i * 1000, 10.0 + i, i == 2);
+			writer.writeRawSample(data);
+			interval.add(data);
+			if (i == 2)
+				writer.writeEvent(data, "rain_started");
+		}
+		interval.end_epoch_ms = START_MS + 4000;
+		writer.writeLogEntry(interval.average());
+		writer.writeAggregate(interval);
+	} // Closes the files
+
+	const auto raw = WeatherDataLogger::parseWeatherDataFromFile(WeatherLogWriter::streamFilePath(log_file_path, "raw", GetParam()));
+	ASSERT_EQ(raw.size(), 4u);
+	EXPECT_DOUBLE_EQ(raw[3].temperature, 13.0);
+
+	const auto main = WeatherDataLogger::parseWeatherDataFromFile(log_file_path);
+	ASSERT_EQ(main.size(), 1u);
+	EXPECT_DOUBLE_EQ(main[0].temperature, 11.5);
+	EXPECT_TRUE(main[0].rain);
+	EXPECT_EQ(main[0].timestamp.epoch_ms / 1000, (START_MS + 3000) / 1000);
+
+	const auto aggregated = readJsonLines(WeatherLogWriter::streamFilePath(log_file_path, "aggregated", Cfg::LogFormat::JsonLines));
+	ASSERT_EQ(aggregated.size(), 1u);
+	const RollupBucket bucket = RollupBucket::fromJson(aggregated[0]);
+	EXPECT_EQ(bucket.count, 4);
+	EXPECT_DOUBLE_EQ(bucket.temperature.min, 10.0);
+	EXPECT_DOUBLE_EQ(bucket.temperature.max, 13.0);
+
+	const auto events = readJsonLines(WeatherLogWriter::streamFilePath(log_file_path, "events", Cfg::LogFormat::JsonLines));
+	ASSERT_EQ(events.size(), 1u);
+	EXPECT_EQ(events[0]["event"].toString(), "rain_started");
+	EXPECT_DOUBLE_EQ(events[0]["temperature"].toDouble(), 12.0);
+}
+
+INSTANTIATE_TEST_SUITE_P(LogFormats, WeatherLogWriterTest, ::testing::Values(Cfg::LogFormat::JsonLines, Cfg::LogFormat::Binary));
+
+// The logger feeds its writer thread through the event loop
+class WeatherDataLoggerTest : public ::testing::Test
+{
+protected:
+	static void SetUpTestSuite()
+	{
+		WeatherSampleCreator::createCoreApplication();
+	}
+
+	Cfg::WeatherStationConfig createLoggerConfig(int queue_capacity) const
+	{
+		Cfg::WeatherStationConfig cfg = WeatherSampleCreator::createPipelineConfig(_dir.filePath("weather_log.json"), Cfg::LogFormat::JsonLines);
+		cfg.log_frequency_sec = 60;
+		cfg.log_rollups = true;
+		cfg.log_pipeline_cfg.queue_capacity = queue_capacity;
+		return cfg;
+	}
+
+	int rollupSampleCount() const
+	{
+		int count = 0;
+		for (const auto& bucket : WeatherRollupStore::query(_dir.filePath("weather_log.json"), RollupResolution::Minute, 0, std::numeric_limits<qint64>::max()))
+			count += bucket.count;
+		return count;
+	}
+
+	QTemporaryDir _dir;
+};
+
+TEST_F(WeatherDataLoggerTest, FullQueueDropsOnlyRawSamples)
+{
+	const int sample_count = 180;
+	{
+		WeatherDataLogger logger(createLoggerConfig(0), nullptr); // Always full
+		for (int i = 0; i < sample_count; ++i)
+			logger.onRawWeatherData(WeatherSampleCreator::create(START_MS + i * 1000, 10.0 + i % 7));
+		EXPECT_EQ(logger.droppedSamples(), static_cast<quint64>(sample_count));
+	} // Writes everything queued
+
+	EXPECT_TRUE(WeatherDataLogger::parseWeatherDataFromFile(WeatherLogWriter::streamFilePath(_dir.filePath("weather_log.json"), "raw", Cfg::LogFormat::JsonLines)).empty());
+	EXPECT_EQ(rollupSampleCount(), sample_count);
+}
+
+TEST_F(WeatherDataLoggerTest, LaggingWriterKeepsEverySampleInTheRollups)
+{
+	// Faster than the writer thread, some raw samples may be dropped, but each one is either written or counted
+	const int sample_count = 5000;
+	quint64 dropped = 0;
+	{
+		WeatherDataLogger logger(createLoggerConfig(16), nullptr);
+		for (int i = 0; i < sample_count; ++i)
+			logger.onRawWeatherData(WeatherSampleCreator::create(START_MS + i * 1000, 10.0 + i % 7));
+		dropped = logger.droppedSamples();
+	}
+
+	const auto raw = WeatherDataLogger::parseWeatherDataFromFile(WeatherLogWriter::streamFilePath(_dir.filePath("weather_log.json"), "raw", Cfg::LogFormat::JsonLines));
+	EXPECT_EQ(raw.size() + dropped, static_cast<size_t>(sample_count));
+	EXPECT_EQ(rollupSampleCount(), sample_count);
+}
+
+TEST(RollupBucketTest, AverageOfInterval)
+{
+	RollupBucket interval;
+	interval.add(WeatherSampleCreator::create(START_MS, 10.0));
+	interval.add(WeatherSampleCreator::create(START_MS + 1000, 20.0, true));
+	interval.add(WeatherSampleCreator::create(START_MS + 2000, 30.0));
+
+	const WeatherData average = interval.average();
+	EXPECT_DOUBLE_EQ(average.temperature, 20.0);
+	EXPECT_TRUE(average.rain); // Any rain in the interval
+	EXPECT_FALSE(average.twighlight);
+	EXPECT_EQ(average.timestamp.epoch_ms, START_MS + 2000);
+}
@@ -0,0 +1,87 @@
+#include "gtest/gtest.h"
+
+#include "WeatherPacket.h"
+
+#include <string>
+
+using namespace WeatherPacket;
+
+namespace
+{
+// Builds a packet with a valid checksum from the 35 data bytes
+std::string createPacket(const std::string& data_bytes)
+{
+	std::string packet = data_bytes;
+	packet.resize(CHECKSUM_CALC_MAX_BYTE, '0');
+
+	unsigned int checksum = 0;
+	for (char c : packet)
+		checksum += static_cast<unsigned char>(c);
+
+	std::string checksum_str = std::to_string(checksum);
+	packet += std::string(4 - checksum_str.size(), '0') + checksum_str;
+	packet += static_cast<char>(END_IDENTIFIER);
+	return packet;
+}
+}
+
+TEST(WeatherPacketTest, DecodesFixedPointValues)
+{
+	//                                  0         1         2
+	//                                  012345678901234567890
+	const std::string packet = createPacket("W-05.3120507J99912.5J");
+	const auto decoded = decode(packet.data());
+
+	ASSERT_TRUE(decoded.has_value());
+	EXPECT_EQ(decoded->temperature_dc, -53);
+	EXPECT_EQ(decoded->sun_south, 12);
+	EXPECT_EQ(decoded->sun_west, 5);
+	EXPECT_EQ(decoded->sun_east, 7);
+	EXPECT_TRUE(decoded->twilight);
+	EXPECT_EQ(decoded->daylight, 999);
+	EXPECT_EQ(decoded->wind_dms, 125);
+	EXPECT_TRUE(decoded->rain);
+}
+
+TEST(WeatherPacketTest, RejectsNonDigit)
+{
+	const std::string packet = createPacket("W+21.4120507N9x912.5N");
+	EXPECT_FALSE(decode(packet.data()).has_value());
+}
+
+TEST(WeatherPacketTest, ValidatesPacket)
+{
+	const std::string packet = createPacket("W+21.4120507N99912.5N");
+	EXPECT_EQ(validate(packet.data()), PacketStatus::Valid);
+
+	std::string bad_start = packet;
+	bad_start[0] = 'X';
+	EXPECT_EQ(validate(bad_start.data()), PacketStatus::InvalidStart);
+
+	std::string bad_end = packet;
+	bad_end[PACKET_LENGTH - 1] = 0x04;
+	EXPECT_EQ(validate(bad_end.data()), PacketStatus::InvalidEnd);
+
+	std::string bad_checksum_digit = packet;
+	bad_checksum_digit[CHECKSUM_DIGIT3_OFFSET] = 'x';
+	EXPECT_EQ(validate(bad_checksum_digit.data()), PacketStatus::InvalidChecksumDigit);
+
+	std::string corrupted = packet;
+	corrupted[TEMP_DIGIT1_OFFSET] = '3';
+	EXPECT_EQ(validate(corrupted.data()), PacketStatus::ChecksumMismatch);
+}
+
+TEST(WeatherPacketTest, ValidatesBatch)
+{
+	const std::string valid = createPacket("W+21.4120507N99912.5N");
+	std::string corrupted = valid;
+	corrupted[WIND_DIGIT3_OFFSET] = '7';
+
+	const char* packets[] = { valid.data(), corrupted.data(), valid.data() };
+	PacketStatus results[3];
+
+	EXPECT_EQ(validateBatch(packets, 3, results), 2);
+	EXPECT_EQ(results[0], PacketStatus::Valid);
+	EXPECT_EQ(results[1], PacketStatus::ChecksumMismatch);
+	EXPECT_EQ(results[2], PacketStatus::Valid);
+}
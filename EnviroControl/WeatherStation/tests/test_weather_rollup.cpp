@@ -0,0 +1,125 @@
+#include "gtest/gtest.h"
+
+#include "WeatherRollup.h"
+#include "WeatherSampleCreator.h"
+
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QTemporaryDir>
+
+#include <limits>
+
+TEST(WeatherRollupsTest, AggregatesPartialBucket)
+{
+	WeatherRollups rollups;
+	EXPECT_TRUE(rollups.add(WeatherSampleCreator::create(START_MS, 10.0)).empty());
+	EXPECT_TRUE(rollups.add(WeatherSampleCreator::create(START_MS + 20000, 14.0, true)).empty());
+	EXPECT_TRUE(rollups.add(WeatherSampleCreator::create(START_MS + 40000, 12.0)).empty());
+
+	const auto& minute = rollups.partial(RollupResolution::Minute);
+	ASSERT_TRUE(minute.has_value());
+	EXPECT_EQ(minute->start_epoch_ms, START_MS);
+	EXPECT_EQ(minute->end_epoch_ms, START_MS + 60000);
+	EXPECT_EQ(minute->count, 3);
+	EXPECT_DOUBLE_EQ(minute->temperature.min, 10.0);
+	EXPECT_DOUBLE_EQ(minute->temperature.max, 14.0);
+	EXPECT_DOUBLE_EQ(minute->temperature.avg(minute->count), 12.0);
+	EXPECT_DOUBLE_EQ(minute->temperature.last, 12.0);
+	EXPECT_EQ(minute->rain_count, 1);
+
+	EXPECT_EQ(rollups.partial(RollupResolution::Hour)->count, 3);
+	EXPECT_EQ(rollups.partial(RollupResolution::Day)->count, 3);
+}
+
+TEST(WeatherRollupsTest, NextBucketCompletesPrevious)
+{
+	WeatherRollups rollups;
+	rollups.add(WeatherSampleCreator::create(START_MS, 10.0));
+	rollups.add(WeatherSampleCreator::create(START_MS + 30000, 11.0));
+
+	auto completed = rollups.add(WeatherSampleCreator::create(START_MS + 60000, 20.0));
+	ASSERT_EQ(completed.size(), 1u);
+	EXPECT_EQ(completed[0].resolution, RollupResolution::Minute);
+	EXPECT_EQ(completed[0].bucket.count, 2);
+	EXPECT_DOUBLE_EQ(completed[0].bucket.temperature.max, 11.0);
+
+	// Next hour completes the minute and the hour bucket
+	completed = rollups.add(WeatherSampleCreator::create(START_MS + 3600000, 5.0));
+	ASSERT_GE(completed.size(), 2u); // Plus the day, if local midnight is in between
+	EXPECT_EQ(completed[1].resolution, RollupResolution::Hour);
+	EXPECT_EQ(completed[1].bucket.count, 3);
+	EXPECT_DOUBLE_EQ(completed[1].bucket.temperature.avg(3), 41.0 / 3);
+}
+
+TEST(WeatherRollupsTest, LateSamplesAreIgnored)
+{
+	WeatherRollups rollups;
+	rollups.add(WeatherSampleCreator::create(START_MS + 60000, 10.0));
+	EXPECT_TRUE(rollups.add(WeatherSampleCreator::create(START_MS, 30.0)).empty());
+
+	EXPECT_EQ(rollups.partial(RollupResolution::Minute)->count, 1);
+	EXPECT_EQ(rollups.partial(RollupResolution::Hour)->count, 2); // Still the same hour
+}
+
+TEST(WeatherRollupStoreTest, ResumesFromPersistedState)
+{
+	QTemporaryDir dir;
+	const QString log_file_path = dir.filePath("weather_log.json");
+	Cfg::LogWriterConfig cfg;
+
+	{
+		WeatherRollupStore store(log_file_path, cfg);
+		store.add(WeatherSampleCreator::create(START_MS, 10.0));
+		store.add(WeatherSampleCreator::create(START_MS + 60000, 12.0));
+		store.add(WeatherSampleCreator::create(START_MS + 90000, 14.0));
+	} // Saves the partial buckets
+
+	{
+		WeatherRollupStore store(log_file_path, cfg);
+		store.add(WeatherSampleCreator::create(START_MS + 120000, 20.0));
+		store.flush();
+	}
+
+	const auto minutes = WeatherRollupStore::query(log_file_path, RollupResolution::Minute, START_MS, START_MS + 3600000);
+	ASSERT_EQ(minutes.size(), 3u);
+	EXPECT_EQ(minutes[1].count, 2); // Resumed after the restart
+	EXPECT_DOUBLE_EQ(minutes[1].temperature.avg(minutes[1].count), 13.0);
+	EXPECT_EQ(minutes[2].count, 1); // Partial bucket from the state file
+
+	const auto hours = WeatherRollupStore::query(log_file_path, RollupResolution::Hour, START_MS, START_MS + 3600000);
+	ASSERT_EQ(hours.size(), 1u);
+	EXPECT_EQ(hours[0].count, 4);
+	EXPECT_DOUBLE_EQ(hours[0].temperature.min, 10.0);
+	EXPECT_DOUBLE_EQ(hours[0].temperature.max, 20.0);
+}
+
+TEST(WeatherRollupStoreTest, QuerySeeksInLargeFile)
+{
+	QTemporaryDir dir;
+	const QString log_file_path = dir.filePath("weather_log.json");
+	const int bucket_count = 10000;
+
+	QDir().mkpath(WeatherRollupStore::rollupDirectory(log_file_path));
+	QFile file(QDir(WeatherRollupStore::rollupDirectory(log_file_path)).filePath("rollup_minute.jsonl"));
+	ASSERT_TRUE(file.open(QIODevice::WriteOnly));
+	for (int i = 0; i < bucket_count; ++i)
+	{
+		RollupBucket bucket = RollupBucket::forSample(RollupResolution::Minute, START_MS + i * 60000LL);
+		bucket.add(WeatherSampleCreator::create(START_MS + i * 60000LL, i));
+		file.write(QJsonDocument(bucket.toJson()).toJson(QJsonDocument::Compact) + "\n");
+		if (i == bucket_count / 2)
+			file.write("{\"count\":1,\"sta\n"); // Torn line, does not stop the search
+	}
+	file.close();
+
+	const auto middle = WeatherRollupStore::query(log_file_path, RollupResolution::Minute, START_MS + 4999 * 60000LL + 1, START_MS + 5010 * 60000LL);
+	ASSERT_EQ(middle.size(), 10u);
+	EXPECT_EQ(middle.front().start_epoch_ms, START_MS + 5000 * 60000LL);
+	EXPECT_DOUBLE_EQ(middle.front().temperature.last, 5000.0);
+	EXPECT_EQ(middle.back().start_epoch_ms, START_MS + 5009 * 60000LL);
+
+	EXPECT_EQ(WeatherRollupStore::query(log_file_path, RollupResolution::Minute, 0, START_MS + 3 * 60000LL).size(), 3u);
+	EXPECT_EQ(WeatherRollupStore::query(log_file_path, RollupResolution::Minute, START_MS + (bucket_count - 1) * 60000LL, std::numeric_limits<qint64>::max()).size(), 1u);
+	EXPECT_TRUE(WeatherRollupStore::query(log_file_path, RollupResolution::Minute, START_MS + bucket_count * 60000LL, std::numeric_limits<qint64>::max()).empty());
+}
@@ -0,0 +1,128 @@
+#include "gtest/gtest.h"
+
+#include "WeatherSampleCreator.h"
+#include "WeatherStationMock.h"
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QTemporaryDir>
+
+#include <functional>
+#include <vector>
+
+namespace
+{
+// Runs the event loop until done() or the timeout
+bool processEventsUntil(const std::function<bool()>& done, int timeout_ms = 5000)
+{
+	QElapsedTimer timer;
+	timer.start();
+	while (!done() && timer.elapsed() < timeout_ms)
+		QCoreApplication::processEvents(QEventLoop::AllEvents, 10);
+	return done();
+}
+}
+
+// The mock needs an event loop for its timers and the file system watcher
+class WeatherStationMockTest : public ::testing::Test
+{
+protected:
+	static void SetUpTestSuite()
+	{
+		WeatherSampleCreator::createCoreApplication();
+	}
+
+	Cfg::WeatherStationConfig createConfig() const
+	{
+		return WeatherSampleCreator::createConfig(_dir.filePath("weather_log.json"));
+	}
+
+	void collectSamples(WeatherStationMock& mock)
+	{
+		QObject::connect(&mock, &IWeatherStation::rawWeatherDataReady, [this](const WeatherData& data) { _samples.push_back(data); });
+	}
+
+	QTemporaryDir _dir;
+	std::vector<WeatherData> _samples;
+};
+
+TEST_F(WeatherStationMockTest, FollowModeEmitsNewestEntryOnChange)
+{
+	const QString mock_file_path = _dir.filePath("mock_weather_data.json");
+	WeatherSampleCreator::writeFile(mock_file_path, WeatherSampleCreator::toJsonLine(WeatherSampleCreator::create(START_MS, 10.0)) + WeatherSampleCreator::toJsonLine(WeatherSampleCreator::create(START_MS + 1000, 11.0)));
+
+	Cfg::WeatherStationConfig cfg = createConfig();
+	cfg.mock_cfg.repeat_interval_sec = 3600; // No repetitions during the test
+	WeatherStationMock mock(cfg);
+	collectSamples(mock);
+
+	// The newest entry right away, with the current time
+	mock.startReading();
+	ASSERT_EQ(_samples.size(), 1u);
+	EXPECT_DOUBLE_EQ(_samples[0].temperature, 11.0);
+	EXPECT_GT(_samples[0].timestamp.epoch_ms, START_MS);
+
+	WeatherSampleCreator::writeFile(mock_file_path, WeatherSampleCreator::toJsonLine(WeatherSampleCreator::create(START_MS + 2000, 12.0)), QIODevice::Append);
+	ASSERT_TRUE(processEventsUntil([this]() { return _samples.size() >= 2; }));
+	EXPECT_DOUBLE_EQ(_samples.back().temperature, 12.0);
+
+	// A corrupt newest entry is not emitted as a zeroed sample
+	WeatherSampleCreator::writeFile(mock_file_path, WeatherSampleCreator::toJsonLine(WeatherSampleCreator::create(START_MS + 3000, 13.0)).left(20) + "\n", QIODevice::Append);
+	processEventsUntil([]() { return false; }, 500);
+	EXPECT_EQ(_samples.size(), 2u);
+
+	mock.stopReading();
+}
+
+TEST_F(WeatherStationMockTest, ReplayModeEmitsValidEntriesInOrder)
+{
+	const QString replay_file_path = _dir.filePath("recorded.jsonl");
+	QByteArray content;
+	for (int i = 0; i < 10; ++i)
+	{
+		content += WeatherSampleCreator::toJsonLine(WeatherSampleCreator::create(START_MS + i * 1000, 1.0 + i));
+		if (i == 4)
+			content += "{\"timestamp\":\"2025-01-01T12:00:04.5\n"; // Corrupt line in the middle
+	}
+	WeatherSampleCreator::writeFile(replay_file_path, content);
+
+	Cfg::WeatherStationConfig cfg = createConfig();
+	cfg.mock_cfg.replay_file = replay_file_path;
+	cfg.mock_cfg.replay_speed = 100.0; // 10 ms between the entries
+	cfg.mock_cfg.replay_loop = false;
+	WeatherStationMock mock(cfg);
+	collectSamples(mock);
+
+	mock.startReading();
+	ASSERT_TRUE(processEventsUntil([this]() { return _samples.size() >= 10; }));
+	processEventsUntil([]() { return false; }, 200); // Nothing after the end without looping
+
+	ASSERT_EQ(_samples.size(), 10u);
+	for (size_t i = 0; i < _samples.size(); ++i)
+	{
+		EXPECT_DOUBLE_EQ(_samples[i].temperature, 1.0 + i);
+		EXPECT_GT(_samples[i].timestamp.epoch_ms, START_MS);
+	}
+
+	mock.stopReading();
+}
+
+TEST_F(WeatherStationMockTest, ReplayModeLoops)
+{
+	const QString replay_file_path = _dir.filePath("recorded.jsonl");
+	WeatherSampleCreator::writeFile(replay_file_path, WeatherSampleCreator::toJsonLine(WeatherSampleCreator::create(START_MS, 1.0)) + WeatherSampleCreator::toJsonLine(WeatherSampleCreator::create(START_MS + 1000, 2.0)));
+
+	Cfg::WeatherStationConfig cfg = createConfig();
+	cfg.mock_cfg.replay_file = replay_file_path;
+	cfg.mock_cfg.replay_speed = 100.0;
+	cfg.mock_cfg.repeat_interval_sec = 1; // 10 ms before starting over
+	WeatherStationMock mock(cfg);
+	collectSamples(mock);
+
+	mock.startReading();
+	ASSERT_TRUE(processEventsUntil([this]() { return _samples.size() >= 5; }));
+	EXPECT_DOUBLE_EQ(_samples[2].temperature, 1.0);
+	EXPECT_DOUBLE_EQ(_samples[3].temperature, 2.0);
+
+	mock.stopReading();
+}
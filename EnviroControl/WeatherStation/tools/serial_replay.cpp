@@ -0,0 +1,372 @@
+/*
+* Serial replay harness for the weather station ingestion path.
+*
+* Creates a pseudo-terminal pair, opens the slave side with the real WeatherStation (QSerialPort, frame buffer,
+* validation, decoding) and streams synthetic or recorded packets into the master side.
+* Reports packets/sec, rejected packets per reason and the latency from writing the last byte of a packet
+* to the rawWeatherDataReady signal. Received samples are matched to the written packets by their decoded values,
+* so lost packets do not shift the latencies of the following ones.
+*
+* Example:
+*   WeatherStationReplay --packets 20000 --rate 0 --corrupt 0.05 --junk 0.05 --max-chunk 17
+*/
+
+#include "WeatherStation.h"
+#include "WeatherData.h"
+#include "WeatherPacket.h"
+
+#include <QtCore/QCommandLineParser>
+#include <QtCore/QCoreApplication>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QTimer>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <map>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+
+using Clock = std::chrono::steady_clock;
+
+namespace
+{
+struct ReplayOptions
+{
+	QString capture_file;
+	int packet_count = 10000;
+	double bytes_per_sec = 960.0; // 9600 baud, 8N1 -> 10 bits per byte, 0 = as fast as possible
+	double corrupt_ratio = 0.0;
+	double junk_ratio = 0.0;
+	int max_chunk = 0; // 0 = write each packet in one piece
+	unsigned int seed = 42;
+};
+
+struct ReplayStream
+{
+	QByteArray bytes;
+	std::vector<int> valid_packet_ends; // Offset behind the last byte of every packet, that must be accepted
+	std::vector<WeatherPacket::DecodedPacket> valid_packets; // Decoded values of these packets
+};
+
+void writeChecksum(char* packet)
+{
+	unsigned int checksum = 0;
+	for (int i = 0; i < WeatherPacket::CHECKSUM_CALC_MAX_BYTE; ++i)
+		checksum += static_cast<unsigned char>(packet[i]);
+
+	const QByteArray checksum_str = QByteArray::number(checksum).rightJustified(4, '0');
+	std::copy(checksum_str.begin(), checksum_str.end(), packet + WeatherPacket::CHECKSUM_DIGIT1_OFFSET);
+}
+
+QByteArray createSyntheticPacket(std::mt19937& rng)
+{
+	std::uniform_int_distribution<int> temp(-150, 350);
+	std::uniform_int_distribution<int> sun(0, 99);
+	std::uniform_int_distribution<int> daylight(0, 999);
+	std::uniform_int_distribution<int> wind(0, 250);
+	std::bernoulli_distribution flag(0.1);
+
+	const int temperature = temp(rng);
+	const QByteArray temp_digits = QByteArray::number(std::abs(temperature)).rightJustified(3, '0');
+	const QByteArray wind_digits = QByteArray::number(wind(rng)).rightJustified(3, '0');
+
+	QByteArray packet(WeatherPacket::PACKET_LENGTH, '0');
+	packet[0] = WeatherPacket::START_IDENTIFIER;
+	packet[WeatherPacket::TEMP_SIGN_OFFSET] = temperature < 0 ? '-' : '+';
+	packet[WeatherPacket::TEMP_DIGIT1_OFFSET] = temp_digits[0];
+	packet[WeatherPacket::TEMP_DIGIT2_OFFSET] = temp_digits[1];
+	packet[WeatherPacket::TEMP_DECIMAL_OFFSET] = '.';
+	packet[WeatherPacket::TEMP_DIGIT3_OFFSET] = temp_digits[2];
+	packet.replace(WeatherPacket::SUN_SOUTH_DIGIT1_OFFSET, 2, QByteArray::number(sun(rng)).rightJustified(2, '0'));
+	packet.replace(WeatherPacket::SUN_WEST_DIGIT1_OFFSET, 2, QByteArray::number(sun(rng)).rightJustified(2, '0'));
+	packet.replace(WeatherPacket::SUN_EAST_DIGIT1_OFFSET, 2, QByteArray::number(sun(rng)).rightJustified(2, '0'));
+	packet[WeatherPacket::TWILIGHT_OFFSET] = flag(rng) ? 'J' : 'N';
+	packet.replace(WeatherPacket::DAYLIGHT_DIGIT1_OFFSET, 3, QByteArray::number(daylight(rng)).rightJustified(3, '0'));
+	packet[WeatherPacket::WIND_DIGIT1_OFFSET] = wind_digits[0];
+	packet[WeatherPacket::WIND_DIGIT2_OFFSET] = wind_digits[1];
+	packet[WeatherPacket::WIND_DECIMAL_OFFSET] = '.';
+	packet[WeatherPacket::WIND_DIGIT3_OFFSET] = wind_digits[2];
+	packet[WeatherPacket::RAIN_OFFSET] = flag(rng) ? 'J' : 'N';
+	packet[WeatherPacket::PACKET_LENGTH - 1] = static_cast<char>(WeatherPacket::END_IDENTIFIER);
+	writeChecksum(packet.data());
+
+	return packet;
+}
+
+// Splits a recorded capture into packets the same way the station does (start byte, end byte at the packet end)
+std::vector<QByteArray> splitCapture(const QByteArray& capture)
+{
+	std::vector<QByteArray> packets;
+	for (int pos = capture.indexOf(WeatherPacket::START_IDENTIFIER); pos >= 0 && pos + WeatherPacket::PACKET_LENGTH <= capture.size();
+		pos = capture.indexOf(WeatherPacket::START_IDENTIFIER, pos + 1))
+	{
+		if (static_cast<unsigned char>(capture.at(pos + WeatherPacket::PACKET_LENGTH - 1)) != WeatherPacket::END_IDENTIFIER)
+			continue;
+
+		packets.push_back(capture.mid(pos, WeatherPacket::PACKET_LENGTH));
+		pos += WeatherPacket::PACKET_LENGTH - 1;
+	}
+	return packets;
+}
+
+ReplayStream buildStream(const ReplayOptions& options)
+{
+	std::mt19937 rng(options.seed);
+	std::bernoulli_distribution corrupt(options.corrupt_ratio);
+	std::bernoulli_distribution junk(options.junk_ratio);
+	std::uniform_int_distribution<int> junk_length(1, 12);
+	std::uniform_int_distribution<int> data_offset(1, WeatherPacket::CHECKSUM_CALC_MAX_BYTE - 1);
+	std::uniform_int_distribution<int> any_byte(0, 255);
+
+	std::vector<QByteArray> source_packets;
+	if (!options.capture_file.isEmpty())
+	{
+		QFile file(options.capture_file);
+		if (!file.open(QIODevice::ReadOnly))
+			qFatal("Cannot open capture file %s", qPrintable(options.capture_file));
+		source_packets = splitCapture(file.readAll());
+		if (source_packets.empty())
+			qFatal("No packets found in capture file %s", qPrintable(options.capture_file));
+	}
+
+	ReplayStream stream;
+	stream.bytes.reserve(options.packet_count * (WeatherPacket::PACKET_LENGTH + 8));
+	for (int i = 0; i < options.packet_count; ++i)
+	{
+		if (junk(rng))
+		{
+			// Junk may contain start identifiers, the station has to resync on the next real packet
+			const int length = junk_length(rng);
+			for (int j = 0; j < length; ++j)
+				stream.bytes.append(j == 0 ? WeatherPacket::START_IDENTIFIER : static_cast<char>(any_byte(rng)));
+		}
+
+		QByteArray packet = source_packets.empty() ? createSyntheticPacket(rng) : source_packets[i % source_packets.size()];
+		const auto decoded = WeatherPacket::decode(packet.constData());
+		const bool valid = WeatherPacket::validate(packet.constData()) == WeatherPacket::PacketStatus::Valid && decoded;
+		if (valid && corrupt(rng))
+		{
+			// Change a data byte -> checksum mismatch
+			const int offset = data_offset(rng);
+			packet[offset] = packet.at(offset) == '1' ? '2' : '1';
+		}
+		else if (valid)
+		{
+			stream.valid_packet_ends.push_back(stream.bytes.size() + WeatherPacket::PACKET_LENGTH);
+			stream.valid_packets.push_back(*decoded);
+		}
+
+		stream.bytes.append(packet);
+	}
+
+	return stream;
+}
+
+// Compares in the fixed-point units of the packet, as the station converts them to double
+bool matches(const WeatherPacket::DecodedPacket& packet, const WeatherData& data)
+{
+	return std::lround(data.temperature * 10.0) == packet.temperature_dc
+		&& std::lround(data.sun_south) == packet.sun_south
+		&& std::lround(data.sun_west) == packet.sun_west
+		&& std::lround(data.sun_east) == packet.sun_east
+		&& std::lround(data.daylight) == packet.daylight
+		&& std::lround(data.wind * 10.0) == packet.wind_dms
+		&& data.twighlight == packet.twilight
+		&& data.rain == packet.rain;
+}
+
+int openPseudoTerminal(QString& slave_name)
+{
+	const int master_fd = posix_openpt(O_RDWR | O_NOCTTY);
+	if (master_fd < 0 || grantpt(master_fd) != 0 || unlockpt(master_fd) != 0)
+		return -1;
+
+	// Raw mode, so the line discipline does not touch 0x03 (ETX) or other control bytes
+	termios tio;
+	tcgetattr(master_fd, &tio);
+	cfmakeraw(&tio);
+	tcsetattr(master_fd, TCSANOW, &tio);
+
+	slave_name = QString::fromLocal8Bit(ptsname(master_fd));
+	return master_fd;
+}
+
+qint64 percentile(std::vector<qint64> values, double p)
+{
+	if (values.empty())
+		return 0;
+
+	const size_t index = std::min(values.size() - 1, static_cast<size_t>(p * (values.size() - 1) + 0.5));
+	std::nth_element(values.begin(), values.begin() + index, values.end());
+	return values[index];
+}
+}
+
+int main(int argc, char* argv[])
+{
+	QCoreApplication app(argc, argv);
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription("Streams weather station packets through a pty into WeatherStation");
+	parser.addHelpOption();
+	parser.addOptions({
+		{ "capture", "Recorded raw byte capture to replay (default: synthetic packets)", "file" },
+		{ "packets", "Number of packets to stream", "count", "10000" },
+		{ "rate", "Bytes per second, 0 = as fast as possible (default: 960, 9600 baud)", "bytes", "960" },
+		{ "corrupt", "Ratio of packets with a corrupted data byte", "ratio", "0" },
+		{ "junk", "Ratio of packets preceded by junk bytes", "ratio", "0" },
+		{ "max-chunk", "Write in random chunks of 1..N bytes to split reads, 0 = one write per packet", "bytes", "0" },
+		{ "seed", "Random seed", "seed", "42" },
+		});
+	parser.process(app);
+
+	ReplayOptions options;
+	options.capture_file = parser.value("capture");
+	options.packet_count = parser.value("packets").toInt();
+	options.bytes_per_sec = parser.value("rate").toDouble();
+	options.corrupt_ratio = parser.value("corrupt").toDouble();
+	options.junk_ratio = parser.value("junk").toDouble();
+	options.max_chunk = parser.value("max-chunk").toInt();
+	options.seed = parser.value("seed").toUInt();
+
+	const ReplayStream stream = buildStream(options);
+	const size_t expected_packets = stream.valid_packet_ends.size();
+
+	QString slave_name;
+	const int master_fd = openPseudoTerminal(slave_name);
+	if (master_fd < 0)
+	{
+		std::fprintf(stderr, "Failed to create pseudo-terminal\n");
+		return 1;
+	}
+
+	Cfg::WeatherStationConfig cfg;
+	cfg.port_name = slave_name;
+	cfg.baud_rate = 9600;
+	cfg.data_bits = 8;
+	cfg.stop_bits = 1;
+	cfg.parity = false;
+	cfg.log_frequency_sec = 3600;
+	cfg.watchdog_timeout_sec = 3600;
+	cfg.log_file_path = QDir::temp().filePath("weather_station_replay.log");
+
+	WeatherStation station(cfg);
+
+	// Write timestamps of the last byte of every valid packet (ns), set by the writer thread
+	std::vector<std::atomic<qint64>> written_ns(expected_packets);
+	std::vector<qint64> latencies_ns;
+	latencies_ns.reserve(expected_packets);
+	std::map<WeatherPacket::PacketStatus, int> rejected;
+	size_t received_packets = 0;
+	size_t next_match = 0; // Received samples arrive in write order, lost packets are skipped
+	size_t unmatched_packets = 0;
+	std::atomic<Clock::rep> first_write_ticks = 0; // Set by the writer thread, read by the poll timer
+	Clock::time_point last_receive;
+
+	auto now_ns = []()
+		{
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+		};
+
+	QObject::connect(&station, &IWeatherStation::rawWeatherDataReady, &app, [&](const WeatherData& data)
+		{
+			const qint64 received_ns = now_ns();
+			size_t match = next_match;
+			while (match < expected_packets && !matches(stream.valid_packets[match], data))
+				++match;
+
+			if (match < expected_packets)
+			{
+				latencies_ns.push_back(received_ns - written_ns[match].load(std::memory_order_acquire));
+				next_match = match + 1;
+			}
+			else if (unmatched_packets++ == 0)
+			{
+				std::fprintf(stderr, "Received sample %zu matches no written packet, it has no latency\n", received_packets);
+			}
+			++received_packets;
+			last_receive = Clock::now();
+		}, Qt::DirectConnection);
+
+	QObject::connect(&station, &WeatherStation::packetRejected, &app, [&](WeatherPacket::PacketStatus status)
+		{
+			++rejected[status];
+		}, Qt::DirectConnection);
+
+	station.startReading();
+
+	std::atomic<bool> writer_done = false;
+	std::thread writer([&]()
+		{
+			std::mt19937 rng(options.seed + 1);
+			std::uniform_int_distribution<int> chunk_length(1, std::max(1, options.max_chunk));
+
+			const Clock::time_point first_write = Clock::now();
+			first_write_ticks.store(first_write.time_since_epoch().count(), std::memory_order_release);
+			size_t next_packet = 0;
+			int offset = 0;
+			while (offset < stream.bytes.size())
+			{
+				int length = options.max_chunk > 0 ? chunk_length(rng) : WeatherPacket::PACKET_LENGTH;
+				length = std::min(length, static_cast<int>(stream.bytes.size()) - offset);
+
+				// Stamp all packets completed by this write before the bytes become visible to the reader
+				const qint64 stamp = now_ns();
+				while (next_packet < expected_packets && stream.valid_packet_ends[next_packet] <= offset + length)
+					written_ns[next_packet++].store(stamp, std::memory_order_release);
+
+				const ssize_t written = ::write(master_fd, stream.bytes.constData() + offset, length);
+				if (written <= 0)
+				{
+					std::this_thread::sleep_for(std::chrono::microseconds(100)); // pty buffer full
+					continue;
+				}
+				offset += static_cast<int>(written);
+
+				if (options.bytes_per_sec > 0)
+					std::this_thread::sleep_until(first_write + std::chrono::nanoseconds(static_cast<qint64>(offset * 1e9 / options.bytes_per_sec)));
+			}
+			writer_done = true;
+		});
+
+	// Stop once everything was received, or nothing arrived for a while after the writer finished
+	QTimer poll_timer;
+	poll_timer.start(50);
+	QObject::connect(&poll_timer, &QTimer::timeout, &app, [&]()
+		{
+			const Clock::time_point first_write(Clock::duration(first_write_ticks.load(std::memory_order_acquire)));
+			const bool idle = Clock::now() - std::max(last_receive, first_write) > std::chrono::seconds(2);
+			if (writer_done && (received_packets >= expected_packets || idle))
+				app.quit();
+		});
+
+	app.exec();
+	writer.join();
+	station.stopReading();
+	::close(master_fd);
+
+	const Clock::time_point first_write(Clock::duration(first_write_ticks.load()));
+	const double elapsed_sec = std::chrono::duration<double>(last_receive - first_write).count();
+	std::printf("bytes streamed:      %lld\n", static_cast<long long>(stream.bytes.size()));
+	std::printf("packets expected:    %zu\n", expected_packets);
+	std::printf("packets received:    %zu\n", received_packets);
+	std::printf("packets/sec:         %.1f\n", elapsed_sec > 0 ? received_packets / elapsed_sec : 0.0);
+	for (const auto& [status, count] : rejected)
+		std::printf("rejected (%s): %d\n", WeatherPacket::packetStatusToString(status), count);
+	std::printf("packets unmatched:   %zu\n", unmatched_packets);
+	std::printf("latency samples:     %zu\n", latencies_ns.size());
+	std::printf("latency p50:         %.1f us\n", percentile(latencies_ns, 0.50) / 1000.0);
+	std::printf("latency p99:         %.1f us\n", percentile(latencies_ns, 0.99) / 1000.0);
+
+	return received_packets == expected_packets ? 0 : 2;
+}
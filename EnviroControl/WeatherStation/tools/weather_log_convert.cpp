@@ -0,0 +1,41 @@
+/*
+* Converts weather log files between JSON Lines and the binary record format.
+*
+* Example:
+*   WeatherLogConvert weather_log.json weather_log.bin --to binary
+*   WeatherLogConvert weather_log.bin weather_log.json --to jsonl
+*/
+
+#include "WeatherDataLogger.h"
+
+#include <QtCore/QCommandLineParser>
+#include <QtCore/QCoreApplication>
+
+#include <cstdio>
+
+int main(int argc, char* argv[])
+{
+	QCoreApplication app(argc, argv);
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription("Converts weather log files between JSON Lines and binary format");
+	parser.addHelpOption();
+	parser.addPositionalArgument("input", "Log file to read (JSON Lines or binary, detected automatically)");
+	parser.addPositionalArgument("output", "Log file to write");
+	parser.addOption({ "to", "Target format: jsonl or binary", "format", "binary" });
+	parser.process(app);
+
+	const QStringList args = parser.positionalArguments();
+	if (args.size() != 2)
+		parser.showHelp(1);
+
+	const QString target = parser.value("to");
+	if (target != "jsonl" && target != "binary")
+	{
+		std::fprintf(stderr, "Unknown target format: %s\n", qPrintable(target));
+		return 1;
+	}
+
+	const Cfg::LogFormat target_format = target == "binary" ? Cfg::LogFormat::Binary : Cfg::LogFormat::JsonLines;
+	return WeatherDataLogger::convertLogFile(args.at(0), args.at(1), target_format) ? 0 : 1;
+}
@@ -124,7 +124,7 @@ void ScrollableChartView::mouseReleaseEvent(QMouseEvent* event)
 	QChartView::mouseReleaseEvent(event);
 }
 
-WeatherHistoryWidgetBase::WeatherHistoryWidgetBase(std::shared_ptr<std::vector<WeatherData>> weather_history, QWidget* parent)
+WeatherHistoryWidgetBase::WeatherHistoryWidgetBase(std::shared_ptr<TimeRingBuffer<PackedWeatherSample>> weather_history, QWidget* parent)
 	: QWidget(parent), _weather_history(weather_history), _display_length_sec(DEFAULT_DISPLAY_LENGTH_SEC),
 	_chart(new QChart()), _chart_view(new ScrollableChartView(_chart, this))
 {
@@ -139,7 +139,7 @@ WeatherHistoryWidgetBase::~WeatherHistoryWidgetBase()
 
 void WeatherHistoryWidgetBase::onWeatherData()
 {
-	_chart_view->setDataRange(_weather_history->front().timestamp, _weather_history->back().timestamp);
+	_chart_view->setDataRange(_weather_history->oldest().timestamp().toDateTime(), _weather_history->newest().timestamp().toDateTime());
 	updateCharts();
 }
 
@@ -155,9 +155,8 @@ void WeatherHistoryWidgetBase::adjustXAxisRange(bool force)
 	if (!x_axis || _weather_history->empty())
 		return;
 
-	QDateTime first = _weather_history->front().timestamp;
-	QDateTime last = _weather_history->back().timestamp;
-	qint64 available_ms = first.msecsTo(last);
+	qint64 available_ms = _weather_history->newest().epoch_ms - _weather_history->oldest().epoch_ms;
+	QDateTime last = _weather_history->newest().timestamp().toDateTime();
 
 	auto set_default_range = [&]()
 		{
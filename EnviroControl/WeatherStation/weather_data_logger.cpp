@@ -1,23 +1,78 @@
 #include "WeatherDataLogger.h"
 
 #include "WeatherDataFormat.h"
+#include "WeatherLogBinary.h"
+#include "WeatherLogJsonParser.h"
+#include "WeatherLogWriter.h"
 
+#include <QtCore/QDateTime>
 #include <QtCore/QJsonObject>
 #include <QtCore/QJsonDocument>
 #include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QThread>
 
-WeatherDataLogger::WeatherDataLogger(const QString& file_path, int log_frequency_sec, QObject* parent) :
-	QObject(parent), _log_file_path(file_path)
+/*
+* Queues func for the writer thread. Only droppable requests are limited to the queue capacity, the others are
+* a few per log interval and must not be lost.
+*/
+template <typename Func>
+bool WeatherDataLogger::post(Func&& func, bool droppable)
 {
-	qDebug() << "WeatherDataLogger: Initializing with frequency: " << log_frequency_sec << " log file: " << _log_file_path;
+	if (_queued_writes.fetch_add(1, std::memory_order_relaxed) >= _pipeline_cfg.queue_capacity && droppable)
+	{
+		_queued_writes.fetch_sub(1, std::memory_order_relaxed);
+		++_dropped_samples; // Reported by logCurrentData()
+		return false;
+	}
+
+	QMetaObject::invokeMethod(_writer, [this, func = std::forward<Func>(func)]()
+		{
+			func();
+			_queued_writes.fetch_sub(1, std::memory_order_relaxed);
+		}, Qt::QueuedConnection);
+	return true;
+}
+
+WeatherDataLogger::WeatherDataLogger(const Cfg::WeatherStationConfig& cfg, QObject* parent) :
+	QObject(parent), _pipeline_cfg(cfg.log_pipeline_cfg), _log_rollups(cfg.log_rollups),
+	_writer_thread(new QThread()), _writer(new WeatherLogWriter(cfg))
+{
+	qDebug() << "WeatherDataLogger: Initializing with frequency: " << cfg.log_frequency_sec << " log file: " << cfg.log_file_path;
+
+	_writer_thread->setObjectName("WeatherLogWriter");
+	_writer->moveToThread(_writer_thread);
+	_writer_thread->start();
+	post([writer = _writer]() { writer->open(); }, false);
+
 	_log_timer = new QTimer(this);
-	_log_timer->setInterval(log_frequency_sec * 1000); // Convert seconds to milliseconds
+	_log_timer->setInterval(cfg.log_frequency_sec * 1000); // Convert seconds to milliseconds
 	connect(_log_timer, &QTimer::timeout, this, &WeatherDataLogger::logCurrentData);
 	_log_timer->start();
+
+	// Entries are written in groups, at the latest after the flush interval
+	_flush_timer = new QTimer(this);
+	_flush_timer->setInterval(cfg.log_writer_cfg.flush_interval_sec * 1000);
+	connect(_flush_timer, &QTimer::timeout, this, &WeatherDataLogger::flushLogFile);
+	_flush_timer->start();
 }
 
 WeatherDataLogger::~WeatherDataLogger()
 {
+	// Queued after everything posted before, so nothing is lost
+	QMetaObject::invokeMethod(_writer, [writer = _writer]() { writer->close(); }, Qt::BlockingQueuedConnection);
+	_writer_thread->quit();
+	_writer_thread->wait();
+	delete _writer;
+	delete _writer_thread;
+
+	if (_dropped_samples > 0)
+		qWarning() << "WeatherDataLogger: Dropped" << _dropped_samples << "raw samples, the log writer could not keep up";
+}
+
+quint64 WeatherDataLogger::droppedSamples() const
+{
+	return _dropped_samples;
 }
 
 void WeatherDataLogger::onWeatherDataReady(const WeatherData& data)
@@ -25,42 +80,105 @@ void WeatherDataLogger::onWeatherDataReady(const WeatherData& data)
 	_last_logged_data = data;
 }
 
+void WeatherDataLogger::onRawWeatherData(const WeatherData& data)
+{
+	if (_pipeline_cfg.aggregate)
+	{
+		if (!_interval)
+		{
+			_interval = RollupBucket();
+			_interval->start_epoch_ms = data.timestamp.epoch_ms;
+		}
+		_interval->add(data);
+	}
+
+	if (_pipeline_cfg.events)
+		detectEvents(data);
+
+	// Only the raw capture may lose samples, a dropped sample would be missing in its rollup buckets for good
+	if (_pipeline_cfg.raw_capture)
+		post([writer = _writer, data]() { writer->writeRawSample(data); }, true);
+	if (_log_rollups)
+		post([writer = _writer, data]() { writer->addToRollups(data); }, false);
+}
+
+void WeatherDataLogger::detectEvents(const WeatherData& data)
+{
+	if (_last_raw_data)
+	{
+		if (data.rain != _last_raw_data->rain)
+		{
+			const QString event = data.rain ? "rain_started" : "rain_stopped";
+			post([writer = _writer, data, event]() { writer->writeEvent(data, event); }, false);
+		}
+		if (data.twighlight != _last_raw_data->twighlight)
+		{
+			const QString event = data.twighlight ? "twighlight_started" : "twighlight_ended";
+			post([writer = _writer, data, event]() { writer->writeEvent(data, event); }, false);
+		}
+	}
+	_last_raw_data = data;
+}
+
+void WeatherDataLogger::reportDroppedSamples()
+{
+	if (_dropped_samples == _reported_dropped_samples)
+		return;
+
+	qWarning() << "WeatherDataLogger: Log writer queue was full, dropped" << _dropped_samples - _reported_dropped_samples
+		<< "raw samples in the last log interval," << _dropped_samples << "in total";
+	_reported_dropped_samples = _dropped_samples;
+}
+
 void WeatherDataLogger::logCurrentData()
 {
+	reportDroppedSamples();
+
+	if (_pipeline_cfg.aggregate)
+	{
+		if (!_interval)
+		{
+			qDebug() << "WeatherDataLogger: No samples in this log interval.";
+			return;
+		}
+
+		_interval->end_epoch_ms = SampleTime::now().epoch_ms;
+		post([writer = _writer, interval = *_interval]()
+			{
+				writer->writeLogEntry(interval.average());
+				writer->writeAggregate(interval);
+			}, false);
+		_interval.reset();
+		return;
+	}
+
 	if (!_last_logged_data.has_value())
 	{
 		qDebug() << "WeatherDataLogger: No new data to log.";
 		return;
 	}
 
-	QJsonObject entry;
-	entry[WeatherDataFormat::TIMESTAMP] = _last_logged_data->timestamp.toString(Qt::ISODate);
-	entry[WeatherDataFormat::TEMPERATURE] = _last_logged_data->temperature;
-	entry[WeatherDataFormat::SUN_SOUTH] = _last_logged_data->sun_south;
-	entry[WeatherDataFormat::SUN_EAST] = _last_logged_data->sun_east;
-	entry[WeatherDataFormat::SUN_WEST] = _last_logged_data->sun_west;
-	entry[WeatherDataFormat::TWILIGHT] = _last_logged_data->twighlight;
-	entry[WeatherDataFormat::DAYLIGHT] = _last_logged_data->daylight;
-	entry[WeatherDataFormat::WIND] = _last_logged_data->wind;
-	entry[WeatherDataFormat::RAIN] = _last_logged_data->rain;
-
-	appendToLogFile(entry);
+	post([writer = _writer, data = *_last_logged_data]() { writer->writeLogEntry(data); }, false);
 	_last_logged_data.reset(); // Clear the last logged data after logging
 }
 
-void WeatherDataLogger::appendToLogFile(const QJsonObject& entry)
+void WeatherDataLogger::flushLogFile()
 {
-	QFile file(_log_file_path);
-	if (!file.open(QIODevice::Append | QIODevice::Text))
-	{
-		qWarning() << "WeatherDataLogger: Failed to open log file for appending:" << _log_file_path;
-		return;
-	}
+	post([writer = _writer]() { writer->flush(); }, false);
+}
 
-	QTextStream out(&file);
-	QJsonDocument doc(entry);
-	out << doc.toJson(QJsonDocument::Compact) << "\n"; // Write JSON entry as a single line
-	file.close();
+std::optional<Cfg::LogFormat> WeatherDataLogger::detectLogFormat(const QString& file_path)
+{
+	QFile file(file_path);
+	if (!file.open(QIODevice::ReadOnly) || file.size() == 0)
+		return {};
+
+	const QByteArray start = file.read(WeatherLogBinary::HEADER_SIZE);
+	WeatherLogBinary::Header header;
+	if (WeatherLogBinary::decodeHeader(start.constData(), start.size(), header))
+		return Cfg::LogFormat::Binary;
+
+	return Cfg::LogFormat::JsonLines;
 }
 
 std::vector<WeatherData> WeatherDataLogger::parseWeatherDataFromFile(const QString& file_path)
@@ -68,45 +186,103 @@ std::vector<WeatherData> WeatherDataLogger::parseWeatherDataFromFile(const QStri
 	std::vector<WeatherData> weather_data_list;
 	QFile file(file_path);
 
-	if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+	if (!file.open(QIODevice::ReadOnly))
 	{
 		qWarning() << "WeatherDataLogger: Failed to open log file for reading:" << file_path;
 		return weather_data_list; // Return empty list on failure
 	}
 
-	while (!file.atEnd())
+	const QByteArray start = file.peek(WeatherLogBinary::HEADER_SIZE);
+	WeatherLogBinary::Header header;
+	if (WeatherLogBinary::decodeHeader(start.constData(), start.size(), header))
 	{
-		QString line = file.readLine().trimmed();
-		if (line.isEmpty())
-			continue;
+		weather_data_list = WeatherLogBinary::decodeLog(file.readAll());
+	}
+	else if (const uchar* mapped = file.size() > 0 ? file.map(0, file.size()) : nullptr)
+	{
+		// Parsed in place, big files on all cores
+		weather_data_list = WeatherLogJsonParser::parse(reinterpret_cast<const char*>(mapped), file.size());
+		file.unmap(const_cast<uchar*>(mapped));
+	}
+	else
+	{
+		weather_data_list = WeatherLogJsonParser::parse(file.readAll());
+	}
 
-		QJsonDocument doc = QJsonDocument::fromJson(line.toUtf8());
-		if (!doc.isObject())
-		{
-			qWarning() << "WeatherDataLogger: Invalid JSON format in line:" << line;
-			continue; // Skip invalid lines
-		}
+	file.close();
+	return weather_data_list;
+}
 
-		if (doc.isNull())
+bool WeatherDataLogger::convertLogFile(const QString& input_path, const QString& output_path, Cfg::LogFormat target_format)
+{
+	if (!QFileInfo::exists(input_path))
+	{
+		qWarning() << "WeatherDataLogger: Input log file does not exist:" << input_path;
+		return false;
+	}
+
+	const std::vector<WeatherData> weather_data_list = parseWeatherDataFromFile(input_path);
+
+	QFile output(output_path);
+	if (!output.open(QIODevice::WriteOnly | QIODevice::Truncate))
+	{
+		qWarning() << "WeatherDataLogger: Failed to open output file:" << output_path;
+		return false;
+	}
+
+	QByteArray content;
+	if (target_format == Cfg::LogFormat::Binary)
+	{
+		content.reserve(WeatherLogBinary::HEADER_SIZE + static_cast<int>(weather_data_list.size()) * WeatherLogBinary::RECORD_SIZE);
+		content.append(WeatherLogBinary::encodeHeader());
+		for (const auto& data : weather_data_list)
+			content.append(WeatherLogBinary::encodeRecord(data));
+	}
+	else
+	{
+		for (const auto& data : weather_data_list)
 		{
-			qWarning() << "WeatherDataLogger: Null JSON document in line:" << line;
-			continue; // Skip null documents
+			content.append(QJsonDocument(toJsonEntry(data)).toJson(QJsonDocument::Compact));
+			content.append('\n');
 		}
+	}
 
-		QJsonObject obj = doc.object();
-		WeatherData data;
-		data.timestamp = QDateTime::fromString(obj[WeatherDataFormat::TIMESTAMP].toString(), Qt::ISODate);
-		data.temperature = obj[WeatherDataFormat::TEMPERATURE].toDouble();
-		data.sun_south = obj[WeatherDataFormat::SUN_SOUTH].toDouble();
-		data.sun_east = obj[WeatherDataFormat::SUN_EAST].toDouble();
-		data.sun_west = obj[WeatherDataFormat::SUN_WEST].toDouble();
-		data.twighlight = obj[WeatherDataFormat::TWILIGHT].toBool();
-		data.daylight = obj[WeatherDataFormat::DAYLIGHT].toDouble();
-		data.wind = obj[WeatherDataFormat::WIND].toDouble();
-		data.rain = obj[WeatherDataFormat::RAIN].toBool();
-		weather_data_list.push_back(data);
+	if (output.write(content) != content.size())
+	{
+		qWarning() << "WeatherDataLogger: Failed to write output file:" << output_path << output.errorString();
+		return false;
 	}
 
-	file.close();
-	return weather_data_list;
+	qDebug() << "WeatherDataLogger: Converted" << weather_data_list.size() << "entries from" << input_path << "to" << output_path;
+	return true;
+}
+
+QJsonObject WeatherDataLogger::toJsonEntry(const WeatherData& data)
+{
+	QJsonObject entry;
+	entry[WeatherDataFormat::TIMESTAMP] = data.timestamp.toDateTime().toString(Qt::ISODate);
+	entry[WeatherDataFormat::TEMPERATURE] = data.temperature;
+	entry[WeatherDataFormat::SUN_SOUTH] = data.sun_south;
+	entry[WeatherDataFormat::SUN_EAST] = data.sun_east;
+	entry[WeatherDataFormat::SUN_WEST] = data.sun_west;
+	entry[WeatherDataFormat::TWILIGHT] = data.twighlight;
+	entry[WeatherDataFormat::DAYLIGHT] = data.daylight;
+	entry[WeatherDataFormat::WIND] = data.wind;
+	entry[WeatherDataFormat::RAIN] = data.rain;
+	return entry;
+}
+
+WeatherData WeatherDataLogger::fromJsonEntry(const QJsonObject& obj)
+{
+	WeatherData data;
+	data.timestamp = SampleTime::fromDateTime(QDateTime::fromString(obj[WeatherDataFormat::TIMESTAMP].toString(), Qt::ISODate));
+	data.temperature = obj[WeatherDataFormat::TEMPERATURE].toDouble();
+	data.sun_south = obj[WeatherDataFormat::SUN_SOUTH].toDouble();
+	data.sun_east = obj[WeatherDataFormat::SUN_EAST].toDouble();
+	data.sun_west = obj[WeatherDataFormat::SUN_WEST].toDouble();
+	data.twighlight = obj[WeatherDataFormat::TWILIGHT].toBool();
+	data.daylight = obj[WeatherDataFormat::DAYLIGHT].toDouble();
+	data.wind = obj[WeatherDataFormat::WIND].toDouble();
+	data.rain = obj[WeatherDataFormat::RAIN].toBool();
+	return data;
 }
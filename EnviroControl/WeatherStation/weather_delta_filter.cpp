@@ -0,0 +1,60 @@
+#include "WeatherDeltaFilter.h"
+
+#include <cmath>
+
+WeatherDeltaFilter::WeatherDeltaFilter(const Cfg::DeltaFilterConfig& cfg) :
+	_cfg(cfg)
+{
+}
+
+bool WeatherDeltaFilter::accept(const WeatherData& data)
+{
+	const bool keyframe_due = !_last_forwarded
+		|| _last_forwarded->timestamp.msecsTo(data.timestamp) >= static_cast<qint64>(_cfg.keyframe_interval_sec) * 1000;
+
+	if (_cfg.enabled && !keyframe_due && !differs(data))
+	{
+		++_suppressed_count;
+		return false;
+	}
+
+	_last_forwarded = data;
+	++_forwarded_count;
+	return true;
+}
+
+void WeatherDeltaFilter::reset()
+{
+	_last_forwarded.reset();
+	_forwarded_count = 0;
+	_suppressed_count = 0;
+}
+
+uint64_t WeatherDeltaFilter::forwardedCount() const
+{
+	return _forwarded_count;
+}
+
+uint64_t WeatherDeltaFilter::suppressedCount() const
+{
+	return _suppressed_count;
+}
+
+bool WeatherDeltaFilter::differs(const WeatherData& data) const
+{
+	const WeatherData& last = *_last_forwarded;
+
+	auto exceeds = [](double value, double last_value, double deadband)
+		{
+			return std::abs(value - last_value) > deadband;
+		};
+
+	return data.twighlight != last.twighlight
+		|| data.rain != last.rain
+		|| exceeds(data.temperature, last.temperature, _cfg.temperature_deadband)
+		|| exceeds(data.sun_south, last.sun_south, _cfg.sun_deadband)
+		|| exceeds(data.sun_east, last.sun_east, _cfg.sun_deadband)
+		|| exceeds(data.sun_west, last.sun_west, _cfg.sun_deadband)
+		|| exceeds(data.daylight, last.daylight, _cfg.daylight_deadband)
+		|| exceeds(data.wind, last.wind, _cfg.wind_deadband);
+}
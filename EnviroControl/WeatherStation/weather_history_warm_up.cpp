@@ -0,0 +1,51 @@
+#include "WeatherHistoryWarmUp.h"
+#include "WeatherLogSegments.h"
+
+#include <QtCore/QDateTime>
+#include <QtCore/QDebug>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QThread>
+
+#include <limits>
+
+WeatherHistoryWarmUp::WeatherHistoryWarmUp(const Cfg::WeatherStationConfig& cfg, int history_secs, QObject* parent) :
+	QObject(parent), _cfg(cfg), _history_secs(history_secs)
+{
+}
+
+// The worker only touches the log files and emits, waiting for it is enough
+WeatherHistoryWarmUp::~WeatherHistoryWarmUp()
+{
+	if (_thread)
+	{
+		_thread->wait();
+		delete _thread;
+	}
+}
+
+void WeatherHistoryWarmUp::start()
+{
+	if (_thread)
+		return;
+
+	_thread = QThread::create([this]()
+		{
+			Q_EMIT historyLoaded(loadRecentHistory(_cfg, _history_secs));
+		});
+	_thread->setObjectName("WeatherHistoryWarmUp");
+	_thread->start(QThread::LowPriority);
+}
+
+WeatherDataBatch WeatherHistoryWarmUp::loadRecentHistory(const Cfg::WeatherStationConfig& cfg, int history_secs)
+{
+	QElapsedTimer timer;
+	timer.start();
+
+	// Only the segments / the part of the log file inside the window are read
+	const qint64 from_epoch_ms = QDateTime::currentMSecsSinceEpoch() - static_cast<qint64>(history_secs) * 1000;
+	const std::vector<WeatherData> entries = WeatherLogArchive(cfg).query(from_epoch_ms, std::numeric_limits<qint64>::max());
+
+	WeatherDataBatch history(entries.begin(), entries.end());
+	qInfo() << "WeatherHistoryWarmUp: Loaded" << history.size() << "samples of the last" << history_secs << "s in" << timer.elapsed() << "ms";
+	return history;
+}
@@ -21,7 +21,7 @@ namespace
 static const int SHORT_BUFFER_SEC = 10;
 
 // Compute averaged WeatherData from a buffer of samples.
-static WeatherData computeAveragedWeatherData(const std::vector<WeatherData>& buf)
+static WeatherData computeAveragedWeatherData(const std::vector<PackedWeatherSample>& buf)
 {
 	WeatherData a{};
 	double t_sum = 0.0;
@@ -33,8 +33,9 @@ static WeatherData computeAveragedWeatherData(const std::vector<WeatherData>& bu
 	bool twighlight_any = false;
 	bool rain_any = false;
 
-	for (const auto& s : buf)
+	for (const auto& packed : buf)
 	{
+		const WeatherData s = packed.unpack();
 		t_sum += s.temperature;
 		ss_sum += s.sun_south;
 		se_sum += s.sun_east;
@@ -54,38 +55,27 @@ static WeatherData computeAveragedWeatherData(const std::vector<WeatherData>& bu
 	a.wind = wind_sum / count;
 	a.twighlight = twighlight_any;
 	a.rain = rain_any;
-	a.timestamp = buf.back().timestamp;
+	a.timestamp = buf.back().timestamp();
 	return a;
 }
 
-// Process the short-term buffer: remove too-old entries, and when the buffer spans at
-// least SHORT_BUFFER_SEC seconds, compute an averaged WeatherData entry, push it to
-// the main history and trim the main history to the configured duration.
-bool processShortBuffer(std::vector<WeatherData>& short_buffer,
-	const WeatherData& latest,
-	std::shared_ptr<std::vector<WeatherData>> history,
-	int history_length_sec)
+// Process the short-term buffer: when it spans at least SHORT_BUFFER_SEC seconds, compute an averaged
+// WeatherData entry and push it to the main history, which drops the entries older than its duration.
+bool processShortBuffer(std::vector<PackedWeatherSample>& short_buffer, TimeRingBuffer<PackedWeatherSample>& history)
 {
 	if (short_buffer.empty())
 		return false;
 
-	QDateTime earliest = short_buffer.front().timestamp;
-	qint64 span = earliest.msecsTo(short_buffer.back().timestamp);
+	qint64 span = short_buffer.front().timestamp().msecsTo(short_buffer.back().timestamp());
 	if (span < (qint64)SHORT_BUFFER_SEC * 1000)
 		return false;
 
 	// Compute averaged sample and push to history
 	WeatherData avg = computeAveragedWeatherData(short_buffer);
-	history->push_back(avg);
+	history.push(PackedWeatherSample::pack(avg));
 
-	// Clear short buffer after aggregation
+	// Clear short buffer after aggregation, keeps its capacity
 	short_buffer.clear();
-
-	// Limit history to the specified time duration length
-	QDateTime oldest_to_keep = latest.timestamp.addSecs(-history_length_sec);
-	while (!history->empty() && history->front().timestamp < oldest_to_keep)
-		history->erase(history->begin());
-
 	return true;
 }
 
@@ -116,7 +106,8 @@ void stylaTab(int id, const QString& icon_path, QPointer<QTabWidget> tab_widget)
 WeatherHistoryWidget::WeatherHistoryWidget(QWidget* parent)
 	: QWidget(parent), _history_length_sec(DEFAULT_HISTORY_LENGTH_SEC)
 {
-	_weather_history = std::make_shared<std::vector<WeatherData>>();
+	// Averaged samples every SHORT_BUFFER_SEC, logged samples at the log frequency: one per second is plenty
+	_weather_history = std::make_shared<TimeRingBuffer<PackedWeatherSample>>(_history_length_sec, (qint64)_history_length_sec * 1000);
 
 	initLayout();
 }
@@ -125,17 +116,66 @@ WeatherHistoryWidget::~WeatherHistoryWidget()
 {}
 
 void WeatherHistoryWidget::onWeatherData(const WeatherData& data)
+{
+	// If a new averaged sample was pushed to history, update charts
+	if (addWeatherData(data))
+		updateCharts();
+}
+
+void WeatherHistoryWidget::setSampleReader(std::shared_ptr<SampleChannel<WeatherData>::Reader> reader)
+{
+	_sample_reader = std::move(reader);
+}
+
+// Drains everything published since the last wake-up, the charts are redrawn at most once
+void WeatherHistoryWidget::onSamplesAvailable()
+{
+	if (!_sample_reader)
+		return;
+
+	bool pushed = false;
+	_sample_reader->drain([this, &pushed](const WeatherData& data) { pushed = addWeatherData(data) || pushed; });
+
+	if (pushed)
+		updateCharts();
+}
+
+int WeatherHistoryWidget::historyLengthSec() const
+{
+	return _history_length_sec;
+}
+
+/*
+* Logged samples are already coarser than the averaged live samples, they are taken as they are.
+* Only samples older than the first live sample are added at the old end of the history.
+*/
+void WeatherHistoryWidget::onWeatherHistoryLoaded(const WeatherDataBatch& history)
+{
+	const qint64 oldest_allowed_ms = QDateTime::currentMSecsSinceEpoch() - (qint64)_history_length_sec * 1000;
+
+	// Newest first, the history rejects samples newer than its oldest one
+	bool seeded = false;
+	for (auto it = history.rbegin(); it != history.rend() && it->timestamp.epoch_ms >= oldest_allowed_ms; ++it)
+		seeded = _weather_history->pushOldest(PackedWeatherSample::pack(*it)) || seeded;
+
+	if (seeded)
+		updateCharts();
+}
+
+bool WeatherHistoryWidget::addWeatherData(const WeatherData& data)
 {
 	// Append incoming sample to short-term buffer and process/aggregate when needed
-	_short_buffer.push_back(data);
-	bool pushed = processShortBuffer(_short_buffer, data, _weather_history, _history_length_sec);
+	_short_buffer.push_back(PackedWeatherSample::pack(data));
+	return processShortBuffer(_short_buffer, *_weather_history);
+}
 
-	// If a new averaged sample was pushed to history, update charts
-	if (pushed && !_weather_history->empty())
-	{
-		_wind_rain_chart->onWeatherData();
-		_sun_chart->onWeatherData();
-	}
+void WeatherHistoryWidget::updateCharts()
+{
+	if (_weather_history->empty())
+		return;
+
+	_wind_rain_chart->onWeatherData();
+	_sun_chart->onWeatherData();
 }
 
 void WeatherHistoryWidget::initLayout()
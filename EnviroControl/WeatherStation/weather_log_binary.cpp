@@ -0,0 +1,121 @@
+#include "WeatherLogBinary.h"
+#include "PackedWeatherSample.h"
+
+#include <QtCore/QtEndian>
+#include <QtCore/QDebug>
+
+#include <cstring>
+
+namespace WeatherLogBinary
+{
+
+QByteArray encodeHeader()
+{
+	QByteArray header(HEADER_SIZE, '\0');
+	std::memcpy(header.data(), MAGIC, sizeof(MAGIC));
+	qToLittleEndian<quint16>(VERSION, header.data() + 4);
+	qToLittleEndian<quint16>(RECORD_SIZE, header.data() + 6);
+	return header;
+}
+
+bool decodeHeader(const char* data, qint64 size, Header& header)
+{
+	if (size < HEADER_SIZE || std::memcmp(data, MAGIC, sizeof(MAGIC)) != 0)
+		return false;
+
+	header.version = qFromLittleEndian<quint16>(data + 4);
+	header.record_size = qFromLittleEndian<quint16>(data + 6);
+	if (header.version < 1 || header.record_size < RECORD_SIZE)
+	{
+		qWarning() << "WeatherLogBinary: Unsupported header, version:" << header.version << "record size:" << header.record_size;
+		return false;
+	}
+
+	return true;
+}
+
+void encodeRecord(const WeatherData& data, char* out)
+{
+	const PackedWeatherSample sample = PackedWeatherSample::pack(data);
+
+	std::memset(out, 0, RECORD_SIZE);
+	qToLittleEndian<qint64>(sample.epoch_ms, out);
+	qToLittleEndian<qint16>(sample.temperature_cc, out + 8);
+	qToLittleEndian<quint16>(sample.sun_south_dk, out + 10);
+	qToLittleEndian<quint16>(sample.sun_east_dk, out + 12);
+	qToLittleEndian<quint16>(sample.sun_west_dk, out + 14);
+	qToLittleEndian<quint16>(sample.daylight_dl, out + 16);
+	qToLittleEndian<quint16>(sample.wind_cms, out + 18);
+	out[20] = static_cast<char>((sample.twighlight ? FLAG_TWILIGHT : 0) | (sample.rain ? FLAG_RAIN : 0));
+	qToLittleEndian<quint16>(qChecksum(QByteArrayView(out, CHECKSUM_OFFSET)), out + CHECKSUM_OFFSET);
+}
+
+QByteArray encodeRecord(const WeatherData& data)
+{
+	QByteArray record(RECORD_SIZE, '\0');
+	encodeRecord(data, record.data());
+	return record;
+}
+
+WeatherData decodeRecord(const char* record)
+{
+	PackedWeatherSample sample;
+	sample.epoch_ms = qFromLittleEndian<qint64>(record);
+	sample.temperature_cc = qFromLittleEndian<qint16>(record + 8);
+	sample.sun_south_dk = qFromLittleEndian<quint16>(record + 10);
+	sample.sun_east_dk = qFromLittleEndian<quint16>(record + 12);
+	sample.sun_west_dk = qFromLittleEndian<quint16>(record + 14);
+	sample.daylight_dl = qFromLittleEndian<quint16>(record + 16);
+	sample.wind_cms = qFromLittleEndian<quint16>(record + 18);
+
+	const auto flags = static_cast<uint8_t>(record[20]);
+	sample.twighlight = (flags & FLAG_TWILIGHT) != 0;
+	sample.rain = (flags & FLAG_RAIN) != 0;
+
+	return sample.unpack();
+}
+
+qint64 recordTimestamp(const char* record)
+{
+	return qFromLittleEndian<qint64>(record);
+}
+
+bool isValidRecord(const char* record, const Header& header)
+{
+	if (recordTimestamp(record) == 0)
+		return false; // Zero-filled by the file system, but never written
+
+	if (header.version < FIRST_CHECKSUM_VERSION)
+		return true;
+
+	return qFromLittleEndian<quint16>(record + CHECKSUM_OFFSET) == qChecksum(QByteArrayView(record, CHECKSUM_OFFSET));
+}
+
+std::vector<WeatherData> decodeLog(const QByteArray& log)
+{
+	std::vector<WeatherData> weather_data_list;
+
+	Header header;
+	if (!decodeHeader(log.constData(), log.size(), header))
+		return weather_data_list;
+
+	const qint64 record_count = (log.size() - HEADER_SIZE) / header.record_size;
+	weather_data_list.reserve(static_cast<size_t>(record_count));
+
+	const char* record = log.constData() + HEADER_SIZE;
+	qint64 torn_count = 0;
+	for (qint64 i = 0; i < record_count; ++i, record += header.record_size)
+	{
+		if (isValidRecord(record, header))
+			weather_data_list.push_back(decodeRecord(record));
+		else
+			++torn_count;
+	}
+
+	if (torn_count > 0)
+		qWarning() << "WeatherLogBinary: Skipped" << torn_count << "torn records";
+
+	return weather_data_list;
+}
+
+}
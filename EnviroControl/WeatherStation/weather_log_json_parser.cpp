@@ -0,0 +1,436 @@
+#include "WeatherLogJsonParser.h"
+#include "WeatherDataFormat.h"
+#include "WeatherDataLogger.h"
+
+#include <QtCore/QDateTime>
+#include <QtCore/QDebug>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+#include <QtCore/QThread>
+#include <QtCore/QThreadPool>
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+// Used to reserve the result vectors, a compact entry is about 190 bytes
+const qint64 ESTIMATED_LINE_SIZE = 160;
+
+enum class Field
+{
+	Timestamp,
+	Temperature,
+	SunSouth,
+	SunEast,
+	SunWest,
+	Twilight,
+	Daylight,
+	Wind,
+	Rain,
+	Unknown
+};
+
+struct FieldKey
+{
+	QByteArray name;
+	Field field;
+};
+
+const std::array<FieldKey, 9>& fieldKeys()
+{
+	static const std::array<FieldKey, 9> keys = { {
+		{ WeatherDataFormat::TIMESTAMP.toLatin1(), Field::Timestamp },
+		{ WeatherDataFormat::TEMPERATURE.toLatin1(), Field::Temperature },
+		{ WeatherDataFormat::SUN_SOUTH.toLatin1(), Field::SunSouth },
+		{ WeatherDataFormat::SUN_EAST.toLatin1(), Field::SunEast },
+		{ WeatherDataFormat::SUN_WEST.toLatin1(), Field::SunWest },
+		{ WeatherDataFormat::TWILIGHT.toLatin1(), Field::Twilight },
+		{ WeatherDataFormat::DAYLIGHT.toLatin1(), Field::Daylight },
+		{ WeatherDataFormat::WIND.toLatin1(), Field::Wind },
+		{ WeatherDataFormat::RAIN.toLatin1(), Field::Rain },
+	} };
+	return keys;
+}
+
+Field fieldOf(const char* begin, const char* end)
+{
+	const auto length = end - begin;
+	for (const auto& key : fieldKeys())
+	{
+		if (key.name.size() == length && std::memcmp(key.name.constData(), begin, static_cast<size_t>(length)) == 0)
+			return key.field;
+	}
+	return Field::Unknown;
+}
+
+bool isSpace(char c)
+{
+	return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+void skipSpace(const char*& pos, const char* end)
+{
+	while (pos < end && isSpace(*pos))
+		++pos;
+}
+
+bool consume(const char*& pos, const char* end, char c)
+{
+	skipSpace(pos, end);
+	if (pos == end || *pos != c)
+		return false;
+	++pos;
+	return true;
+}
+
+bool consumeLiteral(const char*& pos, const char* end, const char* literal)
+{
+	const size_t length = std::strlen(literal);
+	if (static_cast<size_t>(end - pos) < length || std::memcmp(pos, literal, length) != 0)
+		return false;
+	pos += length;
+	return true;
+}
+
+// String without escape sequences, anything else is left to the fallback
+bool parseSimpleString(const char*& pos, const char* end, const char*& string_begin, const char*& string_end)
+{
+	if (!consume(pos, end, '"'))
+		return false;
+
+	string_begin = pos;
+	while (pos < end && *pos != '"')
+	{
+		if (*pos == '\\')
+			return false;
+		++pos;
+	}
+	if (pos == end)
+		return false;
+
+	string_end = pos++;
+	return true;
+}
+
+bool parseNumber(const char*& pos, const char* end, double& value)
+{
+	skipSpace(pos, end);
+	const auto result = std::from_chars(pos, end, value);
+	if (result.ec != std::errc())
+		return false;
+	pos = result.ptr;
+	return true;
+}
+
+bool parseBool(const char*& pos, const char* end, bool& value)
+{
+	skipSpace(pos, end);
+	if (consumeLiteral(pos, end, "true"))
+		value = true;
+	else if (consumeLiteral(pos, end, "false"))
+		value = false;
+	else
+		return false;
+	return true;
+}
+
+// Skips a scalar value of an unknown key
+bool skipValue(const char*& pos, const char* end)
+{
+	skipSpace(pos, end);
+	if (pos == end)
+		return false;
+
+	const char* string_begin = nullptr;
+	const char* string_end = nullptr;
+	double number = 0.0;
+	bool boolean = false;
+	if (*pos == '"')
+		return parseSimpleString(pos, end, string_begin, string_end);
+	if (consumeLiteral(pos, end, "null"))
+		return true;
+	if (*pos == 't' || *pos == 'f')
+		return parseBool(pos, end, boolean);
+	return parseNumber(pos, end, number);
+}
+
+bool parseDigits(const char*& pos, const char* end, int count, int& value)
+{
+	if (end - pos < count)
+		return false;
+
+	value = 0;
+	for (int i = 0; i < count; ++i, ++pos)
+	{
+		if (*pos < '0' || *pos > '9')
+			return false;
+		value = value * 10 + (*pos - '0');
+	}
+	return true;
+}
+
+// Days since 1970-01-01 of a proleptic Gregorian date (H. Hinnant's days_from_civil)
+qint64 daysFromCivil(int year, int month, int day)
+{
+	year -= month <= 2 ? 1 : 0;
+	const qint64 era = (year >= 0 ? year : year - 399) / 400;
+	const qint64 year_of_era = year - era * 400;
+	const qint64 day_of_year = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+	const qint64 day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+	return era * 146097 + day_of_era - 719468;
+}
+
+int daysInMonth(int year, int month)
+{
+	static const std::array<int, 12> DAYS = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+	const bool leap_year = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+	return month == 2 && leap_year ? 29 : DAYS[static_cast<size_t>(month - 1)];
+}
+
+// UTC offset of the local time zone, looked up once per local hour (one cache per thread)
+int localUtcOffsetSec(int year, int month, int day, int hour)
+{
+	struct Cache
+	{
+		qint64 local_hour = std::numeric_limits<qint64>::min();
+		int offset_sec = 0;
+	};
+	thread_local Cache cache;
+
+	const qint64 local_hour = daysFromCivil(year, month, day) * 24 + hour;
+	if (local_hour != cache.local_hour)
+	{
+		cache.local_hour = local_hour;
+		cache.offset_sec = QDateTime(QDate(year, month, day), QTime(hour, 0)).offsetFromUtc();
+	}
+	return cache.offset_sec;
+}
+
+// ISO 8601 as written by Qt::ISODate: yyyy-MM-ddTHH:mm:ss[.zzz][Z|+HH:mm|-HH:mm], local time without offset
+bool parseIsoTimestamp(const char* pos, const char* end, qint64& epoch_ms)
+{
+	int year = 0, month = 0, day = 0, hour = 0, minute = 0, second = 0;
+	if (!parseDigits(pos, end, 4, year) || !consumeLiteral(pos, end, "-") ||
+		!parseDigits(pos, end, 2, month) || !consumeLiteral(pos, end, "-") ||
+		!parseDigits(pos, end, 2, day) || !consumeLiteral(pos, end, "T") ||
+		!parseDigits(pos, end, 2, hour) || !consumeLiteral(pos, end, ":") ||
+		!parseDigits(pos, end, 2, minute) || !consumeLiteral(pos, end, ":") ||
+		!parseDigits(pos, end, 2, second))
+		return false;
+
+	if (month < 1 || month > 12 || day < 1 || day > daysInMonth(year, month) || hour > 23 || minute > 59 || second > 59)
+		return false;
+
+	int msec = 0;
+	if (pos < end && *pos == '.')
+	{
+		++pos;
+		if (!parseDigits(pos, end, 3, msec))
+			return false;
+	}
+
+	int offset_sec = 0;
+	if (pos == end)
+	{
+		offset_sec = localUtcOffsetSec(year, month, day, hour);
+	}
+	else if (*pos == 'Z')
+	{
+		++pos;
+	}
+	else if (*pos == '+' || *pos == '-')
+	{
+		const int sign = *pos++ == '-' ? -1 : 1;
+		int offset_hours = 0;
+		int offset_minutes = 0;
+		if (!parseDigits(pos, end, 2, offset_hours) || !consumeLiteral(pos, end, ":") || !parseDigits(pos, end, 2, offset_minutes))
+			return false;
+		offset_sec = sign * (offset_hours * 3600 + offset_minutes * 60);
+	}
+
+	if (pos != end)
+		return false;
+
+	const qint64 local_sec = daysFromCivil(year, month, day) * 86400 + hour * 3600 + minute * 60 + second;
+	epoch_ms = (local_sec - offset_sec) * 1000 + msec;
+	return true;
+}
+
+// The last non-space character closes the object, a line torn by a power loss ends somewhere inside it
+bool endsWithClosingBrace(const char* begin, const char* end)
+{
+	while (end > begin && isSpace(*(end - 1)))
+		--end;
+	return end > begin && *(end - 1) == '}';
+}
+
+/*
+* Single pass over {"key":value,...}. With timestamp_only the scan stops at the timestamp, the rest of the line
+* is only checked for the closing brace.
+* Returns false for anything outside of the flat schema, the caller then falls back to QJsonDocument.
+*/
+bool parseFlatObject(const char* pos, const char* end, WeatherData& data, bool timestamp_only)
+{
+	if (!consume(pos, end, '{'))
+		return false;
+
+	bool has_timestamp = false;
+	if (consume(pos, end, '}'))
+		return false; // No timestamp
+
+	do
+	{
+		const char* key_begin = nullptr;
+		const char* key_end = nullptr;
+		if (!parseSimpleString(pos, end, key_begin, key_end) || !consume(pos, end, ':'))
+			return false;
+
+		bool ok = true;
+		switch (fieldOf(key_begin, key_end))
+		{
+		case Field::Timestamp:
+		{
+			const char* value_begin = nullptr;
+			const char* value_end = nullptr;
+			ok = parseSimpleString(pos, end, value_begin, value_end) && parseIsoTimestamp(value_begin, value_end, data.timestamp.epoch_ms);
+			has_timestamp = ok;
+			if (ok && timestamp_only)
+				return endsWithClosingBrace(pos, end);
+			break;
+		}
+		case Field::Temperature: ok = parseNumber(pos, end, data.temperature); break;
+		case Field::SunSouth: ok = parseNumber(pos, end, data.sun_south); break;
+		case Field::SunEast: ok = parseNumber(pos, end, data.sun_east); break;
+		case Field::SunWest: ok = parseNumber(pos, end, data.sun_west); break;
+		case Field::Twilight: ok = parseBool(pos, end, data.twighlight); break;
+		case Field::Daylight: ok = parseNumber(pos, end, data.daylight); break;
+		case Field::Wind: ok = parseNumber(pos, end, data.wind); break;
+		case Field::Rain: ok = parseBool(pos, end, data.rain); break;
+		case Field::Unknown: ok = skipValue(pos, end); break;
+		}
+
+		if (!ok)
+			return false;
+	} while (consume(pos, end, ','));
+
+	if (!consume(pos, end, '}'))
+		return false;
+
+	skipSpace(pos, end);
+	return pos == end && has_timestamp;
+}
+
+bool isBlank(const char* begin, const char* end)
+{
+	return std::all_of(begin, end, isSpace);
+}
+
+// The previous QJsonDocument based parsing, for lines the flat parser does not handle
+bool parseLineFallback(const char* begin, const char* end, WeatherData& data)
+{
+	const QJsonDocument doc = QJsonDocument::fromJson(QByteArray::fromRawData(begin, static_cast<int>(end - begin)));
+	if (!doc.isObject())
+		return false;
+
+	// Without a valid timestamp the entry would be placed at the epoch
+	const QJsonObject obj = doc.object();
+	if (!QDateTime::fromString(obj[WeatherDataFormat::TIMESTAMP].toString(), Qt::ISODate).isValid())
+		return false;
+
+	data = WeatherDataLogger::fromJsonEntry(obj);
+	return true;
+}
+
+std::vector<WeatherData> parseRange(const char* pos, const char* end)
+{
+	std::vector<WeatherData> weather_data_list;
+	weather_data_list.reserve(static_cast<size_t>((end - pos) / ESTIMATED_LINE_SIZE));
+
+	while (pos < end)
+	{
+		const void* newline = std::memchr(pos, '\n', static_cast<size_t>(end - pos));
+		const char* line_end = newline ? static_cast<const char*>(newline) : end;
+
+		WeatherData data;
+		if (WeatherLogJsonParser::parseLine(pos, line_end, data))
+			weather_data_list.push_back(data);
+		else if (!isBlank(pos, line_end))
+			qWarning() << "WeatherLogJsonParser: Invalid JSON format in line:" << QByteArray(pos, static_cast<int>(line_end - pos));
+
+		pos = line_end + 1;
+	}
+	return weather_data_list;
+}
+}
+
+namespace WeatherLogJsonParser
+{
+
+bool parseLine(const char* begin, const char* end, WeatherData& data)
+{
+	if (isBlank(begin, end))
+		return false;
+
+	data = WeatherData{};
+	if (parseFlatObject(begin, end, data, false))
+		return true;
+
+	return parseLineFallback(begin, end, data);
+}
+
+bool parseTimestamp(const char* begin, const char* end, qint64& epoch_ms)
+{
+	WeatherData data{};
+	if (!parseFlatObject(begin, end, data, true) && !parseLine(begin, end, data))
+		return false;
+
+	epoch_ms = data.timestamp.epoch_ms;
+	return true;
+}
+
+std::vector<WeatherData> parse(const char* data, qint64 size, int max_threads)
+{
+	const char* end = data + size;
+	const int thread_count = max_threads > 0 ? max_threads : std::max(1, QThread::idealThreadCount());
+	const int chunk_count = static_cast<int>(std::clamp<qint64>(size / MIN_CHUNK_SIZE, 1, thread_count));
+	if (chunk_count == 1)
+		return parseRange(data, end);
+
+	// Chunk boundaries right after a newline
+	std::vector<const char*> bounds = { data };
+	for (int i = 1; i < chunk_count; ++i)
+	{
+		const char* pos = std::max(bounds.back(), data + size * i / chunk_count);
+		const void* newline = std::memchr(pos, '\n', static_cast<size_t>(end - pos));
+		bounds.push_back(newline ? static_cast<const char*>(newline) + 1 : end);
+	}
+	bounds.push_back(end);
+
+	std::vector<std::vector<WeatherData>> chunk_results(chunk_count);
+	QThreadPool pool;
+	pool.setMaxThreadCount(chunk_count);
+	for (int i = 0; i < chunk_count; ++i)
+		pool.start([&chunk_results, &bounds, i]() { chunk_results[i] = parseRange(bounds[i], bounds[i + 1]); });
+	pool.waitForDone();
+
+	size_t total = 0;
+	for (const auto& result : chunk_results)
+		total += result.size();
+
+	std::vector<WeatherData> weather_data_list;
+	weather_data_list.reserve(total);
+	for (const auto& result : chunk_results)
+		weather_data_list.insert(weather_data_list.end(), result.begin(), result.end());
+	return weather_data_list;
+}
+
+std::vector<WeatherData> parse(const QByteArray& data, int max_threads)
+{
+	return parse(data.constData(), data.size(), max_threads);
+}
+
+}
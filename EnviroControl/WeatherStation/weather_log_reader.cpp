@@ -0,0 +1,372 @@
+#include "WeatherLogReader.h"
+#include "WeatherLogBinary.h"
+#include "WeatherLogJsonParser.h"
+#include "WeatherLogRecovery.h"
+
+#include <QtCore/QDebug>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+const char* findNewline(const char* pos, const char* end)
+{
+	const void* found = std::memchr(pos, '\n', static_cast<size_t>(end - pos));
+	return found ? static_cast<const char*>(found) : end;
+}
+
+// Start of the first line beginning at or after pos
+const char* lineStartAtOrAfter(const char* begin, const char* pos, const char* end)
+{
+	if (pos <= begin)
+		return begin;
+
+	const char* newline = findNewline(pos - 1, end);
+	return newline == end ? end : newline + 1;
+}
+
+const char* nextLineStart(const char* line, const char* end)
+{
+	const char* newline = findNewline(line, end);
+	return newline == end ? end : newline + 1;
+}
+
+// Invalid lines sort before everything, so they do not stop the search
+qint64 lineTimestamp(const char* line, const char* end)
+{
+	qint64 epoch_ms = 0;
+	if (!WeatherLogJsonParser::parseTimestamp(line, findNewline(line, end), epoch_ms))
+		return std::numeric_limits<qint64>::min();
+	return epoch_ms;
+}
+
+bool isBlankLine(const char* line, const char* end)
+{
+	for (const char* pos = line; pos < end && *pos != '\n'; ++pos)
+	{
+		if (*pos != ' ' && *pos != '\r' && *pos != '\t')
+			return false;
+	}
+	return true;
+}
+}
+
+// === WeatherLogView ===
+
+WeatherLogView::WeatherLogView(Cfg::LogFormat format, const char* begin, const char* end, int record_size, int binary_version) :
+	_format(format), _begin(begin), _end(end), _record_size(record_size), _binary_version(binary_version)
+{
+}
+
+WeatherLogView::Iterator WeatherLogView::begin() const
+{
+	return Iterator(this, _begin);
+}
+
+WeatherLogView::Iterator WeatherLogView::end() const
+{
+	return Iterator(this, _end);
+}
+
+bool WeatherLogView::empty() const
+{
+	return begin() == end();
+}
+
+size_t WeatherLogView::size() const
+{
+	return static_cast<size_t>(std::distance(begin(), end()));
+}
+
+std::vector<WeatherData> WeatherLogView::toVector() const
+{
+	std::vector<WeatherData> weather_data_list;
+	if (_format == Cfg::LogFormat::Binary && _record_size > 0)
+		weather_data_list.reserve(static_cast<size_t>((_end - _begin) / _record_size)); // Torn records included
+
+	for (const auto& data : *this)
+		weather_data_list.push_back(data);
+	return weather_data_list;
+}
+
+WeatherLogView::Iterator::Iterator(const WeatherLogView* view, const char* pos) :
+	_view(view), _pos(pos)
+{
+	seekValidEntry();
+}
+
+// Skips blank lines, corrupt lines and torn records, the same way the whole-file parsers do
+void WeatherLogView::Iterator::seekValidEntry()
+{
+	if (!_view)
+		return;
+
+	if (_view->_format == Cfg::LogFormat::Binary)
+	{
+		WeatherLogBinary::Header header;
+		header.version = static_cast<uint16_t>(_view->_binary_version);
+		header.record_size = static_cast<uint16_t>(_view->_record_size);
+
+		for (; _pos < _view->_end; _pos += _view->_record_size)
+		{
+			if (WeatherLogBinary::isValidRecord(_pos, header))
+			{
+				_data = WeatherLogBinary::decodeRecord(_pos);
+				return;
+			}
+		}
+		return;
+	}
+
+	for (; _pos < _view->_end; _pos = nextLineStart(_pos, _view->_end))
+	{
+		if (!isBlankLine(_pos, _view->_end) && WeatherLogJsonParser::parseLine(_pos, findNewline(_pos, _view->_end), _data))
+			return;
+	}
+}
+
+WeatherLogView::Iterator& WeatherLogView::Iterator::operator++()
+{
+	if (_view->_format == Cfg::LogFormat::Binary)
+		_pos += _view->_record_size;
+	else
+		_pos = nextLineStart(_pos, _view->_end);
+
+	seekValidEntry();
+	return *this;
+}
+
+WeatherLogView::Iterator WeatherLogView::Iterator::operator++(int)
+{
+	Iterator previous = *this;
+	++(*this);
+	return previous;
+}
+
+// === WeatherLogReader ===
+
+WeatherLogReader::~WeatherLogReader()
+{
+	close();
+}
+
+bool WeatherLogReader::open(const QString& file_path)
+{
+	close();
+
+	_file.setFileName(file_path);
+	if (!_file.open(QIODevice::ReadOnly))
+	{
+		qWarning() << "WeatherLogReader: Failed to open log file for reading:" << file_path;
+		return false;
+	}
+
+	return map();
+}
+
+bool WeatherLogReader::openData(const QByteArray& data)
+{
+	close();
+
+	_data = data;
+	_mapped = reinterpret_cast<const uchar*>(_data.constData());
+	_mapped_size = _data.size();
+	detectFormat();
+	return true;
+}
+
+void WeatherLogReader::close()
+{
+	unmap();
+	_data.clear();
+	if (_file.isOpen())
+		_file.close();
+}
+
+bool WeatherLogReader::refresh()
+{
+	if (!_data.isEmpty())
+		return true;
+
+	if (!_file.isOpen())
+		return false;
+
+	if (_file.size() == _mapped_size)
+		return true;
+
+	unmap();
+	return map();
+}
+
+bool WeatherLogReader::isOpen() const
+{
+	return _file.isOpen() || !_data.isEmpty();
+}
+
+Cfg::LogFormat WeatherLogReader::format() const
+{
+	return _format;
+}
+
+WeatherLogView WeatherLogReader::query(qint64 from_epoch_ms, qint64 to_epoch_ms) const
+{
+	if (to_epoch_ms <= from_epoch_ms)
+		return WeatherLogView(_format, dataBegin(), dataBegin(), _record_size, _binary_version);
+
+	return WeatherLogView(_format, lowerBound(from_epoch_ms), lowerBound(to_epoch_ms), _record_size, _binary_version);
+}
+
+WeatherLogView WeatherLogReader::query(const SampleTime& from, const SampleTime& to) const
+{
+	return query(from.epoch_ms, to.epoch_ms);
+}
+
+WeatherLogView WeatherLogReader::latest(size_t n) const
+{
+	const char* begin = dataBegin();
+	const char* end = dataEnd();
+
+	if (_format == Cfg::LogFormat::Binary)
+	{
+		const size_t count = std::min(n, static_cast<size_t>((end - begin) / _record_size));
+		return WeatherLogView(_format, end - count * _record_size, end, _record_size, _binary_version);
+	}
+
+	// Walk back over n non-blank lines
+	const char* start = end;
+	size_t count = 0;
+	while (count < n && start > begin)
+	{
+		const char* line_end = start;
+		start = line_end - 1; // Newline of the previous line
+		while (start > begin && start[-1] != '\n')
+			--start;
+
+		if (!isBlankLine(start, line_end))
+			++count;
+	}
+
+	return WeatherLogView(_format, start, end, _record_size, _binary_version);
+}
+
+WeatherLogView WeatherLogReader::all() const
+{
+	return WeatherLogView(_format, dataBegin(), dataEnd(), _record_size, _binary_version);
+}
+
+bool WeatherLogReader::map()
+{
+	_mapped_size = _file.size();
+	if (_mapped_size == 0)
+	{
+		detectFormat();
+		return true; // Nothing to map yet
+	}
+
+	_mapped = _file.map(0, _mapped_size);
+	if (!_mapped)
+	{
+		qWarning() << "WeatherLogReader: Failed to map log file:" << _file.fileName() << _file.errorString();
+		_mapped_size = 0;
+		return false;
+	}
+
+	detectFormat();
+	return true;
+}
+
+void WeatherLogReader::detectFormat()
+{
+	_valid_size = WeatherLogRecovery::validSize(reinterpret_cast<const char*>(_mapped), _mapped_size);
+
+	WeatherLogBinary::Header header;
+	if (WeatherLogBinary::decodeHeader(reinterpret_cast<const char*>(_mapped), _mapped_size, header))
+	{
+		_format = Cfg::LogFormat::Binary;
+		_record_size = header.record_size;
+		_binary_version = header.version;
+	}
+	else
+	{
+		_format = Cfg::LogFormat::JsonLines;
+		_record_size = 0;
+		_binary_version = 0;
+	}
+}
+
+void WeatherLogReader::unmap()
+{
+	if (_mapped && _data.isEmpty())
+		_file.unmap(const_cast<uchar*>(_mapped));
+	_mapped = nullptr;
+	_mapped_size = 0;
+	_valid_size = 0;
+}
+
+const char* WeatherLogReader::dataBegin() const
+{
+	const char* begin = reinterpret_cast<const char*>(_mapped);
+	if (_format == Cfg::LogFormat::Binary)
+		return begin + WeatherLogBinary::HEADER_SIZE;
+	return begin;
+}
+
+// A partially written or torn trailing record or line is not part of the data
+const char* WeatherLogReader::dataEnd() const
+{
+	const char* begin = dataBegin();
+	if (!_mapped)
+		return begin;
+
+	return std::max(begin, reinterpret_cast<const char*>(_mapped) + _valid_size);
+}
+
+const char* WeatherLogReader::lowerBound(qint64 epoch_ms) const
+{
+	if (_format == Cfg::LogFormat::Binary)
+		return lowerBoundBinary(epoch_ms);
+	return lowerBoundJsonLines(epoch_ms);
+}
+
+const char* WeatherLogReader::lowerBoundBinary(qint64 epoch_ms) const
+{
+	const char* begin = dataBegin();
+	qint64 low = 0;
+	qint64 high = (dataEnd() - begin) / _record_size;
+	while (low < high)
+	{
+		const qint64 mid = low + (high - low) / 2;
+		if (WeatherLogBinary::recordTimestamp(begin + mid * _record_size) < epoch_ms)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+	return begin + low * _record_size;
+}
+
+/*
+* Binary search over byte offsets: a probe position is moved to the next line start and that line is parsed.
+* Only O(log(file size)) lines are parsed.
+*/
+const char* WeatherLogReader::lowerBoundJsonLines(qint64 epoch_ms) const
+{
+	const char* begin = dataBegin();
+	const char* end = dataEnd();
+
+	const char* low = begin; // Always a line start
+	const char* high = end;
+	while (low < high)
+	{
+		const char* mid = lineStartAtOrAfter(begin, low + (high - low) / 2, end);
+		if (mid >= high)
+			mid = low; // No line starts between the middle and high, check the line at low
+
+		if (lineTimestamp(mid, end) < epoch_ms)
+			low = nextLineStart(mid, end);
+		else
+			high = mid;
+	}
+	return low;
+}
@@ -0,0 +1,162 @@
+#include "WeatherLogRecovery.h"
+#include "WeatherLogBinary.h"
+
+#include <QtCore/QDebug>
+#include <QtCore/QFile>
+#include <QtCore/QJsonDocument>
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+// A torn tail is at most one write of BufferedLogWriter (max 1 MiB pending) plus the blocks the file system
+// allocated for it. More invalid data at the end is not a torn append, the file is left alone.
+const qint64 MAX_TORN_BYTES = 2 * 1024 * 1024;
+
+bool isBlankLine(const char* line, const char* end)
+{
+	for (const char* pos = line; pos < end; ++pos)
+	{
+		if (*pos != ' ' && *pos != '\r' && *pos != '\t')
+			return false;
+	}
+	return true;
+}
+
+// A header cut off by a power loss, before any record was written
+bool isTornHeader(const char* data, qint64 size)
+{
+	if (size >= WeatherLogBinary::HEADER_SIZE)
+		return false;
+
+	const qint64 magic_size = std::min<qint64>(size, sizeof(WeatherLogBinary::MAGIC));
+	return std::memcmp(data, WeatherLogBinary::MAGIC, static_cast<size_t>(magic_size)) == 0;
+}
+
+// Header and whole records, -1 if no record in the last MAX_TORN_BYTES is valid
+qint64 validBinarySize(const char* data, qint64 size, const WeatherLogBinary::Header& header)
+{
+	const qint64 record_count = (size - WeatherLogBinary::HEADER_SIZE) / header.record_size;
+	for (qint64 i = record_count; i > 0; --i)
+	{
+		const qint64 record_end = WeatherLogBinary::HEADER_SIZE + i * header.record_size;
+		if (size - record_end > MAX_TORN_BYTES)
+			return -1;
+		if (WeatherLogBinary::isValidRecord(data + record_end - header.record_size, header))
+			return record_end;
+	}
+	return WeatherLogBinary::HEADER_SIZE;
+}
+
+/*
+* The last line must end with a newline, BufferedLogWriter writes entry and newline together. Invalid lines are
+* removed from the end, blank lines are kept, if a valid line precedes them.
+* Only the last MAX_TORN_BYTES are scanned, -1 if no valid line ends in them.
+*/
+qint64 validJsonLinesSize(const char* data, qint64 size)
+{
+	const char* scan_begin = data + std::max<qint64>(0, size - MAX_TORN_BYTES);
+	const char* end = data + size;
+	while (end > scan_begin && end[-1] != '\n')
+		--end;
+
+	const char* valid_end = end;
+	while (end > scan_begin)
+	{
+		const char* line_end = end - 1; // Newline
+		const char* line = line_end;
+		while (line > scan_begin && line[-1] != '\n')
+			--line;
+		if (line > data && line[-1] != '\n')
+			return -1; // Starts before the scanned tail
+
+		if (!isBlankLine(line, line_end))
+		{
+			if (QJsonDocument::fromJson(QByteArray::fromRawData(line, static_cast<int>(line_end - line))).isObject())
+				return valid_end - data;
+			valid_end = line; // Torn line, blank lines after it go as well
+		}
+		end = line;
+	}
+	return end == data ? 0 : -1;
+}
+
+// Valid prefix, -1 if the end of the log is not a torn append
+qint64 validTailSize(const char* data, qint64 size)
+{
+	if (size <= 0)
+		return 0;
+
+	WeatherLogBinary::Header header;
+	if (WeatherLogBinary::decodeHeader(data, size, header))
+		return validBinarySize(data, size, header);
+
+	if (isTornHeader(data, size))
+		return 0;
+
+	return validJsonLinesSize(data, size);
+}
+}
+
+namespace WeatherLogRecovery
+{
+
+qint64 validSize(const char* data, qint64 size)
+{
+	const qint64 valid_size = validTailSize(data, size);
+	if (valid_size >= 0)
+		return valid_size;
+
+	// Damaged, but not by an append: whole records, the readers skip the invalid ones
+	WeatherLogBinary::Header header;
+	if (WeatherLogBinary::decodeHeader(data, size, header))
+		return WeatherLogBinary::HEADER_SIZE + (size - WeatherLogBinary::HEADER_SIZE) / header.record_size * header.record_size;
+	return size;
+}
+
+qint64 recoverFile(const QString& file_path)
+{
+	QFile file(file_path);
+	if (!file.exists() || file.size() == 0)
+		return 0;
+
+	if (!file.open(QIODevice::ReadOnly))
+	{
+		qWarning() << "WeatherLogRecovery: Failed to open log file:" << file_path << file.errorString();
+		return -1;
+	}
+
+	const qint64 size = file.size();
+	const uchar* mapped = file.map(0, size);
+	if (!mapped)
+	{
+		qWarning() << "WeatherLogRecovery: Failed to map log file:" << file_path << file.errorString();
+		return -1;
+	}
+
+	// Only the pages at the end are touched
+	const qint64 valid_size = validTailSize(reinterpret_cast<const char*>(mapped), size);
+	file.unmap(const_cast<uchar*>(mapped));
+	file.close();
+
+	if (valid_size < 0)
+	{
+		qWarning() << "WeatherLogRecovery: No valid entry in the last" << MAX_TORN_BYTES << "bytes, not truncating:" << file_path;
+		return -1;
+	}
+
+	if (valid_size == size)
+		return 0;
+
+	if (!QFile::resize(file_path, valid_size))
+	{
+		qWarning() << "WeatherLogRecovery: Failed to truncate torn entries of log file:" << file_path;
+		return -1;
+	}
+
+	qWarning() << "WeatherLogRecovery: Removed" << size - valid_size << "bytes of torn entries from the end of" << file_path;
+	return size - valid_size;
+}
+
+}
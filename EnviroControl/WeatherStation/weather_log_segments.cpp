@@ -0,0 +1,328 @@
+#include "WeatherLogSegments.h"
+#include "WeatherLogReader.h"
+
+#include <QtCore/QDebug>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+#include <QtCore/QSaveFile>
+
+#include <algorithm>
+#include <iterator>
+
+namespace
+{
+const QString MANIFEST_FILE_NAME = "manifest.json";
+const int MANIFEST_VERSION = 1;
+
+QString formatName(Cfg::LogFormat format)
+{
+	return format == Cfg::LogFormat::Binary ? "binary" : "jsonl";
+}
+
+Cfg::LogFormat formatFromName(const QString& name)
+{
+	return name == "binary" ? Cfg::LogFormat::Binary : Cfg::LogFormat::JsonLines;
+}
+
+QJsonObject toJson(const WeatherLogSegment& segment)
+{
+	QJsonObject obj;
+	obj["file"] = segment.file_name;
+	obj["day"] = segment.day.toString(Qt::ISODate);
+	obj["format"] = formatName(segment.format);
+	obj["first_ms"] = segment.first_epoch_ms;
+	if (segment.closed)
+		obj["last_ms"] = segment.last_epoch_ms;
+	obj["size"] = segment.size_bytes;
+	obj["closed"] = segment.closed;
+	obj["compressed"] = segment.compressed;
+	return obj;
+}
+
+WeatherLogSegment fromJson(const QJsonObject& obj)
+{
+	WeatherLogSegment segment;
+	segment.file_name = obj["file"].toString();
+	segment.day = QDate::fromString(obj["day"].toString(), Qt::ISODate);
+	segment.format = formatFromName(obj["format"].toString());
+	segment.first_epoch_ms = obj["first_ms"].toInteger();
+	segment.closed = obj["closed"].toBool();
+	if (segment.closed)
+		segment.last_epoch_ms = obj["last_ms"].toInteger();
+	segment.size_bytes = obj["size"].toInteger();
+	segment.compressed = obj["compressed"].toBool();
+	return segment;
+}
+
+// Opens a segment file for reading, compressed segments are decompressed into memory
+bool openSegment(WeatherLogReader& reader, const QString& file_path, bool compressed)
+{
+	if (!compressed)
+		return reader.open(file_path);
+
+	QFile file(file_path);
+	if (!file.open(QIODevice::ReadOnly))
+	{
+		qWarning() << "WeatherLogArchive: Failed to open compressed log segment:" << file_path;
+		return false;
+	}
+
+	const QByteArray data = qUncompress(file.readAll());
+	if (data.isEmpty())
+	{
+		qWarning() << "WeatherLogArchive: Failed to decompress log segment:" << file_path;
+		return false;
+	}
+	return reader.openData(data);
+}
+}
+
+// === WeatherLogSegment ===
+
+QString WeatherLogSegment::storedFileName() const
+{
+	return compressed ? file_name + WeatherLogManifest::COMPRESSED_SUFFIX : file_name;
+}
+
+// === WeatherLogManifest ===
+
+WeatherLogManifest::WeatherLogManifest(const QString& directory) :
+	_directory(directory)
+{
+}
+
+QString WeatherLogManifest::segmentDirectory(const QString& log_file_path)
+{
+	const QFileInfo log_file_info(log_file_path);
+	return QDir(log_file_info.absolutePath()).filePath(log_file_info.completeBaseName() + "_segments");
+}
+
+bool WeatherLogManifest::load()
+{
+	_segments.clear();
+
+	QFile file(QDir(_directory).filePath(MANIFEST_FILE_NAME));
+	if (!file.exists())
+		return true;
+
+	if (!file.open(QIODevice::ReadOnly))
+	{
+		qWarning() << "WeatherLogManifest: Failed to open manifest:" << file.fileName() << file.errorString();
+		return false;
+	}
+
+	const QJsonDocument doc = QJsonDocument::fromJson(file.readAll());
+	if (!doc.isObject() || !doc.object()["segments"].isArray())
+	{
+		qWarning() << "WeatherLogManifest: Invalid manifest:" << file.fileName();
+		return false;
+	}
+
+	for (const QJsonValue& value : doc.object()["segments"].toArray())
+		_segments.push_back(fromJson(value.toObject()));
+
+	std::stable_sort(_segments.begin(), _segments.end(), [](const auto& lhs, const auto& rhs) { return lhs.first_epoch_ms < rhs.first_epoch_ms; });
+	return true;
+}
+
+// Written to a temporary file and renamed, so a power loss never leaves a half written manifest
+bool WeatherLogManifest::save() const
+{
+	if (!QDir().mkpath(_directory))
+	{
+		qWarning() << "WeatherLogManifest: Failed to create segment directory:" << _directory;
+		return false;
+	}
+
+	QJsonArray segments;
+	for (const auto& segment : _segments)
+		segments.append(toJson(segment));
+
+	QJsonObject root;
+	root["version"] = MANIFEST_VERSION;
+	root["segments"] = segments;
+
+	QSaveFile file(QDir(_directory).filePath(MANIFEST_FILE_NAME));
+	if (!file.open(QIODevice::WriteOnly))
+	{
+		qWarning() << "WeatherLogManifest: Failed to write manifest:" << file.fileName() << file.errorString();
+		return false;
+	}
+
+	file.write(QJsonDocument(root).toJson(QJsonDocument::Indented));
+	return file.commit();
+}
+
+const QString& WeatherLogManifest::directory() const
+{
+	return _directory;
+}
+
+QString WeatherLogManifest::filePath(const WeatherLogSegment& segment) const
+{
+	return QDir(_directory).filePath(segment.storedFileName());
+}
+
+const std::vector<WeatherLogSegment>& WeatherLogManifest::segments() const
+{
+	return _segments;
+}
+
+WeatherLogSegment* WeatherLogManifest::activeSegment()
+{
+	auto it = std::find_if(_segments.rbegin(), _segments.rend(), [](const auto& segment) { return !segment.closed; });
+	return it == _segments.rend() ? nullptr : &*it;
+}
+
+WeatherLogSegment* WeatherLogManifest::findSegment(const QString& file_name)
+{
+	auto it = std::find_if(_segments.begin(), _segments.end(), [&](const auto& segment) { return segment.file_name == file_name; });
+	return it == _segments.end() ? nullptr : &*it;
+}
+
+WeatherLogSegment& WeatherLogManifest::openSegment(const QDate& day, Cfg::LogFormat format, qint64 first_epoch_ms)
+{
+	const QString base_name = QString("weather_%1").arg(day.toString("yyyy-MM-dd"));
+	const QString extension = format == Cfg::LogFormat::Binary ? "bin" : "jsonl";
+
+	// A day can have more than one segment, if the log format was changed in between
+	QString file_name = QString("%1.%2").arg(base_name, extension);
+	for (int index = 2; findSegment(file_name) || QFileInfo::exists(QDir(_directory).filePath(file_name)); ++index)
+		file_name = QString("%1_%2.%3").arg(base_name).arg(index).arg(extension);
+
+	WeatherLogSegment segment;
+	segment.file_name = file_name;
+	segment.day = day;
+	segment.format = format;
+	segment.first_epoch_ms = first_epoch_ms;
+	_segments.push_back(segment);
+	return _segments.back();
+}
+
+WeatherLogSegment& WeatherLogManifest::addClosedSegment(const WeatherLogSegment& segment)
+{
+	auto it = std::upper_bound(_segments.begin(), _segments.end(), segment.first_epoch_ms,
+		[](qint64 first_epoch_ms, const auto& other) { return first_epoch_ms < other.first_epoch_ms; });
+	it = _segments.insert(it, segment);
+	it->closed = true;
+	return *it;
+}
+
+void WeatherLogManifest::closeActiveSegment(qint64 last_epoch_ms, qint64 size_bytes)
+{
+	WeatherLogSegment* segment = activeSegment();
+	if (!segment)
+		return;
+
+	segment->closed = true;
+	segment->last_epoch_ms = std::max(segment->first_epoch_ms, last_epoch_ms);
+	segment->size_bytes = size_bytes;
+}
+
+void WeatherLogManifest::markCompressed(const QString& file_name, qint64 size_bytes)
+{
+	if (WeatherLogSegment* segment = findSegment(file_name))
+	{
+		segment->compressed = true;
+		segment->size_bytes = size_bytes;
+	}
+}
+
+void WeatherLogManifest::removeSegment(const QString& file_name)
+{
+	_segments.erase(std::remove_if(_segments.begin(), _segments.end(), [&](const auto& segment) { return segment.file_name == file_name; }), _segments.end());
+}
+
+std::vector<WeatherLogSegment> WeatherLogManifest::segmentsOverlapping(qint64 from_epoch_ms, qint64 to_epoch_ms) const
+{
+	std::vector<WeatherLogSegment> overlapping;
+	std::copy_if(_segments.begin(), _segments.end(), std::back_inserter(overlapping),
+		[&](const auto& segment) { return segment.overlaps(from_epoch_ms, to_epoch_ms); });
+	return overlapping;
+}
+
+std::vector<WeatherLogSegment> WeatherLogManifest::expiredSegments(const QDate& today, const Cfg::LogStorageConfig& cfg) const
+{
+	std::vector<WeatherLogSegment> expired;
+	qint64 total_bytes = 0;
+	for (const auto& segment : _segments)
+	{
+		// The manifest only knows the size of the segment being written from when it was opened
+		total_bytes += segment.closed ? segment.size_bytes : QFileInfo(filePath(segment)).size();
+	}
+
+	const qint64 max_total_bytes = static_cast<qint64>(cfg.max_total_mb) * 1024 * 1024;
+	for (const auto& segment : _segments)
+	{
+		if (!segment.closed)
+			continue; // Never remove the segment being written
+
+		const bool too_old = cfg.retention_days > 0 && segment.day.daysTo(today) >= cfg.retention_days;
+		const bool too_large = max_total_bytes > 0 && total_bytes > max_total_bytes;
+		if (!too_old && !too_large)
+			break; // Segments are ordered by time, the newer ones are kept as well
+
+		expired.push_back(segment);
+		total_bytes -= segment.size_bytes;
+	}
+	return expired;
+}
+
+// === WeatherLogArchive ===
+
+WeatherLogArchive::WeatherLogArchive(const Cfg::WeatherStationConfig& cfg) :
+	_log_file_path(cfg.log_file_path), _segmented(cfg.log_storage_cfg.segmented)
+{
+}
+
+std::vector<WeatherData> WeatherLogArchive::query(qint64 from_epoch_ms, qint64 to_epoch_ms) const
+{
+	if (!_segmented)
+		return readSegment(_log_file_path, false, from_epoch_ms, to_epoch_ms);
+
+	WeatherLogManifest manifest(WeatherLogManifest::segmentDirectory(_log_file_path));
+	manifest.load();
+
+	std::vector<WeatherData> weather_data_list;
+	for (const auto& segment : manifest.segmentsOverlapping(from_epoch_ms, to_epoch_ms))
+	{
+		const auto entries = readSegment(manifest.filePath(segment), segment.compressed, from_epoch_ms, to_epoch_ms);
+		weather_data_list.insert(weather_data_list.end(), entries.begin(), entries.end());
+	}
+	return weather_data_list;
+}
+
+std::vector<WeatherData> WeatherLogArchive::latest(size_t n) const
+{
+	WeatherLogReader reader;
+	if (!_segmented)
+		return reader.open(_log_file_path) ? reader.latest(n).toVector() : std::vector<WeatherData>();
+
+	WeatherLogManifest manifest(WeatherLogManifest::segmentDirectory(_log_file_path));
+	manifest.load();
+
+	// Newest segment first, until n entries are collected
+	std::vector<WeatherData> weather_data_list;
+	const auto& segments = manifest.segments();
+	for (auto it = segments.rbegin(); it != segments.rend() && weather_data_list.size() < n; ++it)
+	{
+		if (!openSegment(reader, manifest.filePath(*it), it->compressed))
+			continue;
+
+		const auto entries = reader.latest(n - weather_data_list.size()).toVector();
+		weather_data_list.insert(weather_data_list.begin(), entries.begin(), entries.end());
+	}
+	return weather_data_list;
+}
+
+std::vector<WeatherData> WeatherLogArchive::readSegment(const QString& file_path, bool compressed, qint64 from_epoch_ms, qint64 to_epoch_ms)
+{
+	WeatherLogReader reader;
+	if (!openSegment(reader, file_path, compressed))
+		return {};
+	return reader.query(from_epoch_ms, to_epoch_ms).toVector();
+}
@@ -0,0 +1,339 @@
+#include "WeatherLogWriter.h"
+
+#include "WeatherDataLogger.h"
+#include "WeatherLogBinary.h"
+#include "WeatherLogReader.h"
+
+#include <QtCore/QDir>
+#include <QtCore/QJsonObject>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QSaveFile>
+#include <QtCore/QThread>
+
+namespace
+{
+// Runs in the compression pool: file -> file.z (qCompress format), returns the compressed size or -1
+qint64 compressFile(const QString& file_path)
+{
+	QFile file(file_path);
+	if (!file.open(QIODevice::ReadOnly))
+		return -1;
+
+	const QByteArray compressed = qCompress(file.readAll());
+	file.close();
+
+	QSaveFile output(file_path + WeatherLogManifest::COMPRESSED_SUFFIX);
+	if (!output.open(QIODevice::WriteOnly) || output.write(compressed) != compressed.size() || !output.commit())
+		return -1;
+
+	QFile::remove(file_path);
+	return compressed.size();
+}
+}
+
+WeatherLogWriter::WeatherLogWriter(const Cfg::WeatherStationConfig& cfg) :
+	QObject(nullptr), _log_file_path(cfg.log_file_path), _log_format(cfg.log_format), _writer_cfg(cfg.log_writer_cfg),
+	_storage_cfg(cfg.log_storage_cfg), _pipeline_cfg(cfg.log_pipeline_cfg), _log_rollups(cfg.log_rollups)
+{
+	// Compressing closed segments must not compete with the acquisition
+	_compression_pool.setMaxThreadCount(1);
+	_compression_pool.setThreadPriority(QThread::LowestPriority);
+}
+
+WeatherLogWriter::~WeatherLogWriter()
+{
+	close();
+	_compression_pool.waitForDone();
+}
+
+void WeatherLogWriter::open()
+{
+	if (_storage_cfg.segmented)
+	{
+		initSegments();
+	}
+	else
+	{
+		moveAwayMismatchingLogFile(_log_file_path);
+		openWriter(_log_file_path);
+	}
+
+	if (_pipeline_cfg.raw_capture)
+	{
+		const QString raw_file_path = streamFilePath(_log_file_path, "raw", _log_format);
+		moveAwayMismatchingLogFile(raw_file_path);
+		_raw_writer = std::make_unique<BufferedLogWriter>(raw_file_path, _writer_cfg);
+		if (_log_format == Cfg::LogFormat::Binary)
+			_raw_writer->setFileHeader(WeatherLogBinary::encodeHeader());
+	}
+
+	if (_pipeline_cfg.aggregate)
+		_aggregated_writer = std::make_unique<BufferedLogWriter>(streamFilePath(_log_file_path, "aggregated", Cfg::LogFormat::JsonLines), _writer_cfg);
+
+	if (_pipeline_cfg.events)
+		_event_writer = std::make_unique<BufferedLogWriter>(streamFilePath(_log_file_path, "events", Cfg::LogFormat::JsonLines), _writer_cfg);
+
+	if (_log_rollups)
+		_rollups = std::make_unique<WeatherRollupStore>(_log_file_path, _writer_cfg);
+}
+
+void WeatherLogWriter::close()
+{
+	for (auto* writer : { _writer.get(), _raw_writer.get(), _aggregated_writer.get(), _event_writer.get() })
+	{
+		if (writer)
+			writer->close();
+	}
+	_rollups.reset(); // Saves the partial buckets
+}
+
+void WeatherLogWriter::writeLogEntry(const WeatherData& data)
+{
+	if (_storage_cfg.segmented)
+		rotateSegment(data);
+
+	if (!_writer)
+		return;
+
+	appendEntry(*_writer, _log_format, data);
+	_last_written_epoch_ms = data.timestamp.epoch_ms;
+}
+
+void WeatherLogWriter::writeRawSample(const WeatherData& data)
+{
+	if (_raw_writer)
+		appendEntry(*_raw_writer, _log_format, data);
+}
+
+void WeatherLogWriter::addToRollups(const WeatherData& data)
+{
+	if (_rollups)
+		_rollups->add(data);
+}
+
+void WeatherLogWriter::writeAggregate(const RollupBucket& interval)
+{
+	if (_aggregated_writer)
+		_aggregated_writer->append(QJsonDocument(interval.toJson()).toJson(QJsonDocument::Compact));
+}
+
+// The sample that changed the state, plus the name of the change
+void WeatherLogWriter::writeEvent(const WeatherData& data, const QString& event)
+{
+	if (!_event_writer)
+		return;
+
+	QJsonObject entry = WeatherDataLogger::toJsonEntry(data);
+	entry["event"] = event;
+	_event_writer->append(QJsonDocument(entry).toJson(QJsonDocument::Compact));
+}
+
+void WeatherLogWriter::flush()
+{
+	for (auto* writer : { _writer.get(), _raw_writer.get(), _aggregated_writer.get(), _event_writer.get() })
+	{
+		if (writer)
+			writer->flush();
+	}
+	if (_rollups)
+		_rollups->flush();
+}
+
+// <log base name>_<stream>.<jsonl|bin>, next to the main log
+QString WeatherLogWriter::streamFilePath(const QString& log_file_path, const QString& stream, Cfg::LogFormat format)
+{
+	const QFileInfo log_file_info(log_file_path);
+	const QString suffix = format == Cfg::LogFormat::Binary ? "bin" : "jsonl";
+	return QDir(log_file_info.absolutePath()).filePath(QString("%1_%2.%3").arg(log_file_info.completeBaseName(), stream, suffix));
+}
+
+void WeatherLogWriter::appendEntry(BufferedLogWriter& writer, Cfg::LogFormat format, const WeatherData& data)
+{
+	if (format == Cfg::LogFormat::Binary)
+		writer.appendRaw(WeatherLogBinary::encodeRecord(data));
+	else
+		writer.append(QJsonDocument(WeatherDataLogger::toJsonEntry(data)).toJson(QJsonDocument::Compact)); // JSON entry as a single line
+}
+
+void WeatherLogWriter::openWriter(const QString& file_path)
+{
+	if (_writer)
+		_writer->close();
+
+	_writer = std::make_unique<BufferedLogWriter>(file_path, _writer_cfg);
+	if (_log_format == Cfg::LogFormat::Binary)
+		_writer->setFileHeader(WeatherLogBinary::encodeHeader());
+}
+
+/*
+* Segmented storage: continues today's segment, if it has the configured format. Any other open segment is
+* closed, closed segments left uncompressed (e.g. by a power loss) are compressed now.
+*/
+void WeatherLogWriter::initSegments()
+{
+	_manifest = std::make_unique<WeatherLogManifest>(WeatherLogManifest::segmentDirectory(_log_file_path));
+	if (!_manifest->load())
+		qWarning() << "WeatherLogWriter: Starting with an empty segment list, the old manifest is overwritten";
+
+	adoptSingleLogFile();
+
+	if (WeatherLogSegment* active = _manifest->activeSegment())
+	{
+		const QString file_path = _manifest->filePath(*active);
+		WeatherLogReader reader;
+		const auto latest = reader.open(file_path) ? reader.latest(1).toVector() : std::vector<WeatherData>();
+		_last_written_epoch_ms = latest.empty() ? active->first_epoch_ms : latest.back().timestamp.epoch_ms;
+
+		if (active->day == QDate::currentDate() && active->format == _log_format)
+			openWriter(file_path);
+		else
+			closeActiveSegment(_last_written_epoch_ms);
+	}
+
+	for (const auto& segment : _manifest->segments())
+	{
+		if (!segment.closed || segment.compressed || !_storage_cfg.compress_closed_segments)
+			continue;
+
+		// Compressed before the manifest could be updated
+		if (!QFileInfo::exists(_manifest->filePath(segment)) && QFileInfo::exists(_manifest->filePath(segment) + WeatherLogManifest::COMPRESSED_SUFFIX))
+			onSegmentCompressed(segment.file_name, QFileInfo(_manifest->filePath(segment) + WeatherLogManifest::COMPRESSED_SUFFIX).size());
+		else
+			compressSegment(segment);
+	}
+
+	applyRetention();
+	_manifest->save();
+}
+
+// The log file of the non-segmented storage becomes the oldest segment
+void WeatherLogWriter::adoptSingleLogFile()
+{
+	WeatherLogReader reader;
+	if (!QFileInfo(_log_file_path).size() || !reader.open(_log_file_path))
+		return;
+
+	const WeatherLogView entries = reader.all();
+	if (entries.empty())
+		return;
+
+	WeatherLogSegment segment;
+	segment.format = reader.format();
+	segment.first_epoch_ms = (*entries.begin()).timestamp.epoch_ms;
+	for (const auto& data : entries) // The newest entry might be invalid, done once on migration
+		segment.last_epoch_ms = data.timestamp.epoch_ms;
+	segment.day = SampleTime::fromEpochMs(segment.first_epoch_ms).toDateTime().date();
+	segment.file_name = QString("weather_%1_single.%2").arg(segment.day.toString("yyyy-MM-dd"), segment.format == Cfg::LogFormat::Binary ? "bin" : "jsonl");
+	segment.size_bytes = QFileInfo(_log_file_path).size();
+	reader.close();
+
+	QDir().mkpath(_manifest->directory());
+	if (!QFile::rename(_log_file_path, QDir(_manifest->directory()).filePath(segment.file_name)))
+	{
+		qWarning() << "WeatherLogWriter: Failed to move the log file into the segment directory:" << _log_file_path;
+		return;
+	}
+
+	_manifest->addClosedSegment(segment);
+	qInfo() << "WeatherLogWriter: Moved the log file into the segment directory as" << segment.file_name;
+}
+
+// Starts a new segment, when the entry belongs to another day than the active segment
+void WeatherLogWriter::rotateSegment(const WeatherData& data)
+{
+	const QDate day = data.timestamp.toDateTime().date();
+	const WeatherLogSegment* active = _manifest->activeSegment();
+	if (active && active->day == day)
+	{
+		if (!_writer)
+			openWriter(_manifest->filePath(*active));
+		return;
+	}
+
+	if (active)
+		closeActiveSegment(_last_written_epoch_ms);
+
+	const WeatherLogSegment& segment = _manifest->openSegment(day, _log_format, data.timestamp.epoch_ms);
+	openWriter(_manifest->filePath(segment));
+
+	applyRetention();
+	_manifest->save();
+}
+
+void WeatherLogWriter::closeActiveSegment(qint64 last_epoch_ms)
+{
+	WeatherLogSegment* active = _manifest->activeSegment();
+	if (!active)
+		return;
+
+	if (_writer)
+	{
+		_writer->close();
+		_writer.reset();
+	}
+
+	_manifest->closeActiveSegment(last_epoch_ms, QFileInfo(_manifest->filePath(*active)).size());
+	if (_storage_cfg.compress_closed_segments)
+		compressSegment(*active);
+}
+
+void WeatherLogWriter::compressSegment(const WeatherLogSegment& segment)
+{
+	const QString file_name = segment.file_name;
+	const QString file_path = _manifest->filePath(segment);
+	_compression_pool.start([this, file_name, file_path]()
+		{
+			const qint64 size_bytes = compressFile(file_path);
+			if (size_bytes < 0)
+			{
+				qWarning() << "WeatherLogWriter: Failed to compress log segment:" << file_path;
+				return;
+			}
+			QMetaObject::invokeMethod(this, [this, file_name, size_bytes]() { onSegmentCompressed(file_name, size_bytes); }, Qt::QueuedConnection);
+		});
+}
+
+void WeatherLogWriter::onSegmentCompressed(const QString& file_name, qint64 size_bytes)
+{
+	if (!_manifest->findSegment(file_name))
+	{
+		// Removed by the retention policy meanwhile
+		QFile::remove(QDir(_manifest->directory()).filePath(file_name + WeatherLogManifest::COMPRESSED_SUFFIX));
+		return;
+	}
+
+	_manifest->markCompressed(file_name, size_bytes);
+	_manifest->save();
+}
+
+void WeatherLogWriter::applyRetention()
+{
+	for (const auto& segment : _manifest->expiredSegments(QDate::currentDate(), _storage_cfg))
+	{
+		const QString file_path = QDir(_manifest->directory()).filePath(segment.file_name);
+		QFile::remove(file_path);
+		QFile::remove(file_path + WeatherLogManifest::COMPRESSED_SUFFIX);
+		_manifest->removeSegment(segment.file_name);
+		qInfo() << "WeatherLogWriter: Removed log segment by retention policy:" << segment.file_name;
+	}
+}
+
+/*
+* Appending records of the configured format to a file in the other format would make it unreadable,
+* the existing file is renamed instead. It can be converted with WeatherDataLogger::convertLogFile().
+*/
+void WeatherLogWriter::moveAwayMismatchingLogFile(const QString& file_path)
+{
+	const auto existing_format = WeatherDataLogger::detectLogFormat(file_path);
+	if (!existing_format || *existing_format == _log_format)
+		return;
+
+	const QString suffix = *existing_format == Cfg::LogFormat::Binary ? "bin" : "jsonl";
+	const QString moved_path = QString("%1.%2.%3").arg(file_path, QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss"), suffix);
+	if (QFile::rename(file_path, moved_path))
+		qWarning() << "WeatherLogWriter: Log file has a different format than configured, moved it to:" << moved_path;
+	else
+		qWarning() << "WeatherLogWriter: Log file has a different format than configured, failed to move it:" << file_path;
+}
@@ -0,0 +1,101 @@
+#include "WeatherPacket.h"
+
+namespace WeatherPacket
+{
+
+namespace
+{
+// Returns -1 if the field contains a non-digit character
+int decodeDigits(const char* packet, const DigitField& field)
+{
+	int value = 0;
+	for (int i = 0; i < field.digit_count; ++i)
+	{
+		const unsigned int digit = static_cast<unsigned char>(packet[field.offsets[i]]) - '0';
+		if (digit > 9)
+			return -1;
+
+		value = value * 10 + static_cast<int>(digit);
+	}
+	return value;
+}
+}
+
+const char* packetStatusToString(PacketStatus status)
+{
+	switch (status)
+	{
+	case PacketStatus::Valid: return "Valid packet";
+	case PacketStatus::InvalidStart: return "Invalid start identifier in packet";
+	case PacketStatus::InvalidEnd: return "Invalid end identifier in packet";
+	case PacketStatus::InvalidChecksumDigit: return "Invalid checksum digit in packet";
+	case PacketStatus::ChecksumMismatch: return "Checksum mismatch in packet";
+	case PacketStatus::InvalidDigit: return "Invalid digit in packet";
+	default: return "Unknown packet status";
+	}
+}
+
+PacketStatus validate(const char* packet)
+{
+	const auto* bytes = reinterpret_cast<const unsigned char*>(packet);
+
+	if (bytes[0] != static_cast<unsigned char>(START_IDENTIFIER))
+		return PacketStatus::InvalidStart;
+
+	if (bytes[PACKET_LENGTH - 1] != END_IDENTIFIER)
+		return PacketStatus::InvalidEnd;
+
+	// Bytes [0, CHECKSUM_CALC_MAX_BYTE) are summed up, the following 4 bytes hold the checksum as ASCII digits
+	unsigned int calculated_checksum = 0;
+	for (int i = 0; i < CHECKSUM_CALC_MAX_BYTE; ++i)
+		calculated_checksum += bytes[i];
+
+	unsigned int received_checksum = 0;
+	for (int i = CHECKSUM_DIGIT1_OFFSET; i <= CHECKSUM_DIGIT4_OFFSET; ++i)
+	{
+		const unsigned int digit = bytes[i] - static_cast<unsigned int>('0');
+		if (digit > 9)
+			return PacketStatus::InvalidChecksumDigit;
+
+		received_checksum = received_checksum * 10 + digit;
+	}
+
+	return received_checksum == calculated_checksum ? PacketStatus::Valid : PacketStatus::ChecksumMismatch;
+}
+
+int validateBatch(const char* const* packets, int count, PacketStatus* results)
+{
+	int valid_count = 0;
+	for (int i = 0; i < count; ++i)
+	{
+		results[i] = validate(packets[i]);
+		if (results[i] == PacketStatus::Valid)
+			++valid_count;
+	}
+	return valid_count;
+}
+
+std::optional<DecodedPacket> decode(const char* packet)
+{
+	std::array<int, NumericFieldCount> values{};
+	for (int i = 0; i < NumericFieldCount; ++i)
+	{
+		values[i] = decodeDigits(packet, NUMERIC_FIELDS[i]);
+		if (values[i] < 0)
+			return {};
+	}
+
+	DecodedPacket decoded;
+	decoded.temperature_dc = static_cast<int16_t>(packet[TEMP_SIGN_OFFSET] == '-' ? -values[Temperature] : values[Temperature]);
+	decoded.sun_south = static_cast<uint8_t>(values[SunSouth]);
+	decoded.sun_west = static_cast<uint8_t>(values[SunWest]);
+	decoded.sun_east = static_cast<uint8_t>(values[SunEast]);
+	decoded.daylight = static_cast<uint16_t>(values[Daylight]);
+	decoded.wind_dms = static_cast<uint16_t>(values[Wind]);
+	decoded.twilight = packet[TWILIGHT_OFFSET] == FLAG_SET;
+	decoded.rain = packet[RAIN_OFFSET] == FLAG_SET;
+
+	return decoded;
+}
+
+}
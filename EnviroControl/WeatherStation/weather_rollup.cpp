@@ -0,0 +1,393 @@
+#include "WeatherRollup.h"
+
+#include <QtCore/QDateTime>
+#include <QtCore/QDebug>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QSaveFile>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+const qint64 MINUTE_MS = 60 * 1000;
+const qint64 HOUR_MS = 60 * MINUTE_MS;
+const QString STATE_FILE_NAME = "rollup_state.json";
+
+const std::array<QString, ROLLUP_RESOLUTION_COUNT> RESOLUTION_NAMES = { "minute", "hour", "day" };
+
+QString resolutionName(RollupResolution resolution)
+{
+	return RESOLUTION_NAMES[static_cast<size_t>(resolution)];
+}
+
+QString rollupFilePath(const QString& directory, RollupResolution resolution)
+{
+	return QDir(directory).filePath(QString("rollup_%1.jsonl").arg(resolutionName(resolution)));
+}
+
+qint64 floorTo(qint64 epoch_ms, qint64 step_ms)
+{
+	const qint64 remainder = epoch_ms % step_ms;
+	return remainder < 0 ? epoch_ms - remainder - step_ms : epoch_ms - remainder;
+}
+
+QJsonArray toJson(const RollupField& field)
+{
+	return QJsonArray{ field.min, field.max, field.sum, field.last };
+}
+
+RollupField fieldFromJson(const QJsonValue& value)
+{
+	const QJsonArray array = value.toArray();
+	RollupField field;
+	field.min = array.at(0).toDouble();
+	field.max = array.at(1).toDouble();
+	field.sum = array.at(2).toDouble();
+	field.last = array.at(3).toDouble();
+	return field;
+}
+
+const char START_KEY[] = "\"start\":";
+
+const char* findNewline(const char* pos, const char* end)
+{
+	const void* found = std::memchr(pos, '\n', static_cast<size_t>(end - pos));
+	return found ? static_cast<const char*>(found) : end;
+}
+
+const char* nextLineStart(const char* line, const char* end)
+{
+	const char* newline = findNewline(line, end);
+	return newline == end ? end : newline + 1;
+}
+
+// Bucket start of a rollup line, without parsing the whole object. Invalid lines sort before everything.
+qint64 lineBucketStart(const char* line, const char* end)
+{
+	const char* line_end = findNewline(line, end);
+	const char* pos = std::search(line, line_end, START_KEY, START_KEY + sizeof(START_KEY) - 1);
+	if (pos == line_end)
+		return std::numeric_limits<qint64>::min();
+
+	pos += sizeof(START_KEY) - 1;
+	const bool negative = pos < line_end && *pos == '-';
+	if (negative)
+		++pos;
+	if (pos == line_end || *pos < '0' || *pos > '9')
+		return std::numeric_limits<qint64>::min();
+
+	qint64 value = 0;
+	for (; pos < line_end && *pos >= '0' && *pos <= '9'; ++pos)
+		value = value * 10 + (*pos - '0');
+	return negative ? -value : value;
+}
+
+// First line with a bucket start >= epoch_ms, buckets are written in time order
+const char* lowerBound(const char* begin, const char* end, qint64 epoch_ms)
+{
+	const char* low = begin; // Always a line start
+	const char* high = end;
+	while (low < high)
+	{
+		const char* mid = low + (high - low) / 2;
+		if (mid > begin)
+		{
+			const char* newline = findNewline(mid - 1, end);
+			mid = newline == end ? end : newline + 1;
+		}
+		if (mid >= high)
+			mid = low; // No line starts between the middle and high, check the line at low
+
+		if (lineBucketStart(mid, end) < epoch_ms)
+			low = nextLineStart(mid, end);
+		else
+			high = mid;
+	}
+	return low;
+}
+
+// Start of the last bucket in a rollup file, read from its end only
+std::optional<qint64> lastWrittenStart(const QString& file_path)
+{
+	QFile file(file_path);
+	if (!file.open(QIODevice::ReadOnly) || file.size() == 0)
+		return {};
+
+	file.seek(std::max<qint64>(0, file.size() - 4096));
+	const QList<QByteArray> lines = file.readAll().split('\n');
+	for (auto it = lines.rbegin(); it != lines.rend(); ++it)
+	{
+		const QJsonDocument doc = QJsonDocument::fromJson(it->trimmed());
+		if (doc.isObject())
+			return RollupBucket::fromJson(doc.object()).start_epoch_ms;
+	}
+	return {};
+}
+}
+
+// === RollupBucket ===
+
+RollupBucket RollupBucket::forSample(RollupResolution resolution, qint64 epoch_ms)
+{
+	RollupBucket bucket;
+	switch (resolution)
+	{
+	case RollupResolution::Minute:
+		bucket.start_epoch_ms = floorTo(epoch_ms, MINUTE_MS);
+		bucket.end_epoch_ms = bucket.start_epoch_ms + MINUTE_MS;
+		break;
+	case RollupResolution::Hour:
+		bucket.start_epoch_ms = floorTo(epoch_ms, HOUR_MS);
+		bucket.end_epoch_ms = bucket.start_epoch_ms + HOUR_MS;
+		break;
+	case RollupResolution::Day:
+	{
+		// Local midnight to midnight, so days with a DST change have 23 or 25 hours
+		const QDate day = QDateTime::fromMSecsSinceEpoch(epoch_ms).date();
+		bucket.start_epoch_ms = day.startOfDay().toMSecsSinceEpoch();
+		bucket.end_epoch_ms = day.addDays(1).startOfDay().toMSecsSinceEpoch();
+		break;
+	}
+	}
+	return bucket;
+}
+
+void RollupBucket::add(const WeatherData& data)
+{
+	const bool first = count == 0;
+	temperature.add(data.temperature, first);
+	sun_south.add(data.sun_south, first);
+	sun_east.add(data.sun_east, first);
+	sun_west.add(data.sun_west, first);
+	daylight.add(data.daylight, first);
+	wind.add(data.wind, first);
+	twighlight_count += data.twighlight ? 1 : 0;
+	rain_count += data.rain ? 1 : 0;
+	last_epoch_ms = data.timestamp.epoch_ms;
+	++count;
+}
+
+WeatherData RollupBucket::average() const
+{
+	WeatherData data{};
+	data.temperature = temperature.avg(count);
+	data.sun_south = sun_south.avg(count);
+	data.sun_east = sun_east.avg(count);
+	data.sun_west = sun_west.avg(count);
+	data.daylight = daylight.avg(count);
+	data.wind = wind.avg(count);
+	data.twighlight = twighlight_count * 2 > count;
+	data.rain = rain_count > 0;
+	data.timestamp = SampleTime::fromEpochMs(last_epoch_ms);
+	return data;
+}
+
+QJsonObject RollupBucket::toJson() const
+{
+	// Fields as [min, max, sum, last]
+	QJsonObject obj;
+	obj["start"] = start_epoch_ms;
+	obj["end"] = end_epoch_ms;
+	obj["last_ms"] = last_epoch_ms;
+	obj["count"] = count;
+	obj["temperature"] = ::toJson(temperature);
+	obj["sun_south"] = ::toJson(sun_south);
+	obj["sun_east"] = ::toJson(sun_east);
+	obj["sun_west"] = ::toJson(sun_west);
+	obj["daylight"] = ::toJson(daylight);
+	obj["wind"] = ::toJson(wind);
+	obj["twighlight_count"] = twighlight_count;
+	obj["rain_count"] = rain_count;
+	return obj;
+}
+
+RollupBucket RollupBucket::fromJson(const QJsonObject& obj)
+{
+	RollupBucket bucket;
+	bucket.start_epoch_ms = obj["start"].toInteger();
+	bucket.end_epoch_ms = obj["end"].toInteger();
+	bucket.last_epoch_ms = obj["last_ms"].toInteger();
+	bucket.count = obj["count"].toInt();
+	bucket.temperature = fieldFromJson(obj["temperature"]);
+	bucket.sun_south = fieldFromJson(obj["sun_south"]);
+	bucket.sun_east = fieldFromJson(obj["sun_east"]);
+	bucket.sun_west = fieldFromJson(obj["sun_west"]);
+	bucket.daylight = fieldFromJson(obj["daylight"]);
+	bucket.wind = fieldFromJson(obj["wind"]);
+	bucket.twighlight_count = obj["twighlight_count"].toInt();
+	bucket.rain_count = obj["rain_count"].toInt();
+	return bucket;
+}
+
+// === WeatherRollups ===
+
+std::vector<WeatherRollups::CompletedBucket> WeatherRollups::add(const WeatherData& data)
+{
+	std::vector<CompletedBucket> completed;
+	const qint64 epoch_ms = data.timestamp.epoch_ms;
+
+	for (size_t i = 0; i < ROLLUP_RESOLUTION_COUNT; ++i)
+	{
+		auto& partial = _partial[i];
+		if (partial && epoch_ms < partial->start_epoch_ms)
+			continue; // Late sample, its bucket is already written
+
+		if (partial && !partial->contains(epoch_ms))
+		{
+			completed.push_back({ static_cast<RollupResolution>(i), *partial });
+			partial.reset();
+		}
+
+		if (!partial)
+			partial = RollupBucket::forSample(static_cast<RollupResolution>(i), epoch_ms);
+
+		partial->add(data);
+	}
+	return completed;
+}
+
+const std::optional<RollupBucket>& WeatherRollups::partial(RollupResolution resolution) const
+{
+	return _partial[static_cast<size_t>(resolution)];
+}
+
+void WeatherRollups::restorePartial(RollupResolution resolution, const RollupBucket& bucket)
+{
+	_partial[static_cast<size_t>(resolution)] = bucket;
+}
+
+// === WeatherRollupStore ===
+
+WeatherRollupStore::WeatherRollupStore(const QString& log_file_path, const Cfg::LogWriterConfig& cfg) :
+	_directory(rollupDirectory(log_file_path))
+{
+	if (!QDir().mkpath(_directory))
+		qWarning() << "WeatherRollupStore: Failed to create rollup directory:" << _directory;
+
+	for (size_t i = 0; i < ROLLUP_RESOLUTION_COUNT; ++i)
+		_writers[i] = std::make_unique<BufferedLogWriter>(rollupFilePath(_directory, static_cast<RollupResolution>(i)), cfg);
+
+	restoreState();
+}
+
+WeatherRollupStore::~WeatherRollupStore()
+{
+	flush();
+}
+
+void WeatherRollupStore::add(const WeatherData& data)
+{
+	for (const auto& completed : _rollups.add(data))
+	{
+		const QByteArray entry = QJsonDocument(completed.bucket.toJson()).toJson(QJsonDocument::Compact);
+		_writers[static_cast<size_t>(completed.resolution)]->append(entry);
+	}
+}
+
+// The buckets first: a crash in between leaves an outdated partial bucket, which restoreState() detects
+void WeatherRollupStore::flush()
+{
+	for (auto& writer : _writers)
+		writer->flush();
+	saveState();
+}
+
+QString WeatherRollupStore::rollupDirectory(const QString& log_file_path)
+{
+	const QFileInfo log_file_info(log_file_path);
+	return QDir(log_file_info.absolutePath()).filePath(log_file_info.completeBaseName() + "_rollups");
+}
+
+std::vector<RollupBucket> WeatherRollupStore::query(const QString& log_file_path, RollupResolution resolution, qint64 from_epoch_ms, qint64 to_epoch_ms)
+{
+	std::vector<RollupBucket> buckets;
+	const QString directory = rollupDirectory(log_file_path);
+
+	// Mapped and searched by time, only the lines in range are parsed
+	QFile file(rollupFilePath(directory, resolution));
+	uchar* mapped = file.open(QIODevice::ReadOnly) && file.size() > 0 ? file.map(0, file.size()) : nullptr;
+	if (mapped)
+	{
+		const char* begin = reinterpret_cast<const char*>(mapped);
+		const char* end = begin + file.size();
+		for (const char* line = lowerBound(begin, end, from_epoch_ms); line < end; line = nextLineStart(line, end))
+		{
+			const char* line_end = findNewline(line, end);
+			const QJsonDocument doc = QJsonDocument::fromJson(QByteArray::fromRawData(line, static_cast<qsizetype>(line_end - line)));
+			if (!doc.isObject())
+				continue;
+
+			const RollupBucket bucket = RollupBucket::fromJson(doc.object());
+			if (bucket.start_epoch_ms >= to_epoch_ms)
+				break; // Written in time order
+			if (bucket.start_epoch_ms >= from_epoch_ms)
+				buckets.push_back(bucket);
+		}
+		file.unmap(mapped);
+	}
+
+	QFile state_file(QDir(directory).filePath(STATE_FILE_NAME));
+	if (state_file.open(QIODevice::ReadOnly))
+	{
+		const QJsonObject partial = QJsonDocument::fromJson(state_file.readAll()).object()[resolutionName(resolution)].toObject();
+		if (!partial.isEmpty())
+		{
+			const RollupBucket bucket = RollupBucket::fromJson(partial);
+			const bool newer = buckets.empty() || bucket.start_epoch_ms > buckets.back().start_epoch_ms;
+			if (newer && bucket.start_epoch_ms >= from_epoch_ms && bucket.start_epoch_ms < to_epoch_ms)
+				buckets.push_back(bucket);
+		}
+	}
+	return buckets;
+}
+
+void WeatherRollupStore::restoreState()
+{
+	QFile file(QDir(_directory).filePath(STATE_FILE_NAME));
+	if (!file.open(QIODevice::ReadOnly))
+		return;
+
+	const QJsonObject state = QJsonDocument::fromJson(file.readAll()).object();
+	for (size_t i = 0; i < ROLLUP_RESOLUTION_COUNT; ++i)
+	{
+		const auto resolution = static_cast<RollupResolution>(i);
+		const QJsonObject partial = state[resolutionName(resolution)].toObject();
+		if (partial.isEmpty())
+			continue;
+
+		// Already completed and written, but the state was not saved anymore
+		const RollupBucket bucket = RollupBucket::fromJson(partial);
+		const auto last_written = lastWrittenStart(rollupFilePath(_directory, resolution));
+		if (last_written && *last_written >= bucket.start_epoch_ms)
+			continue;
+
+		_rollups.restorePartial(resolution, bucket);
+	}
+}
+
+void WeatherRollupStore::saveState() const
+{
+	QJsonObject state;
+	for (size_t i = 0; i < ROLLUP_RESOLUTION_COUNT; ++i)
+	{
+		const auto resolution = static_cast<RollupResolution>(i);
+		if (const auto& partial = _rollups.partial(resolution))
+			state[resolutionName(resolution)] = partial->toJson();
+	}
+
+	QSaveFile file(QDir(_directory).filePath(STATE_FILE_NAME));
+	if (!file.open(QIODevice::WriteOnly))
+	{
+		qWarning() << "WeatherRollupStore: Failed to write rollup state:" << file.fileName() << file.errorString();
+		return;
+	}
+
+	file.write(QJsonDocument(state).toJson(QJsonDocument::Compact));
+	file.commit();
+}
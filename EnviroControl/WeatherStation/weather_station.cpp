@@ -2,49 +2,16 @@
 #include "Logging.h"
 
 #include "ConfigParser.h"
+#include "WeatherPacket.h"
 
-#include <QtCore/QTimeZone>
+// Capacity of the serial read ring buffer, large enough for a burst of ~100 packets
+const size_t READ_BUFFER_CAPACITY = 4096;
 
-const int PACKET_LENGHT = 40;
-const char START_IDENTIFIER = 'W'; // Start of Weather Data 
-const unsigned char END_IDENTIFIER = 0x03; // End identifier 0x03 
-
-// Byte offsets for various data fields within the 40-byte packet 
-const int TEMP_SIGN_OFFSET = 1;
-const int TEMP_DIGIT1_OFFSET = 2;
-const int TEMP_DIGIT2_OFFSET = 3;
-const int TEMP_DECIMAL_OFFSET = 4; // This is where the decimal point is implied, not a character
-const int TEMP_DIGIT3_OFFSET = 5;
-
-const int SUN_SOUTH_DIGIT1_OFFSET = 6;
-const int SUN_SOUTH_DIGIT2_OFFSET = 7;
-const int SUN_WEST_DIGIT1_OFFSET = 8;
-const int SUN_WEST_DIGIT2_OFFSET = 9;
-const int SUN_EAST_DIGIT1_OFFSET = 10;
-const int SUN_EAST_DIGIT2_OFFSET = 11;
-
-const int TWILIGHT_OFFSET = 12;
-
-const int DAYLIGHT_DIGIT1_OFFSET = 13;
-const int DAYLIGHT_DIGIT2_OFFSET = 14;
-const int DAYLIGHT_DIGIT3_OFFSET = 15;
-
-const int WIND_DIGIT1_OFFSET = 16;
-const int WIND_DIGIT2_OFFSET = 17;
-const int WIND_DECIMAL_OFFSET = 18; // Implied decimal point
-const int WIND_DIGIT3_OFFSET = 19;
-
-const int RAIN_OFFSET = 20;
-
-// Checksum offsets 
-const int CHECKSUM_DIGIT1_OFFSET = 35; // Thousands digit
-const int CHECKSUM_DIGIT2_OFFSET = 36; // Hundreds digit
-const int CHECKSUM_DIGIT3_OFFSET = 37; // Tens digit
-const int CHECKSUM_DIGIT4_OFFSET = 38; // Units digit
-const int CHECKSUM_CALC_MAX_BYTE = 35; // Checksum is calculated up to byte 35 
+// Maximum number of packets validated in one batch
+const int MAX_PACKET_BATCH = 32;
 
 WeatherStation::WeatherStation(const Cfg::WeatherStationConfig& cfg, QObject* parent) :
-	IWeatherStation(cfg, parent)
+	IWeatherStation(cfg, parent), _frame_buffer(READ_BUFFER_CAPACITY, WeatherPacket::PACKET_LENGTH, WeatherPacket::START_IDENTIFIER, WeatherPacket::END_IDENTIFIER)
 {
 }
 
@@ -104,146 +71,90 @@ void WeatherStation::initSerialPort()
 
 void WeatherStation::handleReadyRead()
 {
-	_read_buffer.append(_port->readAll());
+	const size_t discarded_before = _frame_buffer.discardedBytes();
 
-	// Loop to process all complete packets found in the buffer
-	while (true)
+	// Read directly into the ring buffer, process all complete packets after each chunk.
+	// Packets point into the ring buffer, so they must be processed before the next read.
+	while (_port->bytesAvailable() > 0)
 	{
-		// 1. Find the start of a potential packet ('W')
-		int start_index = _read_buffer.indexOf(START_IDENTIFIER);
+		const qint64 bytes_read = _port->read(_frame_buffer.writePtr(), static_cast<qint64>(_frame_buffer.writableSize()));
+		if (bytes_read <= 0)
+			break;
 
-		// 2. If the START_IDENTIFIER is not found at all:
-		//    Clear the buffer if it's getting too large with junk data to prevent memory issues.
-		if (start_index == -1)
-		{
-			if (_read_buffer.size() > (PACKET_LENGHT * 2)) // Example: clear if buffer is twice the packet length and no start found
-			{
-				qWarning() << "WeatherStation: Start identifier not found in buffer. Discarding old data to prevent overflow.";
-				_read_buffer.clear();
-			}
-			break; // No packet start found, wait for more data
-		}
+		_frame_buffer.commitWrite(static_cast<size_t>(bytes_read));
 
-		// 3. If the START_IDENTIFIER is found, but there's leading junk:
-		//    Discard the junk bytes before the actual start of the packet.
-		if (start_index > 0)
-		{
-			qDebug() << "WeatherStation: Discarding " << start_index << " leading junk bytes before packet start.";
-			_read_buffer.remove(0, start_index);
-			// After this, 'W' is now at index 0 of _read_buffer
-		}
-
-		// 4. Now that 'W' is at index 0, check if there's enough data for a full packet.
-		if (_read_buffer.size() < PACKET_LENGHT)
-		{
-			break; // Not enough data for a full packet yet, wait for more
-		}
-
-		// 5. Extract the complete, properly aligned packet.
-		//    Since 'W' is at index 0, take exactly PACKET_LENGHT bytes from the beginning.
-		QByteArray current_packet = _read_buffer.left(PACKET_LENGHT);
+		// Collect all complete packets found in the buffer and validate them as one batch.
+		// Leading junk and false start identifiers are skipped by the frame buffer itself.
+		std::array<const char*, MAX_PACKET_BATCH> packets;
+		std::array<WeatherPacket::PacketStatus, MAX_PACKET_BATCH> statuses;
+		int packet_count = 0;
 
-		// 6. Remove the processed packet from the buffer.
-		_read_buffer.remove(0, PACKET_LENGHT);
-
-		// 7. Attempt to parse the packet
-		if (auto weather_data = parseWeatherData(current_packet))
-		{
-			Q_EMIT weatherDataReady(weather_data.value());
-			//qDebug() << "WeatherStation: Successfully parsed weather data from packet: " << current_packet.toHex();
-			// Packet successfully parsed, continue loop to check for next packet in buffer
-		}
-		else
+		auto process_batch = [&]()
+			{
+				WeatherPacket::validateBatch(packets.data(), packet_count, statuses.data());
+				for (int i = 0; i < packet_count; ++i)
+				{
+					if (statuses[i] != WeatherPacket::PacketStatus::Valid)
+					{
+						// The packet is already consumed, continue with the next one in case of a corrupted packet
+						rejectPacket(packets[i], statuses[i]);
+						continue;
+					}
+
+					if (auto weather_data = parseWeatherData(packets[i]))
+						publishWeatherData(weather_data.value());
+				}
+				packet_count = 0;
+			};
+
+		for (auto packet = _frame_buffer.nextFrame(); !packet.empty(); packet = _frame_buffer.nextFrame())
 		{
-			// Parsing failed (e.g., checksum mismatch, or internal error in parseWeatherData).
-			// The problematic packet has already been removed.
-			qWarning() << "WeatherStation: Failed to parse weather data from packet: " << current_packet.toHex();
-			// Do NOT break here, continue the loop to try and find the next valid packet in case of a corrupted one.
+			packets[packet_count++] = packet.data();
+			if (packet_count == MAX_PACKET_BATCH)
+				process_batch();
 		}
+		process_batch();
 	}
+
+	if (const size_t discarded = _frame_buffer.discardedBytes() - discarded_before)
+		qDebug() << "WeatherStation: Discarded " << discarded << " junk bytes while searching for packet start.";
 }
 
-std::optional<WeatherData> WeatherStation::parseWeatherData(QByteArray data)
+/*
+* Expects a packet, that already passed WeatherPacket::validate()
+*/
+std::optional<WeatherData> WeatherStation::parseWeatherData(const char* packet)
 {
-	if (data.size() < PACKET_LENGHT)
+	// Digits are decoded directly into fixed-point values
+	const auto decoded = WeatherPacket::decode(packet);
+	if (!decoded)
 	{
-		qWarning() << "WeatherStation: Data packet too short: " << data.size();
-		Q_EMIT errorOccurred("Data packet too short");
-		return {};
-	}
-
-	// Verify start & end signatures
-	if (data.at(0) != START_IDENTIFIER)
-	{
-		qWarning() << "Invalid start identifier in packet.";
-		Q_EMIT errorOccurred("Invalid start identifier in packet");
-		return {};
-	}
-
-	if (static_cast<unsigned char>(data.at(PACKET_LENGHT - 1)) != END_IDENTIFIER)
-	{
-		qWarning() << "Invalid end identifier in packet.";
-		Q_EMIT errorOccurred("Invalid end identifier in packet");
-		return {};
-	}
-
-	if (!compareChecksum(data))
-	{
-		qWarning() << "Checksum mismatch in packet: " << data;
-		Q_EMIT errorOccurred("Checksum mismatch in packet");
+		rejectPacket(packet, WeatherPacket::PacketStatus::InvalidDigit);
 		return {};
 	}
 
 	WeatherData weather_data;
-
-	// Temperature parsing
-	QString temp_sign = (data.at(TEMP_SIGN_OFFSET) == '-') ? "-" : "";
-	QString temp_str = temp_sign + QString(data.at(TEMP_DIGIT1_OFFSET)) +
-		QString(data.at(TEMP_DIGIT2_OFFSET)) +
-		QString(data.at(TEMP_DECIMAL_OFFSET)) + // This is the '.' character
-		QString(data.at(TEMP_DIGIT3_OFFSET));
-	weather_data.temperature = temp_str.toDouble();
-
-	// Sun intensity parsing
-	weather_data.sun_south = (QString(data.at(SUN_SOUTH_DIGIT1_OFFSET)) + QString(data.at(SUN_SOUTH_DIGIT2_OFFSET))).toDouble();
-	weather_data.sun_west = (QString(data.at(SUN_WEST_DIGIT1_OFFSET)) + QString(data.at(SUN_WEST_DIGIT2_OFFSET))).toDouble();
-	weather_data.sun_east = (QString(data.at(SUN_EAST_DIGIT1_OFFSET)) + QString(data.at(SUN_EAST_DIGIT2_OFFSET))).toDouble();
-
-	// Twiglight parsing
-	weather_data.twighlight = (data.at(TWILIGHT_OFFSET) == 'J');
-
-	// Daylight parsing
-	weather_data.daylight = (QString(data.at(DAYLIGHT_DIGIT1_OFFSET)).toInt() * 100) +
-		(QString(data.at(DAYLIGHT_DIGIT2_OFFSET)).toInt() * 10) +
-		QString(data.at(DAYLIGHT_DIGIT3_OFFSET)).toInt();
-
-	// Wind parsing
-	QString wind_str = QString(data.at(WIND_DIGIT1_OFFSET)) +
-		QString(data.at(WIND_DIGIT2_OFFSET)) +
-		"." + QString(data.at(WIND_DIGIT3_OFFSET));
-	weather_data.wind = wind_str.toDouble();
-
-	// Rain parsing
-	weather_data.rain = (data.at(RAIN_OFFSET) == 'J');
+	weather_data.temperature = decoded->temperature_dc / 10.0;
+	weather_data.sun_south = decoded->sun_south;
+	weather_data.sun_west = decoded->sun_west;
+	weather_data.sun_east = decoded->sun_east;
+	weather_data.twighlight = decoded->twilight;
+	weather_data.daylight = decoded->daylight;
+	weather_data.wind = decoded->wind_dms / 10.0;
+	weather_data.rain = decoded->rain;
 
 	// Add current timestamp
-	weather_data.timestamp = QDateTime::currentDateTime();
+	weather_data.timestamp = SampleTime::now();
 
 	return weather_data;
 }
 
-bool WeatherStation::compareChecksum(const QByteArray& data) const
+void WeatherStation::rejectPacket(const char* packet, WeatherPacket::PacketStatus status)
 {
-	unsigned int received_checksum = (data.mid(CHECKSUM_DIGIT1_OFFSET, 1).toInt() * 1000) +
-		(data.mid(CHECKSUM_DIGIT2_OFFSET, 1).toInt() * 100) +
-		(data.mid(CHECKSUM_DIGIT3_OFFSET, 1).toInt() * 10) +
-		(data.mid(CHECKSUM_DIGIT4_OFFSET, 1).toInt());
-
-	unsigned int calculated_checksum = 0;
-	for (int i = 0; i < CHECKSUM_CALC_MAX_BYTE; ++i)
-	{
-		calculated_checksum += static_cast<unsigned char>(data.at(i));
-	}
+	const QString reason = WeatherPacket::packetStatusToString(status);
+	qWarning() << "WeatherStation: Failed to parse weather data from packet (" << reason << "): "
+		<< QByteArray::fromRawData(packet, WeatherPacket::PACKET_LENGTH).toHex();
 
-	return received_checksum == calculated_checksum;
+	Q_EMIT packetRejected(status);
+	Q_EMIT errorOccurred(reason);
 }
@@ -1,11 +1,17 @@
 #include "WeatherStation.h"
 
+// How often the delta filter statistics are logged, if the filter is enabled
+static const qint64 DELTA_FILTER_REPORT_INTERVAL_MS = 3600 * 1000;
+
 IWeatherStation::IWeatherStation(const Cfg::WeatherStationConfig& cfg, QObject* parent)
-	: QObject(parent), _cfg(cfg), _data_logger(cfg.log_file_path, cfg.log_frequency_sec, this)
+	: QObject(parent), _cfg(cfg), _data_logger(cfg, this),
+	_delta_filter(cfg.delta_filter_cfg)
 {
 	connect(this, &IWeatherStation::weatherDataReady, &_data_logger, &WeatherDataLogger::onWeatherDataReady);
+	connect(this, &IWeatherStation::rawWeatherDataReady, &_data_logger, &WeatherDataLogger::onRawWeatherData);
 
-	connect(this, &IWeatherStation::weatherDataReady, [this](const WeatherData& data)
+	// Suppressed samples still prove, that the station is alive
+	connect(this, &IWeatherStation::rawWeatherDataReady, [this](const WeatherData& data)
 		{
 			if (_watchdog)
 				_watchdog->start(); // Restart the watchdog timer on new data
@@ -38,4 +44,51 @@ void IWeatherStation::initWatchdog()
 			stopReading();
 
 		});
+}
+
+void IWeatherStation::setSampleChannel(std::shared_ptr<SampleChannel<WeatherData>> channel)
+{
+	_sample_channel = std::move(channel);
+}
+
+/*
+* Every sample is emitted with rawWeatherDataReady and published to the sample channel, marked as changed or not.
+* Samples passing the delta filter are also emitted with weatherDataReady.
+*/
+void IWeatherStation::publishWeatherData(const WeatherData& data)
+{
+	Q_EMIT rawWeatherDataReady(data);
+
+	const bool changed = _delta_filter.accept(data);
+	if (changed)
+		Q_EMIT weatherDataReady(data);
+
+	if (_sample_channel)
+		_sample_channel->publish(data, changed);
+
+	if (_cfg.delta_filter_cfg.enabled)
+		reportDeltaFilterStatistics();
+}
+
+// Logs the forwarded and suppressed samples since the last report, once per DELTA_FILTER_REPORT_INTERVAL_MS
+void IWeatherStation::reportDeltaFilterStatistics()
+{
+	if (!_delta_filter_report_timer.isValid())
+	{
+		_delta_filter_report_timer.start();
+		return;
+	}
+
+	if (_delta_filter_report_timer.elapsed() < DELTA_FILTER_REPORT_INTERVAL_MS)
+		return;
+
+	const uint64_t forwarded = _delta_filter.forwardedCount() - _reported_forwarded_count;
+	const uint64_t suppressed = _delta_filter.suppressedCount() - _reported_suppressed_count;
+	const uint64_t total = forwarded + suppressed;
+	qInfo() << "(WeatherStation): Delta filter forwarded" << forwarded << "and suppressed" << suppressed << "samples in the last"
+		<< _delta_filter_report_timer.elapsed() / 60000 << "minutes (" << (total > 0 ? suppressed * 100 / total : 0) << "% suppressed)";
+
+	_reported_forwarded_count = _delta_filter.forwardedCount();
+	_reported_suppressed_count = _delta_filter.suppressedCount();
+	_delta_filter_report_timer.start();
 }
\ No newline at end of file
@@ -1,10 +1,16 @@
 #include "WeatherStationMock.h"
 
 #include <QtCore/QFileInfo>
+#include <QtCore/QFileSystemWatcher>
 #include <QtCore/QDir>
 
+#include <algorithm>
+
 namespace
 {
+// Gaps in a replayed log (e.g. the station was offline) are shortened to this
+const qint64 MAX_REPLAY_GAP_MS = 60 * 1000;
+
 QString getMockFilePath(const Cfg::WeatherStationConfig& cfg)
 {
   QFileInfo originalFileInfo(cfg.log_file_path);
@@ -16,7 +22,8 @@ QString getMockFilePath(const Cfg::WeatherStationConfig& cfg)
 }
 
 WeatherStationMock::WeatherStationMock(const Cfg::WeatherStationConfig& cfg, QObject* parent)
-	: IWeatherStation(cfg, parent), _mock_file_path(getMockFilePath(cfg))
+	: IWeatherStation(cfg, parent), _mock_cfg(cfg.mock_cfg),
+	_mock_file_path(cfg.mock_cfg.replay_file.isEmpty() ? getMockFilePath(cfg) : cfg.mock_cfg.replay_file)
 {
 }
 
@@ -32,21 +39,17 @@ void WeatherStationMock::startReading()
   if (!_read_timer)
   {
     _read_timer = new QTimer(this); // Parent the timer to this WeatherStationMock object
-    connect(_read_timer, &QTimer::timeout, this, &WeatherStationMock::readAndEmitLatestMockData);
-    qDebug() << "WeatherStationMock: QTimer created and connected.";
+    qDebug() << "WeatherStationMock: QTimer created.";
   }
 
-  // 2. Start the timer
+  // 2. Start following or replaying
   if (!_read_timer->isActive())
   {
-    int interval_ms = 5000;
-
-    _read_timer->start(interval_ms);
-    qInfo() << QString("WeatherStationMock: Started polling mock data file %1 with interval %2 ms.").arg(_mock_file_path).arg(interval_ms);
+    if (_mock_cfg.replay_file.isEmpty())
+      startFollowing();
+    else
+      startReplay();
   }
-
-  // Emit the first data point immediately upon starting
-  readAndEmitLatestMockData();
 }
 
 void WeatherStationMock::stopReading()
@@ -54,27 +57,132 @@ void WeatherStationMock::stopReading()
   if (_read_timer && _read_timer->isActive())
   {
     _read_timer->stop();
-    qDebug() << "WeatherStationMock: Stopped polling mock data.";
+    qDebug() << "WeatherStationMock: Stopped emitting mock data.";
+  }
+
+  if (_file_watcher)
+  {
+    delete _file_watcher;
+    _file_watcher = nullptr;
+  }
+}
+
+void WeatherStationMock::startFollowing()
+{
+  _read_timer->disconnect(this);
+  _read_timer->setSingleShot(false);
+  connect(_read_timer, &QTimer::timeout, this, &WeatherStationMock::emitLatestMockData);
+  _read_timer->start(_mock_cfg.repeat_interval_sec * 1000);
+
+  watchMockFile();
+  qInfo() << QString("WeatherStationMock: Following mock data file %1, repeating the latest entry every %2 s.")
+    .arg(_mock_file_path).arg(_mock_cfg.repeat_interval_sec);
+
+  // Emit the first data point immediately upon starting
+  onMockFileChanged();
+}
+
+/*
+* The directory is watched as well: editors and copy tools often replace the file, which removes it from the
+* watcher, and the file may not exist yet.
+*/
+void WeatherStationMock::watchMockFile()
+{
+  if (!_file_watcher)
+  {
+    _file_watcher = new QFileSystemWatcher(this);
+    connect(_file_watcher, &QFileSystemWatcher::fileChanged, this, &WeatherStationMock::onMockFileChanged);
+    connect(_file_watcher, &QFileSystemWatcher::directoryChanged, this, &WeatherStationMock::onMockFileChanged);
+    _file_watcher->addPath(QFileInfo(_mock_file_path).absolutePath());
   }
+
+  if (QFileInfo::exists(_mock_file_path) && !_file_watcher->files().contains(_mock_file_path))
+    _file_watcher->addPath(_mock_file_path);
 }
 
-void WeatherStationMock::readAndEmitLatestMockData()
+void WeatherStationMock::onMockFileChanged()
 {
-  std::vector<WeatherData> weather_data_list = WeatherDataLogger::parseWeatherDataFromFile(_mock_file_path);
+  watchMockFile();
 
-  if (weather_data_list.empty())
+  // Opened again on every change, in case the file was replaced. Only the newest entry is decoded.
+  const WeatherLogView latest = _mock_file_reader.open(_mock_file_path) ? _mock_file_reader.latest(1) : WeatherLogView();
+  if (latest.empty())
   {
     qWarning() << "WeatherStationMock: Mock data file is empty or unreadable:" << _mock_file_path;
     Q_EMIT errorOccurred(QString("Mock data file empty or unreadable: %1").arg(_mock_file_path));
-    // No need to stop timer here, continue polling in case file becomes available/populated
+    // Keep watching in case the file becomes available/populated
     return;
   }
 
-  // Get the last element (most recent data entry)
-  WeatherData latest_data = weather_data_list.back();
+  const WeatherData latest_data = *latest.begin();
+  _mock_file_reader.close();
+
+  // A directory change of another file does not change the mock data
+  if (_latest_data && _latest_data->timestamp.epoch_ms == latest_data.timestamp.epoch_ms)
+    return;
+
+  _latest_data = latest_data;
+  emitLatestMockData();
+}
+
+void WeatherStationMock::emitLatestMockData()
+{
+  if (!_latest_data)
+    return;
 
   // Update timestamp to current time for realism, even if the file has an older timestamp
-  latest_data.timestamp = QDateTime::currentDateTime();
+  WeatherData data = *_latest_data;
+  data.timestamp = SampleTime::now();
+
+  publishWeatherData(data);
+}
+
+void WeatherStationMock::startReplay()
+{
+  if (!_mock_file_reader.open(_mock_file_path) || _mock_file_reader.all().empty())
+  {
+    qWarning() << "WeatherStationMock: Replay file is empty or unreadable:" << _mock_file_path;
+    Q_EMIT errorOccurred(QString("Replay file empty or unreadable: %1").arg(_mock_file_path));
+    return;
+  }
+
+  _replay_view = _mock_file_reader.all();
+  _replay_pos = _replay_view.begin();
+
+  _read_timer->disconnect(this);
+  _read_timer->setSingleShot(true);
+  connect(_read_timer, &QTimer::timeout, this, &WeatherStationMock::emitNextReplayData);
 
-  Q_EMIT weatherDataReady(latest_data);
-}
\ No newline at end of file
+  qInfo() << QString("WeatherStationMock: Replaying %1 at %2x speed.").arg(_mock_file_path).arg(_mock_cfg.replay_speed);
+  emitNextReplayData();
+}
+
+void WeatherStationMock::emitNextReplayData()
+{
+  if (_replay_pos == _replay_view.end())
+  {
+    if (!_mock_cfg.replay_loop)
+    {
+      qInfo() << "WeatherStationMock: Replay finished:" << _mock_file_path;
+      return;
+    }
+    _replay_pos = _replay_view.begin();
+  }
+
+  WeatherData data = *_replay_pos;
+  const qint64 recorded_epoch_ms = data.timestamp.epoch_ms;
+  data.timestamp = SampleTime::now();
+  publishWeatherData(data);
+
+  if (++_replay_pos == _replay_view.end() && !_mock_cfg.replay_loop)
+  {
+    qInfo() << "WeatherStationMock: Replay finished:" << _mock_file_path;
+    return;
+  }
+
+  // Wait the recorded gap to the next entry, when looping the first entry follows after the repeat interval
+  const qint64 gap_ms = _replay_pos == _replay_view.end() ? _mock_cfg.repeat_interval_sec * 1000LL
+    : (*_replay_pos).timestamp.epoch_ms - recorded_epoch_ms;
+  const qint64 delay_ms = std::clamp<qint64>(gap_ms, 0, MAX_REPLAY_GAP_MS) / _mock_cfg.replay_speed;
+  _read_timer->start(static_cast<int>(delay_ms));
+}
@@ -23,6 +23,24 @@ void WeatherStationWidget::onWeatherData(const WeatherData& data)
 	updateDisplay(data);
 }
 
+void WeatherStationWidget::setSampleReader(std::shared_ptr<SampleChannel<WeatherData>::Reader> reader)
+{
+	_sample_reader = std::move(reader);
+}
+
+// Only the latest of the pending samples is displayed
+void WeatherStationWidget::onSamplesAvailable()
+{
+	if (!_sample_reader)
+		return;
+
+	std::optional<WeatherData> latest;
+	_sample_reader->drain([&latest](const WeatherData& data) { latest = data; });
+
+	if (latest)
+		updateDisplay(*latest);
+}
+
 void WeatherStationWidget::initLayout()
 {
 	auto layout = new QHBoxLayout(this);
@@ -11,7 +11,7 @@
 #include <QtCharts/QAreaSeries>
 #include <QtCore/QElapsedTimer>
 
-WindRainChartWidget::WindRainChartWidget(std::shared_ptr<std::vector<WeatherData>> weather_history, QWidget* parent)
+WindRainChartWidget::WindRainChartWidget(std::shared_ptr<TimeRingBuffer<PackedWeatherSample>> weather_history, QWidget* parent)
 	: WeatherHistoryWidgetBase(weather_history, parent),
 	_wind_series(new QLineSeries())
 {
@@ -88,13 +88,14 @@ void WindRainChartWidget::updateCharts()
 	_rain_upper_series->clear();
 	_rain_lower_series->clear();
 
-	for (const auto& data : *_weather_history)
+	for (const auto& sample : *_weather_history)
 	{
+		const WeatherData data = sample.unpack();
 		// Add wind data
-		_wind_series->append(data.timestamp.toMSecsSinceEpoch(), data.wind);
+		_wind_series->append(data.timestamp.epoch_ms, data.wind);
 		// Add rain data
-		_rain_lower_series->append(data.timestamp.toMSecsSinceEpoch(), 0);
-		_rain_upper_series->append(data.timestamp.toMSecsSinceEpoch(), data.rain ? 1 : 0);
+		_rain_lower_series->append(data.timestamp.epoch_ms, 0);
+		_rain_upper_series->append(data.timestamp.epoch_ms, data.rain ? 1 : 0);
 	}
 
 	adjustXAxisRange();
@@ -3,6 +3,7 @@
 #include "ErrorDetail.h"
 #include "Logging.h"
 #include "DeviceStateManager.h"
+#include "WeatherData.h"
 
 #include <QtWidgets/QApplication>
 #include <QtCore/QMetaType>
@@ -18,6 +19,7 @@ int main(int argc, char* argv[])
 
 	qRegisterMetaType<Device::DeviceState>();
 	qRegisterMetaType<Device::DeviceStates>();
+	qRegisterMetaType<WeatherDataBatch>();
 
 	auto cfg = Cfg::ConfigParser::parseConfigFile();
 	if (!cfg)